@@ -0,0 +1,259 @@
+/*
+ * batch.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "batch.h"
+#include "hand_detector.h"
+#include "benchmarks.h"
+#include "hue_kernel.h"
+
+#include "highgui.h"
+
+#include <cstdio>
+#include <string>
+
+//******* unix/linux only for threads
+#include <pthread.h>
+#include <unistd.h>
+
+using namespace std;
+
+// a run of frames from one file, num_frames -1 means to the end of the file
+struct BatchJob {
+	int file;
+	int first_frame;
+	int num_frames;
+};
+
+// shared between the workers, everything below jobs is guarded by lock
+struct BatchState {
+	const BatchOptions *opts;
+	const Histogram *hist;
+	vector<BatchJob> jobs;
+
+	pthread_mutex_t lock;
+	int next_job;
+	// finished jobs' JSON lines, written out in job order
+	vector<string> results;
+	vector<bool> done;
+	int next_to_write;
+	FILE *out;
+	long frames;
+	long hands;
+	// candidates with a hand's defects but not its shape, see hand_shape.h
+	long misshapen;
+};
+
+// appends s as a JSON string
+static void append_json_str(string& out, const char *s) {
+	out += '"';
+	for(; *s; s++) {
+		if(*s == '"' || *s == '\\') {
+			out += '\\';
+		}
+		out += *s;
+	}
+	out += '"';
+}
+
+void append_hands_record(string& out, const char *file, int frame,
+		const vector<Hand>& hands) {
+	char buf[64];
+	out += "{\"file\":";
+	append_json_str(out, file);
+	sprintf(buf, ",\"frame\":%d,\"hands\":[", frame);
+	out += buf;
+	for(size_t i=0; i<hands.size(); i++) {
+		const Hand& h = hands[i];
+		sprintf(buf, "%s{\"bbox\":[%d,%d,%d,%d],\"center\":[%d,%d],\"tips\":[",
+				i ? "," : "", h.bbox.x, h.bbox.y, h.bbox.width, h.bbox.height,
+				h.center.x, h.center.y);
+		out += buf;
+		for(int t=0; t<h.num_tips; t++) {
+			sprintf(buf, "%s[%d,%d]", t ? "," : "", h.tips[t].x, h.tips[t].y);
+			out += buf;
+		}
+		out += "],\"depths\":[";
+		for(int d=0; d<h.num_defects; d++) {
+			sprintf(buf, "%s%.1f", d ? "," : "", h.depths[d]);
+			out += buf;
+		}
+		out += "]}";
+	}
+	out += "]}\n";
+}
+
+// hands the job's output over and writes out whatever is now in order
+static void finish_job(BatchState *state, int job, string& lines,
+		long frames, long hands, long misshapen) {
+	pthread_mutex_lock(&state->lock);
+	state->results[job].swap(lines);
+	state->done[job] = true;
+	state->frames += frames;
+	state->hands += hands;
+	state->misshapen += misshapen;
+	while(state->next_to_write < (int)state->jobs.size() &&
+			state->done[state->next_to_write]) {
+		string& r = state->results[state->next_to_write];
+		fwrite(r.data(), 1, r.size(), state->out);
+		string().swap(r);
+		state->next_to_write++;
+	}
+	pthread_mutex_unlock(&state->lock);
+}
+
+// gets capture ready to return frame target next -- a seek in a compressed file lands on
+// a keyframe, so where it landed is checked and the rest decoded, and if it went past
+// (or the backend can't say) the file is decoded from the start
+// returns false if the file couldn't be opened again or ended first
+static bool seek_to_frame(CvCapture *&capture, const char *file, int target) {
+	cvSetCaptureProperty(capture, CV_CAP_PROP_POS_FRAMES, target);
+	int pos = (int)cvGetCaptureProperty(capture, CV_CAP_PROP_POS_FRAMES);
+	if(pos < 0 || pos > target) {
+		cvReleaseCapture(&capture);
+		capture = cvCreateFileCapture(file);
+		if(capture == NULL) {
+			return false;
+		}
+		pos = 0;
+	}
+	for(; pos < target; pos++) {
+		if(!cvGrabFrame(capture)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static void* batch_worker(void *arg) {
+	BatchState *state = (BatchState *)arg;
+	const BatchOptions& opts = *state->opts;
+
+	// own copies so nothing is shared but the job queue
+	Histogram hist = state->hist->copy();
+	HandDetector<DefaultHandConfig> detector;
+	Image hue, backproject;
+	vector<Hand> hands;
+	string lines;
+
+	while(1) {
+		pthread_mutex_lock(&state->lock);
+		int j = state->next_job++;
+		pthread_mutex_unlock(&state->lock);
+		if(j >= (int)state->jobs.size()) {
+			break;
+		}
+		const BatchJob& job = state->jobs[j];
+		const char *file = opts.inputs[job.file];
+		long job_frames = 0, job_hands = 0, job_misshapen = 0;
+		lines.clear();
+
+		CvCapture *capture = cvCreateFileCapture(file);
+		if(capture == NULL) {
+			fprintf(stderr, "batch: can't open %s\n", file);
+		} else {
+			bool positioned = job.first_frame == 0 ||
+					seek_to_frame(capture, file, job.first_frame);
+			for(int f=0; positioned && (job.num_frames < 0 || f < job.num_frames); f++) {
+				IplImage *image = cvQueryFrame(capture);
+				if(!image) {
+					break;
+				}
+				IplImage *hue_plane = hue.ensure( cvGetSize(image), 8, 1 );
+				backproject.ensure( cvGetSize(image), 8, 1 );
+				bgr_to_hue( image, hue );
+				cvCalcBackProject( &hue_plane, backproject, hist );
+
+				hands.clear();
+				detector.detect(backproject, hands, opts.perim_scale);
+				append_hands_record(lines, file, job.first_frame + f, hands);
+				job_frames++;
+				job_hands += hands.size();
+				job_misshapen += detector.misshapen();
+			}
+			if(capture) {
+				cvReleaseCapture(&capture);
+			}
+		}
+		finish_job(state, j, lines, job_frames, job_hands, job_misshapen);
+	}
+
+	return NULL;
+}
+
+int run_batch(const BatchOptions& opts, const Histogram& hist) {
+	BatchState state;
+	state.opts = &opts;
+	state.hist = &hist;
+	state.next_job = 0;
+	state.next_to_write = 0;
+	state.frames = 0;
+	state.hands = 0;
+	state.misshapen = 0;
+	state.out = fopen(opts.output, "w");
+	if(state.out == NULL) {
+		fprintf(stderr, "batch: can't open output %s\n", opts.output);
+		return 1;
+	}
+
+	// split files into chunks when we know how long they are
+	for(size_t i=0; i<opts.inputs.size(); i++) {
+		int total = 0;
+		CvCapture *capture = cvCreateFileCapture(opts.inputs[i]);
+		if(capture) {
+			total = (int)cvGetCaptureProperty(capture, CV_CAP_PROP_FRAME_COUNT);
+			cvReleaseCapture(&capture);
+		}
+		BatchJob job;
+		job.file = (int)i;
+		if(opts.chunk_frames <= 0 || total <= 0) {
+			job.first_frame = 0;
+			job.num_frames = -1;
+			state.jobs.push_back(job);
+			continue;
+		}
+		for(int first=0; first<total; first+=opts.chunk_frames) {
+			job.first_frame = first;
+			// last chunk runs to the end in case the frame count was an estimate
+			job.num_frames = first + opts.chunk_frames < total ? opts.chunk_frames : -1;
+			state.jobs.push_back(job);
+		}
+	}
+	state.results.resize(state.jobs.size());
+	state.done.resize(state.jobs.size(), false);
+
+	int num_workers = opts.num_workers;
+	if(num_workers <= 0) {
+		num_workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	}
+	if(num_workers > (int)state.jobs.size()) {
+		num_workers = (int)state.jobs.size();
+	}
+	if(num_workers < 1) {
+		num_workers = 1;
+	}
+
+	pthread_mutex_init(&state.lock, NULL);
+	int64 start = cvGetTickCount();
+	vector<pthread_t> threads(num_workers);
+	for(int i=0; i<num_workers; i++) {
+		pthread_create(&threads[i], NULL, batch_worker, &state);
+	}
+	for(int i=0; i<num_workers; i++) {
+		pthread_join(threads[i], NULL);
+	}
+	double secs = ticks_to_ms(cvGetTickCount() - start) / 1000.;
+	pthread_mutex_destroy(&state.lock);
+	fclose(state.out);
+
+	printf("batch: %d files, %d jobs, %d workers\n",
+			(int)opts.inputs.size(), (int)state.jobs.size(), num_workers);
+	printf("batch: %ld frames, %ld hands in %.2f s -- %.1f frames/s\n",
+			state.frames, state.hands, secs, secs > 0 ? state.frames / secs : 0.);
+	printf("batch: %ld candidates had a hand's defects but not its shape, dropped\n",
+			state.misshapen);
+	printf("batch: records written to %s\n", opts.output);
+	return 0;
+}
@@ -0,0 +1,58 @@
+/*
+ * batch.h
+ *
+ * Offline batch mode -- runs the hand detector over recorded video files (eg the avis
+ * that save mode writes) with no gui and no bullets, and writes one JSON line per frame:
+ *
+ * 	{"file":"a.avi","frame":12,"hands":[{"bbox":[x,y,w,h],"center":[x,y],
+ * 		"tips":[[x,y],...],"depths":[d,...]}]}
+ *
+ * Files are split into chunks of frames and the chunks are handed out to a pool of
+ * worker threads, so one long file still uses every core.  A chunk's worker seeks to
+ * the nearest keyframe and decodes forward to its first frame, so frame numbers are
+ * exact in compressed files too.  Lines come out in file / frame order regardless of
+ * which worker finished first.
+ * Implementation in batch.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef BATCH_H_
+#define BATCH_H_
+
+#include "cv.h"
+#include <vector>
+#include <string>
+
+#include "cv_handles.h"
+
+struct Hand;
+
+struct BatchOptions {
+	// video files to process
+	std::vector<const char*> inputs;
+	// JSON lines output file
+	const char *output;
+	// worker threads, 0 for one per core
+	int num_workers;
+	// frames per work unit, 0 for whole files only
+	int chunk_frames;
+	// passed on to the detector, see find_hands_and_shoot
+	float perim_scale;
+
+	BatchOptions()
+	: output(NULL), num_workers(0), chunk_frames(300), perim_scale(6)
+	{}
+};
+
+// runs the detector over opts.inputs, backprojecting hist (a 1D hue histogram)
+// prints a throughput summary when done
+// returns 0 on success, 1 if the output could not be opened
+// each worker gets its own copy of hist
+int run_batch(const BatchOptions& opts, const Histogram& hist);
+
+// appends one frame's record line, as above
+void append_hands_record(std::string& out, const char *file, int frame,
+		const std::vector<Hand>& hands);
+
+#endif /* BATCH_H_ */
@@ -0,0 +1,17 @@
+/*
+ * bench_main.cpp
+ *
+ * The benchmarks without the camera app, for the fingershooter_bench target:
+ *
+ * 	fingershooter_bench [name]
+ *
+ * does what fingershooter --bench [name] does, see benchmarks.h.
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "benchmarks.h"
+
+int main(int argc, char** argv) {
+	return run_benchmarks(argc >= 2 ? argv[1] : NULL) ? 0 : 1;
+}
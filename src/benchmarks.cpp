@@ -0,0 +1,1808 @@
+/*
+ * benchmarks.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "benchmarks.h"
+#include "hand_detector.h"
+#include "skin_lut.h"
+#include "task_pool.h"
+#include "tile_pipeline.h"
+#include "motion_gate.h"
+#include "yuv_source.h"
+#include "hue_kernel.h"
+#include "pixel_kernels.h"
+#include "synth_scene.h"
+#include "open_hands.h"
+#include "hand_detect.h"
+#include "hand_shape.h"
+#include "bullet_budget.h"
+#include "latency_budget.h"
+#include "idle_watch.h"
+#include "hand_publisher.h"
+#include "hand_events_reader.h"
+#include "mjpeg_server.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+//******* unix/linux only for the reader thread, sockets and sleeping
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "time.h"
+
+using namespace std;
+
+void draw_test_hand(IplImage *mask, CvPoint center, int scale) {
+	draw_synth_hand(mask, center, scale, 0, 5, cvScalarAll(255));
+}
+
+template <class Config>
+static int64 time_detect(HandDetector<Config>& detector, IplImage *src, IplImage *mask,
+		vector<Hand>& hands) {
+	cvCopy(src, mask);
+	hands.clear();
+	int64 t = cvGetTickCount();
+	detector.detect(mask, hands, 6);
+	return cvGetTickCount() - t;
+}
+
+void bench_hand_detector(int iterations) {
+	CvSize size = cvSize(640, 480);
+	IplImage *src = cvCreateImage(size, 8, 1);
+	IplImage *mask = cvCreateImage(size, 8, 1);
+	cvZero(src);
+	draw_test_hand(src, cvPoint(200, 300), 260);
+	draw_test_hand(src, cvPoint(460, 300), 220);
+
+	HandDetector<DefaultHandConfig> fixed;
+	HandDetector<RuntimeHandConfig> runtime;
+	vector<Hand> fixed_hands, runtime_hands;
+	int64 t_fixed = 0, t_runtime = 0;
+
+	// interleaved so both see the same cache / clock conditions
+	for(int i=0; i<iterations; i++) {
+		t_fixed += time_detect(fixed, src, mask, fixed_hands);
+		t_runtime += time_detect(runtime, src, mask, runtime_hands);
+	}
+
+	printf("bench_hand_detector: %dx%d, %d iterations\n", size.width, size.height, iterations);
+	printf("  DefaultHandConfig:  %.3f ms/frame, %d hands\n",
+			ticks_to_ms(t_fixed) / iterations, (int)fixed_hands.size());
+	printf("  RuntimeHandConfig:  %.3f ms/frame, %d hands\n",
+			ticks_to_ms(t_runtime) / iterations, (int)runtime_hands.size());
+
+	cvReleaseImage(&src);
+	cvReleaseImage(&mask);
+}
+
+// bgr frame with a skin colored hand on noise, for the color stages
+static IplImage* make_test_frame(CvSize size) {
+	IplImage *frame = cvCreateImage(size, 8, 3);
+	CvRNG rng = cvRNG(0x12345);
+	cvRandArr(&rng, frame, CV_RAND_UNI, cvScalarAll(0), cvScalarAll(256));
+	IplImage *hand = cvCreateImage(size, 8, 1);
+	cvZero(hand);
+	draw_test_hand(hand, cvPoint(size.width/2, size.height*2/3), size.height/2);
+	cvSet(frame, CV_RGB(224, 172, 140), hand);
+	cvReleaseImage(&hand);
+	return frame;
+}
+
+void bench_backproject(int iterations) {
+	CvSize size = cvSize(640, 480);
+	IplImage *frame = make_test_frame(size);
+	IplImage *hsv = cvCreateImage(size, 8, 3);
+	IplImage *hue = cvCreateImage(size, 8, 1);
+	IplImage *sat = cvCreateImage(size, 8, 1);
+	IplImage *bp_1d = cvCreateImage(size, 8, 1);
+	IplImage *bp_2d = cvCreateImage(size, 8, 1);
+	IplImage *bp_lut = cvCreateImage(size, 8, 1);
+	IplImage *planes[] = { hue, sat };
+
+	// histograms from the whole frame, scaled to [0,255] like calibration does
+	cvCvtColor(frame, hsv, CV_BGR2HSV);
+	cvSplit(hsv, hue, sat, 0, 0);
+	int hdims = 16;
+	float hranges_arr[] = {0,180};
+	float* hranges = hranges_arr;
+	CvHistogram *hist_1d = cvCreateHist(1, &hdims, CV_HIST_ARRAY, &hranges, 1);
+	Histogram hist_2d = create_hue_sat_hist_bins();
+	cvCalcHist(&hue, hist_1d);
+	cvCalcHist(planes, hist_2d);
+	float max_val = 0;
+	cvGetMinMaxHistValue(hist_1d, 0, &max_val);
+	cvConvertScale(hist_1d->bins, hist_1d->bins, max_val ? 255. / max_val : 0.);
+	cvGetMinMaxHistValue(hist_2d, 0, &max_val);
+	cvConvertScale(hist_2d->bins, hist_2d->bins, max_val ? 255. / max_val : 0.);
+
+	int64 t = cvGetTickCount();
+	HueSatLut *lut = new HueSatLut();
+	lut->build(hist_2d);
+	double build_ms = ticks_to_ms(cvGetTickCount() - t);
+
+	int64 t_1d = 0, t_2d = 0, t_lut = 0;
+	for(int i=0; i<iterations; i++) {
+		t = cvGetTickCount();
+		cvCvtColor(frame, hsv, CV_BGR2HSV);
+		cvSplit(hsv, hue, 0, 0, 0);
+		cvCalcBackProject(&hue, bp_1d, hist_1d);
+		t_1d += cvGetTickCount() - t;
+
+		t = cvGetTickCount();
+		cvCvtColor(frame, hsv, CV_BGR2HSV);
+		cvSplit(hsv, hue, sat, 0, 0);
+		cvCalcBackProject(planes, bp_2d, hist_2d);
+		t_2d += cvGetTickCount() - t;
+
+		t = cvGetTickCount();
+		cvCvtColor(frame, hsv, CV_BGR2HSV);
+		lut->backproject(hsv, bp_lut);
+		t_lut += cvGetTickCount() - t;
+	}
+
+	// the table has to agree with cvCalcBackProject pixel for pixel
+	IplImage *diff = cvCreateImage(size, 8, 1);
+	cvAbsDiff(bp_2d, bp_lut, diff);
+	int mismatches = cvCountNonZero(diff);
+
+	printf("bench_backproject: %dx%d, %d iterations (cvCvtColor included in each)\n",
+			size.width, size.height, iterations);
+	printf("  hue only cvCalcBackProject:  %.3f ms/frame\n", ticks_to_ms(t_1d) / iterations);
+	printf("  hue/sat cvCalcBackProject:   %.3f ms/frame\n", ticks_to_ms(t_2d) / iterations);
+	printf("  hue/sat HueSatLut:           %.3f ms/frame (table build %.3f ms)\n",
+			ticks_to_ms(t_lut) / iterations, build_ms);
+	printf("  HueSatLut vs cvCalcBackProject mismatched pixels: %d\n", mismatches);
+
+	delete lut;
+	cvReleaseHist(&hist_1d);
+	cvReleaseImage(&diff);
+	cvReleaseImage(&frame);
+	cvReleaseImage(&hsv);
+	cvReleaseImage(&hue);
+	cvReleaseImage(&sat);
+	cvReleaseImage(&bp_1d);
+	cvReleaseImage(&bp_2d);
+	cvReleaseImage(&bp_lut);
+}
+
+// 1D hue histogram of the whole frame, scaled to [0,255] like calibration does
+static CvHistogram* make_test_hue_hist(IplImage *frame) {
+	IplImage *hsv = cvCreateImage(cvGetSize(frame), 8, 3);
+	IplImage *hue = cvCreateImage(cvGetSize(frame), 8, 1);
+	cvCvtColor(frame, hsv, CV_BGR2HSV);
+	cvSplit(hsv, hue, 0, 0, 0);
+	int hdims = 16;
+	float hranges_arr[] = {0,180};
+	float* hranges = hranges_arr;
+	CvHistogram *hist = cvCreateHist(1, &hdims, CV_HIST_ARRAY, &hranges, 1);
+	cvCalcHist(&hue, hist);
+	float max_val = 0;
+	cvGetMinMaxHistValue(hist, 0, &max_val);
+	cvConvertScale(hist->bins, hist->bins, max_val ? 255. / max_val : 0.);
+	cvReleaseImage(&hsv);
+	cvReleaseImage(&hue);
+	return hist;
+}
+
+void bench_tile_pipeline(int iterations) {
+	CvSize size = cvSize(1280, 720);
+	IplImage *frame = make_test_frame(size);
+	IplImage *hsv = cvCreateImage(size, 8, 3);
+	IplImage *hue = cvCreateImage(size, 8, 1);
+	IplImage *whole = cvCreateImage(size, 8, 1);
+	IplImage *tiled = cvCreateImage(size, 8, 1);
+	IplImage *diff = cvCreateImage(size, 8, 1);
+	CvHistogram *hist = make_test_hue_hist(frame);
+
+	int64 t = cvGetTickCount();
+	for(int i=0; i<iterations; i++) {
+		cvCvtColor(frame, hsv, CV_BGR2HSV);
+		cvSplit(hsv, hue, 0, 0, 0);
+		cvCalcBackProject(&hue, whole, hist);
+		cvThreshold(whole, whole, DefaultHandConfig::threshold, 255, CV_THRESH_BINARY);
+		cvMorphologyEx(whole, whole, 0, 0, CV_MOP_OPEN, DefaultHandConfig::close_itr);
+		cvMorphologyEx(whole, whole, 0, 0, CV_MOP_CLOSE, DefaultHandConfig::close_itr);
+	}
+	printf("bench_tile_pipeline: %dx%d, %d iterations\n", size.width, size.height, iterations);
+	printf("  whole frame stages:  %.3f ms/frame\n",
+			ticks_to_ms(cvGetTickCount() - t) / iterations);
+
+	int tile_sizes[][2] = { { 64, 48 }, { 160, 120 }, { 320, 180 } };
+	int worker_counts[] = { 1, 0 };
+	for(int w=0; w<2; w++) {
+		TaskPool pool(worker_counts[w]);
+		for(int i=0; i<3; i++) {
+			TilePipeline tiles(&pool, DefaultHandConfig(), tile_sizes[i][0], tile_sizes[i][1]);
+			tiles.set_hist(hist);
+			for(int j=0; j<iterations; j++) {
+				tiles.run(frame, tiled);
+			}
+			cvAbsDiff(whole, tiled, diff);
+			tiles.print_timing();
+			printf("  mismatched pixels vs whole frame: %d\n", cvCountNonZero(diff));
+		}
+	}
+
+	// a tuned config has to clean the tiles the same as the detector cleans the frame
+	RuntimeHandConfig tuned;
+	tuned.threshold = 40;
+	tuned.close_itr = 2;
+	tuned.kernel_size = 5;
+	HandDetector<RuntimeHandConfig> detector(tuned);
+	cvCvtColor(frame, hsv, CV_BGR2HSV);
+	cvSplit(hsv, hue, 0, 0, 0);
+	cvCalcBackProject(&hue, whole, hist);
+	detector.clean(whole);
+	TaskPool pool;
+	TilePipeline tiles(&pool, tuned);
+	tiles.set_hist(hist);
+	tiles.run(frame, tiled);
+	cvAbsDiff(whole, tiled, diff);
+	printf("  tuned config (threshold %d, close_itr %d, %dx%d kernel), mismatched pixels "
+			"vs HandDetector::clean: %d\n", tuned.threshold, tuned.close_itr,
+			tuned.kernel_size, tuned.kernel_size, cvCountNonZero(diff));
+
+	cvReleaseHist(&hist);
+	cvReleaseImage(&frame);
+	cvReleaseImage(&hsv);
+	cvReleaseImage(&hue);
+	cvReleaseImage(&whole);
+	cvReleaseImage(&tiled);
+	cvReleaseImage(&diff);
+}
+
+// true if both runs found the same hands in the same order
+static bool same_hands(const vector<Hand>& a, const vector<Hand>& b) {
+	if(a.size() != b.size()) {
+		return false;
+	}
+	for(size_t i=0; i<a.size(); i++) {
+		if(a[i].num_tips != b[i].num_tips || a[i].bbox.x != b[i].bbox.x ||
+				a[i].bbox.y != b[i].bbox.y) {
+			return false;
+		}
+		for(int t=0; t<a[i].num_tips; t++) {
+			if(a[i].tips[t].x != b[i].tips[t].x || a[i].tips[t].y != b[i].tips[t].y) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+void bench_parallel_contours(int iterations) {
+	CvSize size = cvSize(1280, 720);
+	IplImage *src = cvCreateImage(size, 8, 1);
+	IplImage *mask = cvCreateImage(size, 8, 1);
+	cvZero(src);
+	// a crowd: rows of hands plus skin colored clutter
+	CvRNG rng = cvRNG(0x5eed);
+	for(int i=0; i<12; i++) {
+		draw_test_hand(src, cvPoint(110 + (i % 6) * 210, 200 + (i / 6) * 330),
+				150 + cvRandInt(&rng) % 60);
+	}
+	for(int i=0; i<20; i++) {
+		cvEllipse(src, cvPoint(cvRandInt(&rng) % size.width, cvRandInt(&rng) % size.height),
+				cvSize(20 + cvRandInt(&rng) % 50, 20 + cvRandInt(&rng) % 50),
+				cvRandInt(&rng) % 180, 0, 360, cvScalarAll(255), CV_FILLED);
+	}
+
+	TaskPool pool;
+	HandDetector<DefaultHandConfig> serial, parallel;
+	parallel.set_pool(&pool);
+	vector<Hand> serial_hands, parallel_hands;
+	int64 t_serial = 0, t_parallel = 0;
+	for(int i=0; i<iterations; i++) {
+		t_serial += time_detect(serial, src, mask, serial_hands);
+		t_parallel += time_detect(parallel, src, mask, parallel_hands);
+	}
+
+	printf("bench_parallel_contours: %dx%d, %d iterations, %d workers\n",
+			size.width, size.height, iterations, pool.size());
+	printf("  serial:    %.3f ms/frame, %d hands\n",
+			ticks_to_ms(t_serial) / iterations, (int)serial_hands.size());
+	printf("  parallel:  %.3f ms/frame, %d hands, %ld steals\n",
+			ticks_to_ms(t_parallel) / iterations, (int)parallel_hands.size(), pool.steals());
+	printf("  same hands in same order: %s\n",
+			same_hands(serial_hands, parallel_hands) ? "yes" : "NO");
+
+	cvReleaseImage(&src);
+	cvReleaseImage(&mask);
+}
+
+bool bench_motion_gate(int iterations) {
+	CvSize size = cvSize(1280, 720);
+	IplImage *frame = make_test_frame(size);
+	IplImage *moved = cvCloneImage(frame);
+	// something moved in one corner
+	cvRectangle(moved, cvPoint(40, 40), cvPoint(200, 160), CV_RGB(224, 172, 140), CV_FILLED);
+
+	MotionGate gate;
+	gate.update(frame);
+	int64 t_still = 0, t_moving = 0;
+	int changed = 0;
+	for(int i=0; i<iterations; i++) {
+		int64 t = cvGetTickCount();
+		gate.update(frame);
+		t_still += cvGetTickCount() - t;
+		t = cvGetTickCount();
+		changed = gate.update(i & 1 ? frame : moved);
+		t_moving += cvGetTickCount() - t;
+	}
+	printf("bench_motion_gate: %dx%d, %d iterations\n", size.width, size.height, iterations);
+	printf("  update, still frame:   %.3f ms\n", ticks_to_ms(t_still) / iterations);
+	printf("  update, moving frame:  %.3f ms, %d blocks changed\n",
+			ticks_to_ms(t_moving) / iterations, changed);
+
+	// a patch brightening by 1 a frame is never over the threshold frame to frame, but
+	// it has to show up against the frame the gate kept
+	MotionGate drift_gate;
+	IplImage *drifting = cvCloneImage(frame);
+	drift_gate.update(drifting);
+	int drift_frames = 0, drift_changed = 0;
+	while(!drift_changed && drift_frames < 64) {
+		cvSetImageROI(drifting, cvRect(400, 200, 64, 64));
+		cvAddS(drifting, cvScalarAll(1), drifting);
+		cvResetImageROI(drifting);
+		drift_changed = drift_gate.update(drifting);
+		drift_frames++;
+	}
+	bool ok = drift_changed != 0;
+	if(drift_changed) {
+		printf("  slow drift (+1 a frame): changed after %d frames\n", drift_frames);
+	} else {
+		printf("  slow drift (+1 a frame): NOT seen in %d frames\n", drift_frames);
+	}
+	cvReleaseImage(&drifting);
+
+	// two hands, only the left one moves between frames
+	IplImage *still_mask = cvCreateImage(size, 8, 1);
+	IplImage *moved_mask = cvCreateImage(size, 8, 1);
+	IplImage *mask = cvCreateImage(size, 8, 1);
+	IplImage *gray = cvCreateImage(size, 8, 3);
+	cvZero(still_mask);
+	draw_test_hand(still_mask, cvPoint(300, 450), 400);
+	cvCopy(still_mask, moved_mask);
+	draw_test_hand(still_mask, cvPoint(900, 450), 400);
+	draw_test_hand(moved_mask, cvPoint(940, 450), 400);
+
+	HandDetector<DefaultHandConfig> gated, plain;
+	MotionGate hand_gate;
+	gated.set_motion(&hand_gate);
+	vector<Hand> gated_hands, plain_hands;
+	int64 t_gated = 0, t_plain = 0;
+	long reused = 0;
+	for(int i=0; i<iterations; i++) {
+		IplImage *src = i & 1 ? moved_mask : still_mask;
+		// the gate looks at the frame, here the mask stands in for it
+		cvCvtColor(src, gray, CV_GRAY2BGR);
+		int64 t = cvGetTickCount();
+		hand_gate.update(gray);
+		t_gated += cvGetTickCount() - t;
+		t_gated += time_detect(gated, src, mask, gated_hands);
+		reused += gated.reused();
+		t_plain += time_detect(plain, src, mask, plain_hands);
+	}
+	printf("  detector, one of two hands moving:\n");
+	printf("    plain:  %.3f ms/frame\n", ticks_to_ms(t_plain) / iterations);
+	bool same = same_hands(gated_hands, plain_hands);
+	printf("    gated:  %.3f ms/frame (update included), %.2f contours reused/frame, "
+			"same hands: %s\n", ticks_to_ms(t_gated) / iterations, (double)reused / iterations,
+			same ? "yes" : "NO");
+	ok = ok && same;
+
+	cvReleaseImage(&frame);
+	cvReleaseImage(&moved);
+	cvReleaseImage(&still_mask);
+	cvReleaseImage(&moved_mask);
+	cvReleaseImage(&mask);
+	cvReleaseImage(&gray);
+	return ok;
+}
+
+void bench_yuv_ingest(int iterations) {
+	CvSize size = cvSize(640, 480);
+	IplImage *frame = make_test_frame(size);
+	CvHistogram *hist = make_test_hue_hist(frame);
+	IplImage *bgr = cvCreateImage(size, 8, 3);
+	IplImage *hsv = cvCreateImage(size, 8, 3);
+	IplImage *hue = cvCreateImage(size, 8, 1);
+	IplImage *bp_bgr = cvCreateImage(size, 8, 1);
+	IplImage *bp_uv = cvCreateImage(size, 8, 1);
+	IplImage *diff = cvCreateImage(size, 8, 1);
+
+	int64 t = cvGetTickCount();
+	UvSkinLut *lut = new UvSkinLut();
+	lut->build(hist);
+	double build_ms = ticks_to_ms(cvGetTickCount() - t);
+	printf("bench_yuv_ingest: %dx%d, %d iterations (UvSkinLut build %.3f ms)\n",
+			size.width, size.height, iterations, build_ms);
+
+	YuvFormat formats[] = { YUV_YUYV, YUV_NV12 };
+	const char *names[] = { "yuyv", "nv12" };
+	for(int f=0; f<2; f++) {
+		YuvFrame yuv;
+		yuv.fmt = formats[f];
+		yuv.width = size.width;
+		yuv.height = size.height;
+		yuv.data = new uchar[yuv_frame_bytes(yuv.fmt, size.width, size.height)];
+		bgr_to_yuv(frame, yuv);
+
+		int64 t_bgr = 0, t_uv = 0;
+		for(int i=0; i<iterations; i++) {
+			// what we pay now -- the driver's conversion to bgr, then back to hsv
+			t = cvGetTickCount();
+			yuv_to_bgr(yuv, bgr);
+			cvCvtColor(bgr, hsv, CV_BGR2HSV);
+			cvSplit(hsv, hue, 0, 0, 0);
+			cvCalcBackProject(&hue, bp_bgr, hist);
+			t_bgr += cvGetTickCount() - t;
+
+			t = cvGetTickCount();
+			lut->backproject(yuv, bp_uv);
+			t_uv += cvGetTickCount() - t;
+		}
+
+		// differences come from hue rounding and pixels that clip in bgr
+		cvAbsDiff(bp_bgr, bp_uv, diff);
+		int mismatches = cvCountNonZero(diff);
+		printf("  %s:\n", names[f]);
+		printf("    to bgr, hue backproject:  %.3f ms/frame\n", ticks_to_ms(t_bgr) / iterations);
+		printf("    UvSkinLut from chroma:    %.3f ms/frame\n", ticks_to_ms(t_uv) / iterations);
+		printf("    mismatched pixels: %d (%.2f%%)\n", mismatches,
+				100. * mismatches / (size.width * size.height));
+		delete [] yuv.data;
+	}
+
+	delete lut;
+	cvReleaseHist(&hist);
+	cvReleaseImage(&frame);
+	cvReleaseImage(&bgr);
+	cvReleaseImage(&hsv);
+	cvReleaseImage(&hue);
+	cvReleaseImage(&bp_bgr);
+	cvReleaseImage(&bp_uv);
+	cvReleaseImage(&diff);
+}
+
+void bench_hue_kernel(int iterations) {
+	CvSize sizes[] = { cvSize(640, 480), cvSize(1280, 720) };
+	for(int i=0; i<2; i++) {
+		CvSize size = sizes[i];
+		IplImage *frame = make_test_frame(size);
+		IplImage *hsv = cvCreateImage(size, 8, 3);
+		IplImage *hue_cv = cvCreateImage(size, 8, 1);
+		IplImage *hue_fixed = cvCreateImage(size, 8, 1);
+
+		int64 t_cv = 0, t_fixed = 0;
+		for(int j=0; j<iterations; j++) {
+			int64 t = cvGetTickCount();
+			cvCvtColor(frame, hsv, CV_BGR2HSV);
+			cvSplit(hsv, hue_cv, 0, 0, 0);
+			t_cv += cvGetTickCount() - t;
+
+			t = cvGetTickCount();
+			bgr_to_hue(frame, hue_fixed);
+			t_fixed += cvGetTickCount() - t;
+		}
+		cvAbsDiff(hue_cv, hue_fixed, hue_cv);
+		int mismatches = cvCountNonZero(hue_cv);
+
+		printf("bench_hue_kernel: %dx%d, %d iterations\n", size.width, size.height, iterations);
+		printf("  cvCvtColor + cvSplit:  %.3f ms/frame\n", ticks_to_ms(t_cv) / iterations);
+		printf("  bgr_to_hue:            %.3f ms/frame, %d mismatched pixels\n",
+				ticks_to_ms(t_fixed) / iterations, mismatches);
+
+		cvReleaseImage(&frame);
+		cvReleaseImage(&hsv);
+		cvReleaseImage(&hue_cv);
+		cvReleaseImage(&hue_fixed);
+	}
+}
+
+bool test_hue_kernel() {
+	// every colour once, b fastest
+	IplImage *all = cvCreateImage(cvSize(4096, 4096), 8, 3);
+	for(int y=0; y<4096; y++) {
+		uchar *p = (uchar *)(all->imageData + y * all->widthStep);
+		for(int x=0; x<4096; x++, p+=3) {
+			int c = y * 4096 + x;
+			p[0] = c & 255;
+			p[1] = (c >> 8) & 255;
+			p[2] = c >> 16;
+		}
+	}
+	IplImage *hsv = cvCreateImage(cvGetSize(all), 8, 3);
+	IplImage *expected = cvCreateImage(cvGetSize(all), 8, 1);
+	IplImage *hue = cvCreateImage(cvGetSize(all), 8, 1);
+	cvCvtColor(all, hsv, CV_BGR2HSV);
+	cvSplit(hsv, expected, 0, 0, 0);
+
+	long mismatches = 0;
+	// full rows, then row lengths 1-31 so every tail length is hit
+	for(int pass=0; pass<2; pass++) {
+		for(int y=0; y<4096; y++) {
+			const uchar *src = (const uchar *)(all->imageData + y * all->widthStep);
+			const uchar *want = (const uchar *)(expected->imageData + y * expected->widthStep);
+			uchar *got = (uchar *)(hue->imageData + y * hue->widthStep);
+			int n = pass == 0 ? 4096 : 1 + y % 31;
+			bgr_to_hue_row(src, got, n);
+			for(int x=0; x<n; x++) {
+				if(got[x] != want[x]) {
+					if(mismatches < 10) {
+						printf("  bgr %d %d %d: cvCvtColor hue %d, bgr_to_hue %d\n",
+								src[3*x], src[3*x+1], src[3*x+2], want[x], got[x]);
+					}
+					mismatches++;
+				}
+			}
+		}
+	}
+	printf("test_hue_kernel: all 2^24 colours, %ld mismatches -- %s\n", mismatches,
+			mismatches ? "FAILED" : "ok");
+
+	cvReleaseImage(&all);
+	cvReleaseImage(&hsv);
+	cvReleaseImage(&expected);
+	cvReleaseImage(&hue);
+	return mismatches == 0;
+}
+
+// counts a mismatch if got differs from want in its first n bytes, printing the first few
+static void check_kernel_row(const char *kernel, SimdLevel level, const uchar *want,
+		const uchar *got, int n, long &mismatches) {
+	if(memcmp(want, got, n) == 0) {
+		return;
+	}
+	if(mismatches < 10) {
+		int x = 0;
+		while(want[x] == got[x]) {
+			x++;
+		}
+		printf("  %s %s, %d bytes: byte %d is %d, scalar has %d\n", simd_level_name(level),
+				kernel, n, x, got[x], want[x]);
+	}
+	mismatches++;
+}
+
+// pixels where a and b differ, both 8 bit, same size and channels
+static int count_diff(const IplImage *a, const IplImage *b) {
+	IplImage *diff = cvCreateImage(cvGetSize(a), 8, a->nChannels);
+	cvAbsDiff(a, b, diff);
+	int n = 0;
+	if(a->nChannels == 1) {
+		n = cvCountNonZero(diff);
+	} else {
+		IplImage *any = cvCreateImage(cvGetSize(a), 8, 1);
+		cvCvtColor(diff, any, CV_BGR2GRAY);
+		n = cvCountNonZero(any);
+		cvReleaseImage(&any);
+	}
+	cvReleaseImage(&diff);
+	return n;
+}
+
+bool test_pixel_kernels() {
+	// every tail length of the widest (64 pixel) loops, at a few misalignments
+	const int max_n = 300;
+	CvRNG rng = cvRNG(0xa11ce);
+	vector<uchar> bgr(3 * max_n + 8), a(max_n + 8), b(max_n + 8), c(max_n + 8), table(256);
+	vector<uchar> want(3 * max_n + 8), got(3 * max_n + 8);
+	for(size_t i=0; i<bgr.size(); i++) {
+		bgr[i] = (uchar)cvRandInt(&rng);
+	}
+	for(size_t i=0; i<a.size(); i++) {
+		a[i] = (uchar)cvRandInt(&rng);
+		b[i] = (uchar)cvRandInt(&rng);
+		c[i] = (uchar)cvRandInt(&rng);
+	}
+	for(int i=0; i<256; i++) {
+		table[i] = (uchar)cvRandInt(&rng);
+	}
+	int thresholds[] = { 0, 1, 15, 127, 128, 254 };
+	const PixelKernels& ref = pixel_kernels_for(SIMD_SCALAR);
+
+	printf("test_pixel_kernels: each level against the scalar kernels\n");
+	long mismatches = 0;
+	for(int l=SIMD_SCALAR+1; l<NUM_SIMD_LEVELS; l++) {
+		SimdLevel level = (SimdLevel)l;
+		if(!simd_supported(level)) {
+			printf("  %-7s not supported here\n", simd_level_name(level));
+			continue;
+		}
+		const PixelKernels& k = pixel_kernels_for(level);
+		long before = mismatches;
+		for(int n=0; n<=max_n; n++) {
+			for(int off=0; off<4; off++) {
+				ref.hue_row(&bgr[off], &want[0], n);
+				k.hue_row(&bgr[off], &got[0], n);
+				check_kernel_row("hue_row", level, &want[0], &got[0], n, mismatches);
+				ref.lut_row(&a[off], &want[0], n, &table[0]);
+				k.lut_row(&a[off], &got[0], n, &table[0]);
+				check_kernel_row("lut_row", level, &want[0], &got[0], n, mismatches);
+				for(int t=0; t<(int)(sizeof(thresholds)/sizeof(thresholds[0])); t++) {
+					ref.threshold_row(&a[off], &want[0], n, thresholds[t]);
+					k.threshold_row(&a[off], &got[0], n, thresholds[t]);
+					check_kernel_row("threshold_row", level, &want[0], &got[0], n, mismatches);
+				}
+				ref.min3_row(&a[off], &b[1], &c[2], &want[0], n);
+				k.min3_row(&a[off], &b[1], &c[2], &got[0], n);
+				check_kernel_row("min3_row", level, &want[0], &got[0], n, mismatches);
+				ref.max3_row(&a[off], &b[1], &c[2], &want[0], n);
+				k.max3_row(&a[off], &b[1], &c[2], &got[0], n);
+				check_kernel_row("max3_row", level, &want[0], &got[0], n, mismatches);
+				ref.hmin3_row(&a[off], &want[0], n);
+				k.hmin3_row(&a[off], &got[0], n);
+				check_kernel_row("hmin3_row", level, &want[0], &got[0], n, mismatches);
+				ref.hmax3_row(&a[off], &want[0], n);
+				k.hmax3_row(&a[off], &got[0], n);
+				check_kernel_row("hmax3_row", level, &want[0], &got[0], n, mismatches);
+				// with the bytes past the end, to catch overruns
+				memset(&want[0], 0, want.size());
+				memset(&got[0], 0, got.size());
+				ref.fill_bgr_row(&want[off], n, &bgr[n]);
+				k.fill_bgr_row(&got[off], n, &bgr[n]);
+				check_kernel_row("fill_bgr_row", level, &want[0], &got[0], (int)got.size(),
+						mismatches);
+			}
+		}
+		// and the hue of every colour, b fastest
+		vector<uchar> colours(3 * 4096), want_hue(4096), got_hue(4096);
+		for(int y=0; y<4096; y++) {
+			for(int x=0; x<4096; x++) {
+				int col = y * 4096 + x;
+				colours[3*x] = col & 255;
+				colours[3*x+1] = (col >> 8) & 255;
+				colours[3*x+2] = col >> 16;
+			}
+			ref.hue_row(&colours[0], &want_hue[0], 4096);
+			k.hue_row(&colours[0], &got_hue[0], 4096);
+			check_kernel_row("hue_row", level, &want_hue[0], &got_hue[0], 4096, mismatches);
+		}
+		printf("  %-7s %s%s\n", simd_level_name(level), mismatches == before ? "ok" : "FAILED",
+				k.lut_row == ref.lut_row ? " (lut_row is the scalar one)" : "");
+	}
+
+	// the image level functions against the OpenCV calls they replace, at every level
+	printf("  image functions against OpenCV:\n");
+	SimdLevel was = simd_level();
+	CvSize size = cvSize(333, 241);
+	IplImage *frame = make_test_frame(size);
+	CvHistogram *hist = make_test_hue_hist(frame);
+	HueLut hue_lut;
+	hue_lut.build(hist);
+	IplImage *hue = cvCreateImage(size, 8, 1);
+	IplImage *cv_out = cvCreateImage(size, 8, 1);
+	IplImage *out = cvCreateImage(size, 8, 1);
+	IplImage *tmp = cvCreateImage(size, 8, 1);
+	IplImage *canvas = cvCreateImage(size, 8, 3);
+	IplImage *canvas_ref = cvCreateImage(size, 8, 3);
+	IplImage *canvas_cv = cvCreateImage(size, 8, 3);
+	for(int l=SIMD_SCALAR; l<NUM_SIMD_LEVELS; l++) {
+		SimdLevel level = (SimdLevel)l;
+		if(!simd_supported(level)) {
+			continue;
+		}
+		set_simd_level(level);
+		int bad = 0;
+		bgr_to_hue(frame, hue);
+		cvCalcBackProject(&hue, cv_out, hist);
+		hue_lut.backproject(hue, out);
+		bad += count_diff(cv_out, out);
+
+		int t_values[] = { -1, 0, 15, 200, 255 };
+		for(int t=0; t<5; t++) {
+			cvThreshold(cv_out, tmp, t_values[t], 255, CV_THRESH_BINARY);
+			threshold_binary(cv_out, out, t_values[t]);
+			bad += count_diff(tmp, out);
+		}
+
+		for(int itr=0; itr<=2; itr++) {
+			cvThreshold(cv_out, out, 15, 255, CV_THRESH_BINARY);
+			cvCopy(out, cv_out);
+			cvMorphologyEx(cv_out, cv_out, 0, 0, CV_MOP_OPEN, itr);
+			cvMorphologyEx(cv_out, cv_out, 0, 0, CV_MOP_CLOSE, itr);
+			open_close_3x3(out, itr, tmp);
+			bad += count_diff(cv_out, out);
+			cvCalcBackProject(&hue, cv_out, hist);
+		}
+
+		// bullets, some over the edges -- against the scalar kernels, and how far from
+		// cvCircle's edge pixels
+		cvZero(canvas);
+		cvZero(canvas_cv);
+		CvRNG circle_rng = cvRNG(7);
+		for(int i=0; i<60; i++) {
+			CvPoint p = cvPoint(cvRandInt(&circle_rng) % (size.width + 40) - 20,
+					cvRandInt(&circle_rng) % (size.height + 40) - 20);
+			int r = cvRandInt(&circle_rng) % 30;
+			CvScalar color = cvScalar(cvRandInt(&circle_rng) & 255, 100 + i, 255 - i);
+			fill_circle(canvas, p, r, color);
+			cvCircle(canvas_cv, p, r, color, CV_FILLED);
+		}
+		if(level == SIMD_SCALAR) {
+			cvCopy(canvas, canvas_ref);
+		}
+		bad += count_diff(canvas_ref, canvas);
+		int off_cv = count_diff(canvas_cv, canvas);
+
+		printf("    %-7s %s (fill_circle: %d pixels differ from cvCircle)\n",
+				simd_level_name(level), bad ? "FAILED" : "ok", off_cv);
+		mismatches += bad;
+	}
+	set_simd_level(was);
+	printf("test_pixel_kernels: %ld mismatches -- %s\n", mismatches,
+			mismatches ? "FAILED" : "ok");
+
+	cvReleaseHist(&hist);
+	cvReleaseImage(&frame);
+	cvReleaseImage(&hue);
+	cvReleaseImage(&cv_out);
+	cvReleaseImage(&out);
+	cvReleaseImage(&tmp);
+	cvReleaseImage(&canvas);
+	cvReleaseImage(&canvas_ref);
+	cvReleaseImage(&canvas_cv);
+	return mismatches == 0;
+}
+
+void bench_pixel_kernels(int iterations) {
+	CvSize size = cvSize(1280, 720);
+	IplImage *frame = make_test_frame(size);
+	CvHistogram *hist = make_test_hue_hist(frame);
+	HueLut hue_lut;
+	hue_lut.build(hist);
+	IplImage *hsv = cvCreateImage(size, 8, 3);
+	IplImage *hue = cvCreateImage(size, 8, 1);
+	IplImage *bp = cvCreateImage(size, 8, 1);
+	IplImage *mask = cvCreateImage(size, 8, 1);
+	IplImage *tmp = cvCreateImage(size, 8, 1);
+	IplImage *canvas = cvCreateImage(size, 8, 3);
+	// a screenful of bullets, mostly small
+	const int num_bullets = 500;
+	CvPoint pos[num_bullets];
+	int radius[num_bullets];
+	CvRNG rng = cvRNG(99);
+	for(int i=0; i<num_bullets; i++) {
+		pos[i] = cvPoint(cvRandInt(&rng) % size.width, cvRandInt(&rng) % size.height);
+		radius[i] = 2 + cvRandInt(&rng) % (i % 10 ? 6 : 24);
+	}
+	CvScalar color = CV_RGB(255, 0, 0);
+
+	SimdLevel was = simd_level();
+	printf("bench_pixel_kernels: %dx%d, %d iterations, ms/frame (running at %s)\n",
+			size.width, size.height, iterations, simd_level_name(was));
+	printf("  level        hue  backproject  threshold  open+close  %d bullets\n", num_bullets);
+	// -1 for the OpenCV calls the kernels replace
+	for(int l=-1; l<NUM_SIMD_LEVELS; l++) {
+		if(l >= 0 && !simd_supported((SimdLevel)l)) {
+			continue;
+		}
+		if(l >= 0) {
+			set_simd_level((SimdLevel)l);
+		}
+		int64 ticks[5] = { 0, 0, 0, 0, 0 };
+		for(int i=0; i<iterations; i++) {
+			int64 t = cvGetTickCount();
+			if(l < 0) {
+				cvCvtColor(frame, hsv, CV_BGR2HSV);
+				cvSplit(hsv, hue, 0, 0, 0);
+			} else {
+				bgr_to_hue(frame, hue);
+			}
+			int64 now = cvGetTickCount();
+			ticks[0] += now - t;
+			t = now;
+
+			if(l < 0) {
+				cvCalcBackProject(&hue, bp, hist);
+			} else {
+				hue_lut.backproject(hue, bp);
+			}
+			now = cvGetTickCount();
+			ticks[1] += now - t;
+			t = now;
+
+			if(l < 0) {
+				cvThreshold(bp, mask, 15, 255, CV_THRESH_BINARY);
+			} else {
+				threshold_binary(bp, mask, 15);
+			}
+			now = cvGetTickCount();
+			ticks[2] += now - t;
+			t = now;
+
+			if(l < 0) {
+				cvMorphologyEx(mask, mask, 0, 0, CV_MOP_OPEN, 1);
+				cvMorphologyEx(mask, mask, 0, 0, CV_MOP_CLOSE, 1);
+			} else {
+				open_close_3x3(mask, 1, tmp);
+			}
+			now = cvGetTickCount();
+			ticks[3] += now - t;
+			t = now;
+
+			for(int b=0; b<num_bullets; b++) {
+				if(l < 0) {
+					cvCircle(canvas, pos[b], radius[b], color, CV_FILLED);
+				} else {
+					fill_circle(canvas, pos[b], radius[b], color);
+				}
+			}
+			ticks[4] += cvGetTickCount() - t;
+		}
+		printf("  %-8s %7.3f  %11.3f  %9.3f  %10.3f  %10.3f\n",
+				l < 0 ? "opencv" : simd_level_name((SimdLevel)l),
+				ticks_to_ms(ticks[0]) / iterations, ticks_to_ms(ticks[1]) / iterations,
+				ticks_to_ms(ticks[2]) / iterations, ticks_to_ms(ticks[3]) / iterations,
+				ticks_to_ms(ticks[4]) / iterations);
+	}
+	set_simd_level(was);
+
+	cvReleaseHist(&hist);
+	cvReleaseImage(&frame);
+	cvReleaseImage(&hsv);
+	cvReleaseImage(&hue);
+	cvReleaseImage(&bp);
+	cvReleaseImage(&mask);
+	cvReleaseImage(&tmp);
+	cvReleaseImage(&canvas);
+}
+
+void bench_synth_scaling(int iterations) {
+	CvSize sizes[] = { cvSize(320, 240), cvSize(640, 480), cvSize(1280, 720), cvSize(1920, 1080) };
+	int hand_counts[] = { 1, 4, 8 };
+	int clutter_counts[] = { 0, 20, 80 };
+	printf("bench_synth_scaling: find_hands_and_shoot, %d iterations, ms/frame\n", iterations);
+	printf("  %-10s %6s %8s %10s %8s\n", "size", "hands", "clutter", "ms", "placed");
+	for(int si=0; si<4; si++) {
+		CvSize size = sizes[si];
+		IplImage *src = cvCreateImage(size, 8, 1);
+		IplImage *mask = cvCreateImage(size, 8, 1);
+		for(int hi=0; hi<3; hi++) {
+			for(int ci=0; ci<3; ci++) {
+				SynthParams params;
+				params.size = size;
+				params.num_hands = hand_counts[hi];
+				params.num_clutter = clutter_counts[ci];
+				// hands a fraction of the frame, so every size sees the same scene
+				params.min_scale = size.height / 5;
+				params.max_scale = size.height / 3;
+				params.mask_noise = .001;
+				params.seed = 1000 + si * 100 + hi * 10 + ci;
+				SynthScene scene(params);
+				scene.render(src, NULL);
+
+				vector<Bullet*> bullets;
+				int64 ticks = 0;
+				for(int i=0; i<iterations; i++) {
+					cvCopy(src, mask);
+					int64 t = cvGetTickCount();
+					find_hands_and_shoot(mask, bullets, 6);
+					ticks += cvGetTickCount() - t;
+					for(size_t b=0; b<bullets.size(); b++) {
+						delete bullets[b];
+					}
+					bullets.clear();
+				}
+				char size_str[32];
+				sprintf(size_str, "%dx%d", size.width, size.height);
+				printf("  %-10s %6d %8d %10.3f %8d\n", size_str, hand_counts[hi],
+						clutter_counts[ci], ticks_to_ms(ticks) / iterations,
+						(int)scene.hands().size());
+			}
+		}
+		cvReleaseImage(&src);
+		cvReleaseImage(&mask);
+	}
+}
+
+bool test_synth_oracle(int scenes) {
+	CvSize size = cvSize(640, 480);
+	IplImage *mask = cvCreateImage(size, 8, 1);
+	HandDetector<DefaultHandConfig> detector;
+	SynthScore total, clutter_only;
+	vector<Hand> hands;
+	for(int s=0; s<scenes; s++) {
+		SynthParams params;
+		params.size = size;
+		params.num_hands = 1 + s % 3;
+		params.min_fingers = 0;
+		params.max_fingers = 5;
+		params.min_scale = 140;
+		params.max_scale = 260;
+		params.max_angle = 45;
+		params.num_clutter = s % 4 * 5;
+		params.mask_noise = .0005;
+		params.seed = s + 1;
+		SynthScene scene(params);
+		scene.render(mask, NULL);
+		hands.clear();
+		detector.detect(mask, hands, 6);
+		total.add(score_hands(scene.hands(), hands));
+
+		// same clutter with no hands at all -- nothing should be found
+		params.num_hands = 0;
+		SynthScene empty(params);
+		empty.render(mask, NULL);
+		hands.clear();
+		detector.detect(mask, hands, 6);
+		clutter_only.add(score_hands(empty.hands(), hands));
+	}
+
+	printf("test_synth_oracle: %d scenes %dx%d\n", scenes, size.width, size.height);
+	printf("  fingers   hands   found\n");
+	for(int f=0; f<=5; f++) {
+		printf("  %7d %7d %7d\n", f, total.hands[f], total.hands_found[f]);
+	}
+	printf("  tips matched %d of %d on found hands, %d misplaced\n",
+			total.tips_matched, total.tips_expected, total.tips_false);
+	printf("  hands on clutter: %d with hands in the scene, %d in clutter only scenes\n",
+			total.false_hands, clutter_only.false_hands);
+
+	// every spread hand should be found, and clutter blobs never are
+	bool ok = total.hands_found[5] * 10 >= total.hands[5] * 9 &&
+			total.false_hands + clutter_only.false_hands == 0;
+	printf("test_synth_oracle: %s\n", ok ? "ok" : "FAILED");
+	cvReleaseImage(&mask);
+	return ok;
+}
+
+// how far b's hands are from a's, for hands with the same bbox
+struct HandDrift {
+	int hands;
+	int tip_count_differs;
+	int defect_count_differs;
+	double tip_sum, tip_max;
+	int tips;
+	double depth_point_sum, depth_point_max;
+	int depth_points;
+
+	HandDrift()
+	: hands(0), tip_count_differs(0), defect_count_differs(0), tip_sum(0), tip_max(0),
+	  tips(0), depth_point_sum(0), depth_point_max(0), depth_points(0)
+	{}
+
+	// distance from p to the nearest of pts, added to sum / max
+	static void nearest(CvPoint p, const CvPoint *pts, int n, double& sum, double& max_d) {
+		double best = 1e9;
+		for(int i=0; i<n; i++) {
+			double dx = p.x - pts[i].x, dy = p.y - pts[i].y;
+			best = min(best, sqrt(dx * dx + dy * dy));
+		}
+		if(n > 0) {
+			sum += best;
+			max_d = max(max_d, best);
+		}
+	}
+
+	void add(const vector<Hand>& a, const vector<Hand>& b) {
+		for(size_t i=0; i<a.size(); i++) {
+			for(size_t j=0; j<b.size(); j++) {
+				if(a[i].bbox.x != b[j].bbox.x || a[i].bbox.y != b[j].bbox.y) {
+					continue;
+				}
+				hands++;
+				tip_count_differs += a[i].num_tips != b[j].num_tips;
+				defect_count_differs += a[i].num_defects != b[j].num_defects;
+				for(int t=0; t<a[i].num_tips; t++, tips++) {
+					nearest(a[i].tips[t], b[j].tips, b[j].num_tips, tip_sum, tip_max);
+				}
+				for(int t=0; t<a[i].num_defects; t++, depth_points++) {
+					nearest(a[i].depth_points[t], b[j].depth_points, b[j].num_defects,
+							depth_point_sum, depth_point_max);
+				}
+				break;
+			}
+		}
+	}
+};
+
+void bench_decimation(int iterations) {
+	CvSize sizes[] = { cvSize(640, 480), cvSize(1280, 720), cvSize(1920, 1080) };
+	const int num_scenes = 20;
+	printf("bench_decimation: hull / defects on the full contour vs simplified, "
+			"%d scenes, %d iterations\n", num_scenes, iterations);
+	for(int si=0; si<3; si++) {
+		CvSize size = sizes[si];
+		IplImage *src = cvCreateImage(size, 8, 1);
+		IplImage *mask = cvCreateImage(size, 8, 1);
+
+		// full contour, simplified with the depth points refined, simplified only
+		HandDetector<RuntimeHandConfig> detectors[3];
+		detectors[0].cfg.approx_permille = 0;
+		detectors[2].cfg.refine_depth = false;
+		const char *names[] = { "full contour", "simplified+refine", "simplified" };
+		int64 ticks[3] = { 0, 0, 0 };
+		SynthScore scores[3];
+		HandDrift drift[3];
+		int same[3] = { 0, 0, 0 };
+		vector<Hand> hands[3];
+
+		for(int s=0; s<num_scenes; s++) {
+			SynthParams params;
+			params.size = size;
+			params.num_hands = 1 + s % 4;
+			params.min_fingers = 0;
+			params.max_fingers = 5;
+			params.min_scale = size.height / 4;
+			params.max_scale = size.height / 2;
+			params.max_angle = 45;
+			params.num_clutter = 10;
+			params.mask_noise = .0005;
+			params.seed = 7000 + si * 100 + s;
+			SynthScene scene(params);
+			scene.render(src, NULL);
+			for(int i=0; i<iterations; i++) {
+				for(int d=0; d<3; d++) {
+					ticks[d] += time_detect(detectors[d], src, mask, hands[d]);
+				}
+			}
+			for(int d=0; d<3; d++) {
+				scores[d].add(score_hands(scene.hands(), hands[d]));
+				drift[d].add(hands[0], hands[d]);
+				same[d] += same_hands(hands[0], hands[d]);
+			}
+		}
+
+		printf("  %dx%d\n", size.width, size.height);
+		printf("    %-18s %9s %7s %7s %9s %14s %14s\n", "", "ms/frame", "found",
+				"tips", "same", "tip drift", "depth drift");
+		for(int d=0; d<3; d++) {
+			int found = 0, truth = 0;
+			for(int f=0; f<=5; f++) {
+				found += scores[d].hands_found[f];
+				truth += scores[d].hands[f];
+			}
+			const HandDrift& h = drift[d];
+			printf("    %-18s %9.3f %3d/%-3d %3d/%-3d %4d/%-4d %6.2f %6.2f px %6.2f %6.2f px\n",
+					names[d], ticks_to_ms(ticks[d]) / (iterations * num_scenes),
+					found, truth, scores[d].tips_matched, scores[d].tips_expected,
+					same[d], num_scenes,
+					h.tips ? h.tip_sum / h.tips : 0., h.tip_max,
+					h.depth_points ? h.depth_point_sum / h.depth_points : 0., h.depth_point_max);
+			if(d > 0 && (h.tip_count_differs || h.defect_count_differs)) {
+				printf("    %-18s %d of %d hands with other tip counts, %d other defect counts\n",
+						"", h.tip_count_differs, h.hands, h.defect_count_differs);
+			}
+		}
+		cvReleaseImage(&src);
+		cvReleaseImage(&mask);
+	}
+}
+
+void bench_hand_shape(int iterations) {
+	CvSize size = cvSize(1280, 720);
+	IplImage *src = cvCreateImage(size, 8, 1);
+	IplImage *mask = cvCreateImage(size, 8, 1);
+
+	// cost per contour: the hands and decoys of a few scenes
+	MemStorage storage;
+	vector<vector<CvPoint> > polys, contours;
+	vector<CvRect> boxes;
+	for(int s=0; s<5; s++) {
+		SynthParams params;
+		params.size = size;
+		params.num_hands = 2;
+		params.num_decoys = 3;
+		params.min_scale = 180;
+		params.max_scale = 300;
+		params.seed = 500 + s;
+		SynthScene scene(params);
+		scene.render(src, NULL);
+		cvCopy(src, mask);
+		CvSeq *first = NULL;
+		cvFindContours(mask, storage, &first, sizeof(CvContour), CV_RETR_EXTERNAL,
+				CV_CHAIN_APPROX_SIMPLE);
+		for(CvSeq *c=first; c; c=c->h_next) {
+			CvRect bb = cvBoundingRect(c);
+			double tolerance = DefaultHandConfig::approx_permille *
+					min(bb.width, bb.height) / 1000.;
+			CvSeq *poly = cvApproxPoly(c, sizeof(CvContour), storage, CV_POLY_APPROX_DP,
+					tolerance, 0);
+			contours.push_back(vector<CvPoint>(c->total));
+			cvCvtSeqToArray(c, &contours.back()[0]);
+			polys.push_back(vector<CvPoint>(poly->total));
+			cvCvtSeqToArray(poly, &polys.back()[0]);
+			boxes.push_back(bb);
+		}
+	}
+	int n = (int)polys.size();
+	long poly_pts = 0, contour_pts = 0;
+	// results go somewhere so the calls can't be dropped
+	volatile double sink = 0;
+	int64 t_poly = 0, t_contour = 0, t_raster = 0;
+	for(int i=0; i<iterations; i++) {
+		for(int k=0; k<n; k++) {
+			ShapeSignature sig;
+			int64 t = cvGetTickCount();
+			if(shape_signature(&polys[k][0], (int)polys[k].size(), &sig)) {
+				sink += open_hand_distance(sig);
+			}
+			t_poly += cvGetTickCount() - t;
+
+			t = cvGetTickCount();
+			if(shape_signature(&contours[k][0], (int)contours[k].size(), &sig)) {
+				sink += open_hand_distance(sig);
+			}
+			t_contour += cvGetTickCount() - t;
+
+			// the image moments way, a pass over the contour's box
+			t = cvGetTickCount();
+			CvMoments m;
+			CvHuMoments hu;
+			cvSetImageROI(src, boxes[k]);
+			cvMoments(src, &m, 1);
+			cvGetHuMoments(&m, &hu);
+			cvResetImageROI(src);
+			t_raster += cvGetTickCount() - t;
+			sink += hu.hu1;
+		}
+	}
+	for(int k=0; k<n; k++) {
+		poly_pts += polys[k].size();
+		contour_pts += contours[k].size();
+	}
+	double calls = (double)iterations * n;
+	printf("bench_hand_shape: %d contours at %dx%d, %d iterations\n", n,
+			size.width, size.height, iterations);
+	printf("  signature + match, simplified polygon (%4ld pts avg): %8.2f us/contour\n",
+			poly_pts / max(n, 1), ticks_to_ms(t_poly) * 1000 / calls);
+	printf("  signature + match, full contour       (%4ld pts avg): %8.2f us/contour\n",
+			contour_pts / max(n, 1), ticks_to_ms(t_contour) * 1000 / calls);
+	printf("  cvMoments over the mask in the bbox + cvGetHuMoments: %8.2f us/contour\n",
+			ticks_to_ms(t_raster) * 1000 / calls);
+
+	// false positives: scenes with decoys, with and without the shape check
+	HandDetector<RuntimeHandConfig> any_shape, checked;
+	any_shape.cfg.shape_tolerance_pct = 0;
+	checked.cfg.shape_tolerance_pct = OPEN_HAND_TOLERANCE_PCT;
+	SynthScore any_score, checked_score;
+	long dropped = 0;
+	vector<Hand> hands;
+	const int scenes = 100;
+	for(int s=0; s<scenes; s++) {
+		SynthParams params;
+		params.size = size;
+		params.num_hands = 1 + s % 3;
+		params.min_fingers = 0;
+		params.max_fingers = 5;
+		params.min_scale = 180;
+		params.max_scale = 340;
+		params.max_angle = 45;
+		params.num_clutter = 5;
+		params.num_decoys = 1 + s % 4;
+		params.mask_noise = .0005;
+		params.seed = 9000 + s;
+		SynthScene scene(params);
+		scene.render(src, NULL);
+
+		time_detect(any_shape, src, mask, hands);
+		any_score.add(score_hands(scene.hands(), hands));
+		time_detect(checked, src, mask, hands);
+		checked_score.add(score_hands(scene.hands(), hands));
+		dropped += checked.misshapen();
+	}
+	printf("  %d scenes with decoys:      5 finger hands found   hands on decoys / clutter\n",
+			scenes);
+	printf("    defects only                 %4d of %-4d          %4d\n",
+			any_score.hands_found[5], any_score.hands[5], any_score.false_hands);
+	printf("    defects + shape              %4d of %-4d          %4d  (%ld dropped)\n",
+			checked_score.hands_found[5], checked_score.hands[5], checked_score.false_hands,
+			dropped);
+
+	// the references hand_shape.cpp keeps, rendered again the way they were made
+	const vector<ShapeSignature>& refs = open_hand_references();
+	const double arm_lengths[] = { 0, .2, .4, .6, .8 };
+	const int ref_scale = 200;
+	Image ref_mask(cvSize(480, 480), 8, 1);
+	double drift = 0;
+	size_t r = 0;
+	for(int fingers=4; fingers<=5; fingers++) {
+		for(int a=0; a<5 && r<refs.size(); a++, r++) {
+			CvPoint center = cvPoint(240, 180);
+			cvZero(ref_mask);
+			draw_synth_hand(ref_mask, center, ref_scale, 0, fingers, cvScalarAll(255));
+			if(arm_lengths[a] > 0) {
+				cvLine(ref_mask, center,
+						cvPoint(center.x, center.y + int(ref_scale * arm_lengths[a])),
+						cvScalarAll(255), int(ref_scale * .22 * 1.4));
+			}
+			storage.clear();
+			CvSeq *c = NULL;
+			cvFindContours(ref_mask, storage, &c, sizeof(CvContour), CV_RETR_EXTERNAL,
+					CV_CHAIN_APPROX_SIMPLE);
+			if(!c) {
+				continue;
+			}
+			CvRect bb = cvBoundingRect(c);
+			CvSeq *poly = cvApproxPoly(c, sizeof(CvContour), storage, CV_POLY_APPROX_DP,
+					DefaultHandConfig::approx_permille * min(bb.width, bb.height) / 1000., 0);
+			vector<CvPoint> pts(poly->total);
+			cvCvtSeqToArray(poly, &pts[0]);
+			ShapeSignature sig;
+			if(shape_signature(&pts[0], poly->total, &sig)) {
+				drift = max(drift, shape_distance(sig, refs[r]));
+			}
+		}
+	}
+	printf("  kept references against rendered now: %.1f%% apart at worst%s\n", drift * 100,
+			drift * 100 > OPEN_HAND_TOLERANCE_PCT / 5. ? " -- measure them again" : "");
+
+	cvReleaseImage(&src);
+	cvReleaseImage(&mask);
+}
+
+void bench_bullet_budget(int frames) {
+	CvSize size = cvSize(1920, 1080);
+	IplImage *image = cvCreateImage(size, 8, 3);
+	// five hands held up the whole time, spread along the bottom, fingers up
+	vector<Hand> hands(5);
+	for(int h=0; h<5; h++) {
+		Hand& hand = hands[h];
+		hand.center = cvPoint(200 + h * 380, 900);
+		hand.num_tips = 10;
+		for(int t=0; t<10; t++) {
+			double a = (-160 + t * 140. / 9) * CV_PI / 180;
+			hand.tips[t] = cvPoint(hand.center.x + int(cos(a) * 150),
+					hand.center.y + int(sin(a) * 150));
+		}
+	}
+
+	BulletLimits unlimited;
+	unlimited.per_hand_frame = 0;
+	unlimited.max_rate = 0;
+	unlimited.max_live = 0;
+	unlimited.lod_live = 0;
+	BulletLimits defaults;
+	const BulletLimits *limits[] = { &unlimited, &defaults };
+	const char *names[] = { "no limits", "default limits" };
+
+	// frames come 30 a second as far as the rate limit knows
+	int64 frame_ticks = (int64)(cvGetTickFrequency() * 1e6 / 30);
+	printf("bench_bullet_budget: 5 hands x 10 tips at %dx%d, %d frames at 30 fps\n",
+			size.width, size.height, frames);
+	for(int k=0; k<2; k++) {
+		BulletBudget bullets(*limits[k]);
+		vector<Bullet*> live, fresh;
+		size_t peak = 0;
+		int64 ticks = 0, worst = 0;
+		for(int f=0; f<frames; f++) {
+			cvZero(image);
+			int64 t = cvGetTickCount();
+			for(int h=0; h<5; h++) {
+				bullets.note_held_back(fire(hands[h], fresh, NULL,
+						limits[k]->per_hand_frame));
+			}
+			bullets.admit(live, fresh, (f + 1) * frame_ticks);
+			bullets.update(live, image);
+			bullets.draw(live, image);
+			t = cvGetTickCount() - t;
+			ticks += t;
+			worst = max(worst, t);
+			peak = max(peak, live.size());
+		}
+		printf("  %-15s %8.3f ms/frame, worst %8.3f ms, peak %6ld live\n", names[k],
+				ticks_to_ms(ticks) / frames, ticks_to_ms(worst), (long)peak);
+		for(size_t i=0; i<live.size(); i++) {
+			delete live[i];
+		}
+	}
+	cvReleaseImage(&image);
+}
+
+// one pass of the idle -> hand loop for bench_idle_budget, as fingershooter's main loop
+// skip_watch -- leave watch frames out of the budget and reset it on waking (what the
+// loop does), or run it through them
+// returns the frames dropped (REUSE) out of the first after waking, and the index of
+// the first one back at FULL in *first_full (-1 if none)
+static int idle_budget_pass(const IplImage *empty_bgr, const IplImage *hand_bgr,
+		const IplImage *hand_mask, const Histogram& hist, int watch_frames,
+		int active_frames, bool skip_watch, int *first_full) {
+	LatencyBudget budget(33);
+	// straight to watch after the first frame without hands, 10 watch frames a second
+	IdleWatch idle(0, 10);
+	idle.set_hist(hist);
+	HandDetector<DefaultHandConfig> detector;
+	detector.set_budget(&budget);
+	IplImage *mask = cvCreateImage(cvGetSize(hand_mask), 8, 1);
+	vector<Hand> hands;
+
+	int dropped = 0, active = 0;
+	*first_full = -1;
+	// one frame to go idle on, the watch frames, then the hand until enough active ones
+	for(int f=0; active < active_frames && f < 1 + watch_frames + 4 * active_frames; f++) {
+		const IplImage *bgr = f <= watch_frames ? empty_bgr : hand_bgr;
+		int64 capture_ticks = cvGetTickCount();
+		bool was_watching = idle.watching();
+		bool watch_only = was_watching && !idle.check(bgr);
+		bool timed = !watch_only || !skip_watch;
+		if(timed) {
+			if(skip_watch && was_watching) {
+				budget.reset();
+			}
+			budget.start_frame(capture_ticks);
+		}
+		if(!watch_only) {
+			hands.clear();
+			if(budget.level() == LatencyBudget::REUSE) {
+				// dropped, the last hands would be shot again
+			} else if(bgr == hand_bgr) {
+				cvCopy(hand_mask, mask);
+				detector.detect(mask, hands, 6);
+			}
+			if(bgr == hand_bgr) {
+				if(budget.level() == LatencyBudget::REUSE) {
+					dropped++;
+				} else if(budget.level() == LatencyBudget::FULL && *first_full < 0) {
+					*first_full = active;
+				}
+				active++;
+			}
+			// the hand is there whether or not this frame looked for it
+			idle.frame_done(bgr == hand_bgr);
+		}
+		// the loop's wait for a key, up to the next watch frame while watching
+		usleep((watch_only ? idle.wait_ms() : 1) * 1000);
+		if(timed) {
+			budget.end_frame();
+		}
+	}
+	cvReleaseImage(&mask);
+	return dropped;
+}
+
+void bench_idle_budget(int watch_frames) {
+	CvSize size = cvSize(640, 480);
+	SynthParams params;
+	params.size = size;
+	params.num_hands = 1;
+	params.num_clutter = 0;
+	params.num_decoys = 0;
+	params.min_scale = params.max_scale = 240;
+	params.max_angle = 0;
+	params.seed = 43;
+	SynthScene scene(params);
+	IplImage *hand_bgr = cvCreateImage(size, 8, 3);
+	IplImage *hand_mask = cvCreateImage(size, 8, 1);
+	IplImage *empty_bgr = cvCreateImage(size, 8, 3);
+	scene.render(hand_mask, hand_bgr);
+	// the same background, nobody in it
+	SynthParams empty_params = params;
+	empty_params.num_hands = 0;
+	SynthScene(empty_params).render(NULL, empty_bgr);
+
+	if(scene.hands().empty()) {
+		printf("bench_idle_budget: no hand placed\n");
+	} else {
+		const SynthHand& h = scene.hands()[0];
+		int r = h.scale / 6;
+		Histogram hist = calc_hue_hist(hand_bgr,
+				cvRect(h.center.x - r, h.center.y - r, 2 * r, 2 * r));
+		int active_frames = 10;
+		printf("bench_idle_budget: 33 ms budget, %d watch frames at 10 fps, then a hand, "
+				"first %d active frames\n", watch_frames, active_frames);
+		const char *names[] = { "budget through watch", "watch left out" };
+		for(int k=0; k<2; k++) {
+			int first_full;
+			int dropped = idle_budget_pass(empty_bgr, hand_bgr, hand_mask, hist,
+					watch_frames, active_frames, k == 1, &first_full);
+			printf("  %-22s %2d dropped, first at full detail: ", names[k], dropped);
+			if(first_full < 0) {
+				printf("none\n");
+			} else {
+				printf("frame %d\n", first_full);
+			}
+		}
+	}
+	cvReleaseImage(&hand_bgr);
+	cvReleaseImage(&hand_mask);
+	cvReleaseImage(&empty_bgr);
+}
+
+// the other side of bench_hand_events -- its own mapping, as another process would have
+struct EventsReaderArg {
+	const char *name;
+	int frames;
+	vector<double> latency_us;
+	uint64_t lost;
+	bool masks_ok;
+};
+
+static void* read_hand_events(void *p) {
+	EventsReaderArg *arg = (EventsReaderArg *)p;
+	HandEventsReader r;
+	if(!he_open(&r, arg->name)) {
+		return NULL;
+	}
+	HandEventFrame f;
+	vector<unsigned char> mask(r.header->mask_bytes + 1);
+	arg->masks_ok = true;
+	uint64_t last = 0;
+	while(last + 1 < (uint64_t)arg->frames) {
+		if(he_next(&r, &f, &mask[0]) == 0) {
+			continue;
+		}
+		arg->latency_us.push_back((he_now_ns() - f.publish_ns) / 1000.);
+		// the publisher stamps the frame number into the mask, a torn read wouldn't match
+		if(f.has_mask && mask[0] != (unsigned char)f.frame) {
+			arg->masks_ok = false;
+		}
+		last = f.frame;
+	}
+	arg->lost = r.lost;
+	he_close(&r);
+	return NULL;
+}
+
+void bench_hand_events(int frames) {
+	CvSize size = cvSize(640, 480);
+	IplImage *mask = cvCreateImage(size, 8, 1);
+	vector<Hand> hands(2);
+	for(int h=0; h<2; h++) {
+		Hand& hand = hands[h];
+		hand.bbox = cvRect(100 + h * 300, 100, 200, 250);
+		hand.center = cvPoint(200 + h * 300, 250);
+		hand.num_tips = 5;
+		for(int t=0; t<5; t++) {
+			hand.tips[t] = cvPoint(hand.bbox.x + 20 + t * 40, hand.bbox.y);
+		}
+		hand.num_defects = 4;
+		for(int d=0; d<4; d++) {
+			hand.depth_points[d] = cvPoint(hand.bbox.x + 40 + d * 40, hand.bbox.y + 80);
+			hand.depths[d] = 60;
+		}
+	}
+
+	char name[64];
+	sprintf(name, "/fingershooter_bench_%d", (int)getpid());
+	printf("bench_hand_events: 2 hands, %d frames at 1 kHz, reader thread busy polling "
+			"its own mapping\n", frames);
+	for(int with_mask=0; with_mask<2; with_mask++) {
+		PublisherSettings settings;
+		settings.name = name;
+		settings.masks = with_mask;
+		HandPublisher publisher;
+		if(!publisher.open(settings, size)) {
+			break;
+		}
+		EventsReaderArg arg;
+		arg.name = name;
+		arg.frames = frames;
+		arg.lost = 0;
+		arg.masks_ok = false;
+		pthread_t reader;
+		pthread_create(&reader, NULL, read_hand_events, &arg);
+		// let it map before the first frame, it starts at whatever is already out
+		timespec pause = { 0, 20 * 1000000 };
+		nanosleep(&pause, NULL);
+
+		int64 ticks = 0;
+		timespec gap = { 0, 1000000 };
+		for(int f=0; f<frames; f++) {
+			cvSet(mask, cvScalarAll(f & 255));
+			int64 t = cvGetTickCount();
+			publisher.publish(hands, he_now_ns(), with_mask ? mask : NULL);
+			ticks += cvGetTickCount() - t;
+			nanosleep(&gap, NULL);
+		}
+		pthread_join(reader, NULL);
+
+		vector<double>& lat = arg.latency_us;
+		sort(lat.begin(), lat.end());
+		const char *what = with_mask ? "hands + 640x480 mask" : "hands only";
+		if(lat.empty()) {
+			printf("  %-22s reader got nothing\n", what);
+			continue;
+		}
+		printf("  %-22s publish %7.3f us, latency median %7.2f us, p99 %7.2f us, "
+				"max %8.2f us, %d read, %llu lost%s\n", what,
+				ticks_to_ms(ticks) * 1000 / frames, lat[lat.size() / 2],
+				lat[lat.size() * 99 / 100], lat.back(), (int)lat.size(),
+				(unsigned long long)arg.lost, arg.masks_ok ? "" : ", TORN MASKS");
+	}
+	cvReleaseImage(&mask);
+}
+
+void bench_detect_batch(int iterations) {
+	CvSize size = cvSize(640, 480);
+	const int max_k = 16;
+	// raw masks / frames, copied for every run since detection scribbles on masks
+	vector<IplImage*> src(max_k), masks(max_k), bgr(max_k);
+	for(int i=0; i<max_k; i++) {
+		SynthParams params;
+		params.size = size;
+		params.num_hands = 1 + i % 3;
+		params.min_scale = 120;
+		params.max_scale = 200;
+		params.num_clutter = 10;
+		params.num_decoys = 2;
+		params.mask_noise = .001;
+		params.bgr_noise = 4;
+		params.seed = 4000 + i;
+		SynthScene scene(params);
+		src[i] = cvCreateImage(size, 8, 1);
+		masks[i] = cvCreateImage(size, 8, 1);
+		bgr[i] = cvCreateImage(size, 8, 3);
+		scene.render(src[i], bgr[i]);
+	}
+	Histogram hist(make_test_hue_hist(bgr[0]));
+	IplImage *hue = cvCreateImage(size, 8, 1);
+
+	// one at a time, as the live loop does -- also the answers the batches must match
+	HandFinder single;
+	vector<Hand> want[max_k];
+	int64 ticks = 0;
+	for(int it=0; it<iterations; it++) {
+		for(int i=0; i<max_k; i++) {
+			cvCopy(src[i], masks[i]);
+			int64 t = cvGetTickCount();
+			single.find(masks[i], want[i], 6);
+			ticks += cvGetTickCount() - t;
+		}
+	}
+	vector<Hand> want_bgr[max_k];
+	int64 bgr_ticks = 0;
+	for(int it=0; it<iterations; it++) {
+		for(int i=0; i<max_k; i++) {
+			int64 t = cvGetTickCount();
+			bgr_to_hue(bgr[i], hue);
+			cvCalcBackProject(&hue, masks[i], hist);
+			single.find(masks[i], want_bgr[i], 6);
+			bgr_ticks += cvGetTickCount() - t;
+		}
+	}
+	int frames = iterations * max_k;
+
+	HandDetectBatch batch(0, 6);
+	printf("bench_detect_batch: %dx%d synthetic scenes, %d iterations, %d workers, ms/frame\n",
+			size.width, size.height, iterations, batch.size());
+	printf("  %-6s %10s %8s %12s %8s\n", "k", "masks", "", "bgr frames", "");
+	printf("  %-6s %10.3f %8s %12.3f %8s\n", "single", ticks_to_ms(ticks) / frames, "",
+			ticks_to_ms(bgr_ticks) / frames, "");
+	int ks[] = { 1, 4, 8, 16 };
+	vector<Hand> got[max_k];
+	for(int ki=0; ki<4; ki++) {
+		int k = ks[ki];
+		bool same = true, same_bgr = true;
+		int64 mask_ticks = 0, frame_ticks = 0;
+		for(int it=0; it<iterations; it++) {
+			for(int first=0; first<max_k; first+=k) {
+				for(int i=first; i<first+k; i++) {
+					cvCopy(src[i], masks[i]);
+				}
+				int64 t = cvGetTickCount();
+				batch.detect(&masks[first], k, &got[first]);
+				mask_ticks += cvGetTickCount() - t;
+			}
+			for(int i=0; i<max_k; i++) {
+				same = same && same_hands(got[i], want[i]);
+			}
+			for(int first=0; first<max_k; first+=k) {
+				int64 t = cvGetTickCount();
+				batch.detect_frames(&bgr[first], k, hist, &got[first]);
+				frame_ticks += cvGetTickCount() - t;
+			}
+			for(int i=0; i<max_k; i++) {
+				same_bgr = same_bgr && same_hands(got[i], want_bgr[i]);
+			}
+		}
+		printf("  %-6d %10.3f %8s %12.3f %8s\n", k, ticks_to_ms(mask_ticks) / frames,
+				same ? "same" : "DIFFER", ticks_to_ms(frame_ticks) / frames,
+				same_bgr ? "same" : "DIFFER");
+	}
+
+	for(int i=0; i<max_k; i++) {
+		cvReleaseImage(&src[i]);
+		cvReleaseImage(&masks[i]);
+		cvReleaseImage(&bgr[i]);
+	}
+	cvReleaseImage(&hue);
+}
+
+// a curl of /image -- counts the JPEGs in the stream, sleeping after each if slow
+struct StreamClientArg {
+	int fd;
+	int sleep_ms;
+	int frames;
+	long bytes;
+};
+
+static void* read_mjpeg(void *p) {
+	StreamClientArg *arg = (StreamClientArg *)p;
+	const char *request = "GET /image HTTP/1.0\r\n\r\n";
+	if(send(arg->fd, request, strlen(request), MSG_NOSIGNAL) <= 0) {
+		return NULL;
+	}
+	// headers and parts come in pieces, keep what hasn't been looked at
+	string pending;
+	long skip = 0;
+	char buf[16384];
+	while(1) {
+		ssize_t n = recv(arg->fd, buf, sizeof(buf), 0);
+		if(n <= 0) {
+			break;
+		}
+		arg->bytes += n;
+		pending.append(buf, n);
+		while(1) {
+			if(skip > 0) {
+				long used = min(skip, (long)pending.size());
+				pending.erase(0, used);
+				skip -= used;
+				if(skip > 0) {
+					break;
+				}
+				arg->frames++;
+				if(arg->sleep_ms) {
+					timespec pause = { 0, arg->sleep_ms * 1000000L };
+					nanosleep(&pause, NULL);
+				}
+			}
+			size_t at = pending.find("Content-Length: ");
+			size_t end = at == string::npos ? at : pending.find("\r\n\r\n", at);
+			if(end == string::npos) {
+				break;
+			}
+			skip = atol(pending.c_str() + at + 16);
+			pending.erase(0, end + 4);
+		}
+	}
+	return NULL;
+}
+
+void bench_mjpeg_server(int frames) {
+	CvSize size = cvSize(640, 480);
+	IplImage *image = cvCreateImage(size, 8, 3);
+	ServerSettings settings;
+	settings.port = 0;
+	MjpegServer server;
+	if(!server.start(settings)) {
+		cvReleaseImage(&image);
+		return;
+	}
+	// three keeping up, one reading a frame every 200 ms through a small buffer
+	const int num_clients = 4;
+	StreamClientArg clients[num_clients];
+	pthread_t threads[num_clients];
+	sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(server.port());
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	for(int i=0; i<num_clients; i++) {
+		StreamClientArg& c = clients[i];
+		c.fd = socket(AF_INET, SOCK_STREAM, 0);
+		c.sleep_ms = i == num_clients - 1 ? 200 : 0;
+		c.frames = 0;
+		c.bytes = 0;
+		if(c.sleep_ms) {
+			int small = 16 * 1024;
+			setsockopt(c.fd, SOL_SOCKET, SO_RCVBUF, &small, sizeof(small));
+		}
+		connect(c.fd, (sockaddr *)&addr, sizeof(addr));
+		pthread_create(&threads[i], NULL, read_mjpeg, &c);
+	}
+	// until they've all asked
+	for(int tries=0; tries<100 && !server.wants(STREAM_IMAGE); tries++) {
+		timespec pause = { 0, 10 * 1000000 };
+		nanosleep(&pause, NULL);
+	}
+	timespec pause = { 0, 100 * 1000000 };
+	nanosleep(&pause, NULL);
+
+	printf("bench_mjpeg_server: %dx%d, %d frames at 30 fps, %d clients, the last slow\n",
+			size.width, size.height, frames, num_clients);
+	int64 ticks = 0, worst = 0;
+	timespec gap = { 0, 1000000000 / 30 };
+	for(int f=0; f<frames; f++) {
+		// something that changes and compresses like a frame would
+		cvSet(image, cvScalar(f * 3 & 255, 90, 160));
+		cvCircle(image, cvPoint(f * 7 % size.width, size.height / 2), 60,
+				cvScalar(40, 200, 255), -1);
+		int64 t = cvGetTickCount();
+		server.offer(STREAM_IMAGE, image);
+		t = cvGetTickCount() - t;
+		ticks += t;
+		worst = max(worst, t);
+		nanosleep(&gap, NULL);
+	}
+	printf("  offer on the loop: %.3f ms mean, %.3f ms worst\n", ticks_to_ms(ticks) / frames,
+			ticks_to_ms(worst));
+	server.print_stats();
+	for(int i=0; i<num_clients; i++) {
+		shutdown(clients[i].fd, SHUT_RDWR);
+		pthread_join(threads[i], NULL);
+		close(clients[i].fd);
+		printf("  client %d%s: %d frames, %ld KB\n", i, clients[i].sleep_ms ? " (slow)" : "",
+				clients[i].frames, clients[i].bytes / 1024);
+	}
+	cvReleaseImage(&image);
+}
+
+struct Benchmark {
+	const char *name;
+	// false if a check it makes failed
+	bool (*run)();
+};
+
+static bool run_hand_detector() { bench_hand_detector(); return true; }
+static bool run_backproject() { bench_backproject(); return true; }
+static bool run_tile_pipeline() { bench_tile_pipeline(); return true; }
+static bool run_parallel_contours() { bench_parallel_contours(); return true; }
+static bool run_motion_gate() { return bench_motion_gate(); }
+static bool run_yuv_ingest() { bench_yuv_ingest(); return true; }
+static bool run_hue_kernel() {
+	bool ok = test_hue_kernel();
+	bench_hue_kernel();
+	return ok;
+}
+static bool run_synth() {
+	bool ok = test_synth_oracle();
+	bench_synth_scaling();
+	return ok;
+}
+static bool run_decimation() { bench_decimation(); return true; }
+static bool run_hand_shape() { bench_hand_shape(); return true; }
+static bool run_bullet_budget() { bench_bullet_budget(); return true; }
+static bool run_idle_budget() { bench_idle_budget(); return true; }
+static bool run_hand_events() { bench_hand_events(); return true; }
+static bool run_detect_batch() { bench_detect_batch(); return true; }
+static bool run_mjpeg_server() { bench_mjpeg_server(); return true; }
+static bool run_pixel_kernels() {
+	bool ok = test_pixel_kernels();
+	bench_pixel_kernels();
+	return ok;
+}
+
+static Benchmark benchmarks[] = {
+	{ "detector", run_hand_detector },
+	{ "backproject", run_backproject },
+	{ "tiles", run_tile_pipeline },
+	{ "contours", run_parallel_contours },
+	{ "motion", run_motion_gate },
+	{ "yuv", run_yuv_ingest },
+	{ "hue", run_hue_kernel },
+	{ "synth", run_synth },
+	{ "decimate", run_decimation },
+	{ "shape", run_hand_shape },
+	{ "bullets", run_bullet_budget },
+	{ "idle", run_idle_budget },
+	{ "shm", run_hand_events },
+	{ "batch", run_detect_batch },
+	{ "mjpeg", run_mjpeg_server },
+	{ "simd", run_pixel_kernels },
+};
+
+bool run_benchmarks(const char *name) {
+	bool all = name == NULL || strcmp(name, "all") == 0;
+	bool found = false, passed = true;
+	for(size_t i=0; i<sizeof(benchmarks)/sizeof(benchmarks[0]); i++) {
+		if(all || strcmp(name, benchmarks[i].name) == 0) {
+			// the rest still run after a failure, so one run shows every one
+			if(!benchmarks[i].run()) {
+				printf("%s: FAILED\n", benchmarks[i].name);
+				passed = false;
+			}
+			found = true;
+		}
+	}
+	if(!found) {
+		printf("no benchmark named %s, have:", name);
+		for(size_t i=0; i<sizeof(benchmarks)/sizeof(benchmarks[0]); i++) {
+			printf(" %s", benchmarks[i].name);
+		}
+		printf("\n");
+	}
+	return found && passed;
+}
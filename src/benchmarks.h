@@ -0,0 +1,109 @@
+/*
+ * benchmarks.h
+ *
+ * Timing runs for the detector pieces, run with
+ * 	fingershooter --bench [name]
+ * with no name, all of them run.  Results are printed with printf.
+ * Implementation in benchmarks.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef BENCHMARKS_H_
+#define BENCHMARKS_H_
+
+#include "cv.h"
+#include "trace.h"
+
+// runs the named benchmark, or all of them if name is NULL or "all"
+// returns false if there is no benchmark by that name, or a check one makes failed
+// (the tests run alongside, eg test_pixel_kernels), so the exit status shows it
+bool run_benchmarks(const char *name = NULL);
+
+// HandDetector<DefaultHandConfig> vs HandDetector<RuntimeHandConfig> on the same mask
+void bench_hand_detector(int iterations = 500);
+
+// hue only cvCalcBackProject vs 2D hue/sat cvCalcBackProject vs HueSatLut
+void bench_backproject(int iterations = 200);
+
+// whole frame per-pixel stages vs TilePipeline at a few tile sizes, 1 worker and all
+void bench_tile_pipeline(int iterations = 100);
+
+// serial vs TaskPool contour analysis on a crowded mask (many hands and blobs)
+void bench_parallel_contours(int iterations = 200);
+
+// MotionGate::update cost on still and moving frames, and contours reused by the
+// detector when only one of two hands moves -- false if a slow drift is never seen or
+// the gated detector's hands differ from the plain one's
+bool bench_motion_gate(int iterations = 500);
+
+// camera YUV (YUYV and NV12) to mask: converting to BGR and backprojecting hue vs
+// UvSkinLut straight from chroma, and how often the two masks disagree
+void bench_yuv_ingest(int iterations = 200);
+
+// cvCvtColor + cvSplit vs bgr_to_hue for the hue plane
+void bench_hue_kernel(int iterations = 200);
+
+// bgr_to_hue against cvCvtColor's H channel over all 2^24 colours, and on row
+// lengths that leave a scalar tail -- prints and returns false on any mismatch
+bool test_hue_kernel();
+
+// find_hands_and_shoot over synthetic scenes (synth_scene.h) at a range of
+// resolutions, hand counts and clutter levels
+void bench_synth_scaling(int iterations = 50);
+
+// HandDetector against synthetic scene ground truth: open hands found by finger
+// count, tips placed, hands reported on clutter -- false if 5 finger hands are missed
+// or clutter is taken for a hand
+bool test_synth_oracle(int scenes = 200);
+
+// HandDetector with hull and defects on the full contour vs the simplified one, with
+// and without the depth points refined, over synthetic scenes at 480p to 1080p: time,
+// hands and tips against the truth, and how far tips and depth points moved
+void bench_decimation(int iterations = 20);
+
+// hand_shape.h's check per contour -- on simplified polygons, on full contours, and
+// cvMoments over the mask for comparison -- and hands / false hands on scenes with
+// decoys, with and without the shape check
+void bench_hand_shape(int iterations = 200);
+
+// bullets from five hands held up for a while: time to spawn, move and draw them
+// per frame and how many pile up, without limits and with BulletBudget's defaults
+void bench_bullet_budget(int frames = 300);
+
+// the latency budget across an idle watch: watch frames of an empty scene, then a hand
+// walks in -- frames dropped and how soon detection is back at full detail once awake,
+// with the budget running through the watch's waits and with them left out
+void bench_idle_budget(int watch_frames = 10);
+
+// hands published into shared memory and read back by a thread with its own mapping,
+// with and without the backprojection: publish cost, publish to read latency
+// (median, p99, max) and frames the reader lost
+void bench_hand_events(int frames = 2000);
+
+// HandDetectBatch on 16 synthetic scenes, k = 1, 4, 8, 16 at a time, masks and BGR frames,
+// against a HandFinder one frame at a time: ms per frame and whether the hands match
+void bench_detect_batch(int iterations = 20);
+
+// MjpegServer's /image to four local clients, one of them slow: what offer costs the
+// loop, frames encoded against frames offered, and how many each client got
+void bench_mjpeg_server(int frames = 150);
+
+// every SIMD level's row kernels (pixel_kernels.h) against the scalar ones on random
+// rows of every tail length and on all 2^24 colours, then threshold_binary,
+// open_close_3x3 and HueLut against cvThreshold, cvMorphologyEx and cvCalcBackProject
+// at each level -- prints and returns false on any mismatch
+bool test_pixel_kernels();
+
+// the pixel stages of a 720p frame and a screenful of bullets at each supported SIMD
+// level, and the OpenCV calls they replace
+void bench_pixel_kernels(int iterations = 200);
+
+// draws a crude white open hand into mask (1 channel) -- palm plus five spread fingers
+// center -- palm center, scale -- roughly the hand's height in pixels
+// (draw_synth_hand with no rotation)
+void draw_test_hand(IplImage *mask, CvPoint center, int scale);
+
+// ticks_to_ms is in trace.h, with the rest of the timing the library does
+
+#endif /* BENCHMARKS_H_ */
@@ -13,16 +13,17 @@
 
 
 	Bullet::Bullet()
-	: pos(cvPoint(0,0)), velocity(cvPoint(0,0)),
-	  color(CV_RGB(255, 0, 0)), radius(5)
+	: pos(cvPoint(0,0)), color(CV_RGB(255, 0, 0)),
+	  velocity(cvPoint(0,0)), radius(5), age(0)
 	  {}
 	Bullet::Bullet(CvPoint position, CvPoint _velocity, CvScalar _color, int _radius)
-	: pos(position), velocity(_velocity),
-	  color(_color), radius(_radius)
+	: pos(position), color(_color),
+	  velocity(_velocity), radius(_radius), age(0)
 	  {}
 	void Bullet::update(){
 		pos.x += velocity.x;
 		pos.y += velocity.y;
+		age++;
 	}
 	void Bullet::print() {
 		printf("bullet:  pos: (%d, %d),\tvel: (%d, %d)\n",
@@ -22,6 +22,8 @@ public:
 	CvScalar color;
 	CvPoint velocity;
 	int radius;
+	// frames since it was fired
+	int age;
 
 	Bullet();
 	Bullet(CvPoint position, CvPoint _velocity, CvScalar _color, int _radius);
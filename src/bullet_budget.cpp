@@ -0,0 +1,175 @@
+/*
+ * bullet_budget.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "bullet_budget.h"
+#include "benchmarks.h"
+#include "pixel_kernels.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+using namespace std;
+
+static const char *detail_names[] = { "full", "points", "skip old" };
+
+// most a second's rate the bucket holds, so a pause doesn't save up a flood
+#define RATE_BURST_SECS .25
+
+BulletLimits::BulletLimits()
+: per_hand_frame(10), max_rate(1200), max_live(3000), lod_age(8), lod_live(1000)
+{}
+
+bool parse_bullet_limits(const char *spec, BulletLimits *limits) {
+	// per_hand_frame:rate:live, empty parts keep their defaults
+	const char *parts[3] = { spec, NULL, NULL };
+	for(int i=1; i<3 && parts[i-1]; i++) {
+		const char *colon = strchr(parts[i-1], ':');
+		parts[i] = colon ? colon + 1 : NULL;
+	}
+	double values[3];
+	for(int i=0; i<3; i++) {
+		if(!parts[i] || *parts[i] == ':' || *parts[i] == 0) {
+			values[i] = -1;
+			continue;
+		}
+		char *end;
+		values[i] = strtod(parts[i], &end);
+		if(end == parts[i] || (*end != ':' && *end != 0) || values[i] < 0) {
+			return false;
+		}
+	}
+	if(values[0] >= 0) {
+		limits->per_hand_frame = (int)values[0];
+	}
+	if(values[1] >= 0) {
+		limits->max_rate = values[1];
+	}
+	if(values[2] >= 0) {
+		limits->max_live = (int)values[2];
+	}
+	return true;
+}
+
+BulletBudget::BulletBudget(const BulletLimits& limits)
+: lim(limits), tokens(limits.max_rate * RATE_BURST_SECS), last_ticks(0),
+  frames(0), held_back(0), spawned(0), rate_dropped(0), rate_frames(0), evicted(0), evict_frames(0),
+  drawn_points(0), skipped(0), peak_live(0)
+{
+	for(int i=0; i<NUM_DETAILS; i++) {
+		detail_frames[i] = 0;
+	}
+}
+
+void BulletBudget::admit(vector<Bullet*>& live, vector<Bullet*>& fresh, int64 now) {
+	frames++;
+	int n = (int)fresh.size();
+	int allowed = n;
+	if(lim.max_rate > 0) {
+		if(now == 0) {
+			now = cvGetTickCount();
+		}
+		if(last_ticks) {
+			tokens += lim.max_rate * ticks_to_ms(now - last_ticks) / 1000.;
+			tokens = min(tokens, lim.max_rate * RATE_BURST_SECS);
+		}
+		last_ticks = now;
+		allowed = min(n, (int)tokens);
+		tokens -= allowed;
+	}
+	if(allowed < n) {
+		rate_dropped += n - allowed;
+		rate_frames++;
+	}
+	// spread what's allowed evenly so every hand keeps some of its bullets
+	for(int i=0; i<n; i++) {
+		if((long)(i + 1) * allowed / n > (long)i * allowed / n) {
+			live.push_back(fresh[i]);
+		} else {
+			delete fresh[i];
+		}
+	}
+	spawned += allowed;
+	fresh.clear();
+
+	if(lim.max_live > 0 && (int)live.size() > lim.max_live) {
+		int excess = (int)live.size() - lim.max_live;
+		for(int i=0; i<excess; i++) {
+			delete live[i];
+		}
+		live.erase(live.begin(), live.begin() + excess);
+		evicted += excess;
+		evict_frames++;
+	}
+	peak_live = max(peak_live, live.size());
+}
+
+void BulletBudget::update(vector<Bullet*>& live, const IplImage *image) {
+	// compacted in place, oldest stay first
+	size_t kept = 0;
+	for(size_t i=0; i<live.size(); i++) {
+		Bullet *b = live[i];
+		b->update();
+		if(b->pos.x <= 0 || b->pos.x >= image->width ||
+				b->pos.y <= 0 || b->pos.y >= image->height) {
+			delete b;
+		} else {
+			live[kept++] = b;
+		}
+	}
+	live.resize(kept);
+}
+
+void BulletBudget::draw(const vector<Bullet*>& live, IplImage *image,
+		const LatencyBudget *budget) {
+	Detail detail = DETAIL_FULL;
+	if(budget && budget->over()) {
+		detail = DETAIL_SKIP;
+	} else if((budget && budget->level() != LatencyBudget::FULL) ||
+			(lim.lod_live > 0 && (int)live.size() > lim.lod_live)) {
+		detail = DETAIL_POINTS;
+	}
+	detail_frames[detail]++;
+
+	for(size_t i=0; i<live.size(); i++) {
+		const Bullet *b = live[i];
+		// young, full size bullets near their hand always get the full circle
+		bool minor = b->age > lim.lod_age || b->radius <= 2;
+		if(detail == DETAIL_FULL || !minor) {
+			if(image->nChannels == 3) {
+				// spans through the SIMD row fill (pixel_kernels.h)
+				fill_circle(image, b->pos, b->radius, b->color);
+			} else {
+				cvCircle(image, b->pos, b->radius, b->color, CV_FILLED);
+			}
+		} else if(detail == DETAIL_POINTS) {
+			// update() keeps them inside the image
+			uchar *px = (uchar *)(image->imageData + b->pos.y * image->widthStep) +
+					b->pos.x * image->nChannels;
+			for(int c=0; c<image->nChannels && c<3; c++) {
+				px[c] = (uchar)b->color.val[c];
+			}
+			drawn_points++;
+		} else {
+			skipped++;
+		}
+	}
+}
+
+void BulletBudget::print_stats() const {
+	printf("BulletBudget: %ld frames, %ld bullets spawned, peak %ld live "
+			"(limits %d per hand per frame, %.0f/s, %d live)\n", frames, spawned,
+			(long)peak_live, lim.per_hand_frame, lim.max_rate, lim.max_live);
+	printf("  per hand cap: %ld held back\n", held_back);
+	printf("  rate limit:   %ld dropped in %ld frames\n", rate_dropped, rate_frames);
+	printf("  live cap:     %ld evicted in %ld frames\n", evicted, evict_frames);
+	printf("  detail:");
+	for(int i=0; i<NUM_DETAILS; i++) {
+		printf(" %s %ld,", detail_names[i], detail_frames[i]);
+	}
+	printf(" %ld drawn as points, %ld skipped\n", drawn_points, skipped);
+}
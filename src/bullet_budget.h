@@ -0,0 +1,98 @@
+/*
+ * bullet_budget.h
+ *
+ * Keeps the bullets from taking over the frame.  Every hand fires from every
+ * fingertip every frame, so a few hands held up for a few seconds would otherwise
+ * pile up tens of thousands of bullets, and moving and drawing them becomes the
+ * frame.  BulletBudget limits them at each step:
+ *
+ * 	spawn     a cap per hand per frame (the caller passes limits().per_hand_frame to
+ * 	          find_hands_and_shoot, it isn't a rate -- there's no hand tracking to hang
+ * 	          one on) and a global rate in bullets per second, a token bucket so short
+ * 	          bursts still get out
+ * 	live      a hard cap, the oldest bullets go first
+ * 	drawing   level of detail -- under load (latency budget degrading, or a lot of
+ * 	          bullets), bullets that have flown a while are single pixels, and when the
+ * 	          frame is already over its budget they're skipped
+ *
+ * Every limit counts what it held back, so print_stats shows when throttling kicked in.
+ * Implementation in bullet_budget.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef BULLET_BUDGET_H_
+#define BULLET_BUDGET_H_
+
+#include "cv.h"
+#include <vector>
+
+#include "bullet.h"
+#include "latency_budget.h"
+
+struct BulletLimits {
+	BulletLimits();
+
+	// bullets per hand each frame, 0 for one per fingertip -- a cap on one frame's
+	// fire, not a rate, max_rate is the only one
+	int per_hand_frame;
+	// new bullets per second over all hands, 0 for no limit
+	double max_rate;
+	// live bullets, 0 for no cap
+	int max_live;
+	// under load, bullets older than this many frames (or of radius 2 or less) are
+	// points, or skipped
+	int lod_age;
+	// more live bullets than this is load even without a latency budget
+	int lod_live;
+};
+
+// "per_hand_frame:rate:live", eg "5:600:2000", any part may be empty for its default
+bool parse_bullet_limits(const char *spec, BulletLimits *limits);
+
+class BulletBudget {
+public:
+	enum Detail { DETAIL_FULL, DETAIL_POINTS, DETAIL_SKIP, NUM_DETAILS };
+
+	BulletBudget(const BulletLimits& limits = BulletLimits());
+
+	// moves the frame's new bullets (fresh) into live as the rate allows, deletes the
+	// rest, then evicts the oldest live bullets past the cap
+	// live -- oldest first, new ones are appended
+	// now -- [0] cvGetTickCount time of the frame, 0 to read the clock
+	void admit(std::vector<Bullet*>& live, std::vector<Bullet*>& fresh, int64 now = 0);
+
+	// moves every bullet, deletes those that left the image, keeps the order
+	void update(std::vector<Bullet*>& live, const IplImage *image);
+
+	// draws at the level of detail the load calls for
+	// budget -- [NULL] the frame's latency budget if there is one
+	void draw(const std::vector<Bullet*>& live, IplImage *image,
+			const LatencyBudget *budget = NULL);
+
+	// fingertips find_hands_and_shoot / shoot_last_hands held back by per_hand_frame
+	void note_held_back(int tips) { held_back += tips; }
+
+	const BulletLimits& limits() const { return lim; }
+	void print_stats() const;
+
+private:
+	BulletLimits lim;
+	// token bucket for the global rate
+	double tokens;
+	int64 last_ticks;
+
+	long frames;
+	long held_back;
+	long spawned;
+	long rate_dropped;
+	long rate_frames;
+	long evicted;
+	long evict_frames;
+	long detail_frames[NUM_DETAILS];
+	long drawn_points;
+	long skipped;
+	size_t peak_live;
+};
+
+#endif /* BULLET_BUDGET_H_ */
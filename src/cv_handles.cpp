@@ -0,0 +1,172 @@
+/*
+ * cv_handles.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "cv_handles.h"
+
+#include <cstdio>
+
+static const char *kind_names[] = { "images", "histograms", "storages" };
+
+// updated with gcc atomics, any thread may allocate
+static long live[NUM_ALLOC_KINDS];
+static long live_bytes[NUM_ALLOC_KINDS];
+static long peak_bytes[NUM_ALLOC_KINDS];
+static long total[NUM_ALLOC_KINDS];
+static long all_live_bytes;
+static long all_peak_bytes;
+
+// raises *peak to value if it's higher
+static void raise_peak(long *peak, long value) {
+	long seen = *peak;
+	while(value > seen) {
+		long prev = __sync_val_compare_and_swap(peak, seen, value);
+		if(prev == seen) {
+			break;
+		}
+		seen = prev;
+	}
+}
+
+void track_alloc(AllocKind kind, long bytes) {
+	if(bytes > 0) {
+		__sync_fetch_and_add(&live[kind], 1);
+		__sync_fetch_and_add(&total[kind], 1);
+	} else {
+		__sync_fetch_and_sub(&live[kind], 1);
+	}
+	raise_peak(&peak_bytes[kind], __sync_add_and_fetch(&live_bytes[kind], bytes));
+	raise_peak(&all_peak_bytes, __sync_add_and_fetch(&all_live_bytes, bytes));
+}
+
+AllocStats alloc_stats(AllocKind kind) {
+	AllocStats s;
+	s.live = live[kind];
+	s.live_bytes = live_bytes[kind];
+	s.peak_bytes = peak_bytes[kind];
+	s.total = total[kind];
+	return s;
+}
+
+long alloc_live_bytes() {
+	return all_live_bytes;
+}
+
+long alloc_peak_bytes() {
+	return all_peak_bytes;
+}
+
+void print_alloc_report() {
+	printf("Allocations: %.1f KB live, %.1f KB peak\n", all_live_bytes / 1024.,
+			all_peak_bytes / 1024.);
+	for(int k=0; k<NUM_ALLOC_KINDS; k++) {
+		AllocStats s = alloc_stats(AllocKind(k));
+		printf("  %-10s %5ld live %10.1f KB, peak %10.1f KB, %ld allocated since start\n",
+				kind_names[k], s.live, s.live_bytes / 1024., s.peak_bytes / 1024., s.total);
+	}
+}
+
+// what an image holds, header and pixels
+static long image_bytes(const IplImage *img) {
+	return (long)sizeof(IplImage) + img->imageSize;
+}
+
+IplImage* Image::ensure(CvSize size, int depth, int channels) {
+	if(!img || img->width != size.width || img->height != size.height ||
+			img->depth != depth || img->nChannels != channels) {
+		reset(cvCreateImage(size, depth, channels));
+	}
+	return img;
+}
+
+void Image::reset(IplImage *adopt) {
+	if(img) {
+		track_alloc(ALLOC_IMAGE, -image_bytes(img));
+		cvReleaseImage(&img);
+	}
+	img = adopt;
+	if(img) {
+		track_alloc(ALLOC_IMAGE, image_bytes(img));
+	}
+}
+
+IplImage* Image::release() {
+	IplImage *out = img;
+	if(img) {
+		track_alloc(ALLOC_IMAGE, -image_bytes(img));
+		img = NULL;
+	}
+	return out;
+}
+
+Image Image::clone() const {
+	return Image(img ? cvCloneImage(img) : NULL);
+}
+
+// bins as floats, dense histograms only
+static long hist_bytes(const CvHistogram *hist) {
+	int sizes[CV_MAX_DIM];
+	int dims = cvGetDims(hist->bins, sizes);
+	long bins = 1;
+	for(int i=0; i<dims; i++) {
+		bins *= sizes[i];
+	}
+	return (long)sizeof(CvHistogram) + bins * (long)sizeof(float);
+}
+
+void Histogram::reset(CvHistogram *adopt) {
+	if(hist) {
+		track_alloc(ALLOC_HIST, -hist_bytes(hist));
+		cvReleaseHist(&hist);
+	}
+	hist = adopt;
+	if(hist) {
+		track_alloc(ALLOC_HIST, hist_bytes(hist));
+	}
+}
+
+CvHistogram* Histogram::release() {
+	CvHistogram *out = hist;
+	if(hist) {
+		track_alloc(ALLOC_HIST, -hist_bytes(hist));
+		hist = NULL;
+	}
+	return out;
+}
+
+Histogram Histogram::copy() const {
+	CvHistogram *dst = NULL;
+	if(hist) {
+		cvCopyHist(hist, &dst);
+	}
+	return Histogram(dst);
+}
+
+// storages grow by blocks as they're used, only the first block is counted
+MemStorage::MemStorage(int block_size)
+: storage(cvCreateMemStorage(block_size))
+{
+	track_alloc(ALLOC_STORAGE, storage->block_size);
+}
+
+MemStorage& MemStorage::operator=(MemStorage&& other) {
+	if(this != &other) {
+		destroy();
+		storage = other.storage;
+		other.storage = NULL;
+	}
+	return *this;
+}
+
+MemStorage::~MemStorage() {
+	destroy();
+}
+
+void MemStorage::destroy() {
+	if(storage) {
+		track_alloc(ALLOC_STORAGE, -storage->block_size);
+		cvReleaseMemStorage(&storage);
+	}
+}
@@ -0,0 +1,129 @@
+/*
+ * cv_handles.h
+ *
+ * Owning handles for the OpenCV C structs that get passed between stages, so nobody
+ * has to remember which cvRelease* goes with what:
+ *
+ * 	Image       IplImage
+ * 	Histogram   CvHistogram
+ * 	MemStorage  CvMemStorage
+ *
+ * Each releases what it holds when it goes out of scope, and is move only -- a buffer
+ * is handed to the next stage (returned, stored in a worker's scratch, ...) by
+ * std::move, never copied by accident.  get() or the implicit conversion gives the
+ * raw pointer for the cv* calls; the handle keeps ownership.
+ *
+ * Everything the handles allocate is counted by kind, live and peak, so memory creep
+ * in long runs shows up -- see print_alloc_report().
+ * Implementation in cv_handles.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef CV_HANDLES_H_
+#define CV_HANDLES_H_
+
+#include "cv.h"
+
+enum AllocKind { ALLOC_IMAGE, ALLOC_HIST, ALLOC_STORAGE, NUM_ALLOC_KINDS };
+
+struct AllocStats {
+	long live;
+	long live_bytes;
+	long peak_bytes;
+	// allocations since startup
+	long total;
+};
+
+// bytes > 0 for an allocation, < 0 for a release -- thread safe
+void track_alloc(AllocKind kind, long bytes);
+AllocStats alloc_stats(AllocKind kind);
+// all kinds together
+long alloc_live_bytes();
+long alloc_peak_bytes();
+// live buffers and bytes by kind, with peaks
+void print_alloc_report();
+
+class Image {
+public:
+	Image() : img(NULL) {}
+	Image(CvSize size, int depth, int channels) : img(NULL) { ensure(size, depth, channels); }
+	// takes ownership of an image made elsewhere, eg by cvLoadImage or cvCloneImage
+	explicit Image(IplImage *adopt) : img(NULL) { reset(adopt); }
+	Image(Image&& other) : img(other.img) { other.img = NULL; }
+	Image& operator=(Image&& other) {
+		if(this != &other) {
+			reset(other.release());
+		}
+		return *this;
+	}
+	Image(const Image&) = delete;
+	Image& operator=(const Image&) = delete;
+	~Image() { reset(); }
+
+	// allocates, or reallocates if the size or format differs, returns the image
+	IplImage* ensure(CvSize size, int depth, int channels);
+	// releases what's held and takes adopt (may be NULL)
+	void reset(IplImage *adopt = NULL);
+	// gives up ownership without releasing
+	IplImage* release();
+	Image clone() const;
+
+	IplImage* get() const { return img; }
+	operator IplImage*() const { return img; }
+	IplImage* operator->() const { return img; }
+
+private:
+	IplImage *img;
+};
+
+class Histogram {
+public:
+	Histogram() : hist(NULL) {}
+	// takes ownership, eg of cvCreateHist's result
+	explicit Histogram(CvHistogram *adopt) : hist(NULL) { reset(adopt); }
+	Histogram(Histogram&& other) : hist(other.hist) { other.hist = NULL; }
+	Histogram& operator=(Histogram&& other) {
+		if(this != &other) {
+			reset(other.release());
+		}
+		return *this;
+	}
+	Histogram(const Histogram&) = delete;
+	Histogram& operator=(const Histogram&) = delete;
+	~Histogram() { reset(); }
+
+	void reset(CvHistogram *adopt = NULL);
+	CvHistogram* release();
+	// cvCopyHist into a new handle, eg one per worker
+	Histogram copy() const;
+
+	CvHistogram* get() const { return hist; }
+	operator CvHistogram*() const { return hist; }
+	CvHistogram* operator->() const { return hist; }
+
+private:
+	CvHistogram *hist;
+};
+
+class MemStorage {
+public:
+	// block_size -- as cvCreateMemStorage, 0 for the default
+	explicit MemStorage(int block_size = 0);
+	MemStorage(MemStorage&& other) : storage(other.storage) { other.storage = NULL; }
+	MemStorage& operator=(MemStorage&& other);
+	MemStorage(const MemStorage&) = delete;
+	MemStorage& operator=(const MemStorage&) = delete;
+	~MemStorage();
+
+	void clear() { cvClearMemStorage(storage); }
+
+	CvMemStorage* get() const { return storage; }
+	operator CvMemStorage*() const { return storage; }
+
+private:
+	void destroy();
+	CvMemStorage *storage;
+};
+
+#endif /* CV_HANDLES_H_ */
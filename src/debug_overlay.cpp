@@ -0,0 +1,214 @@
+/*
+ * debug_overlay.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "debug_overlay.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+using namespace std;
+
+// past this many separate dirty rects, just use their union
+#define MAX_DIRTY_RECTS 16
+
+static CvRect rect_union(CvRect a, CvRect b) {
+	int x1 = min(a.x, b.x);
+	int y1 = min(a.y, b.y);
+	int x2 = max(a.x + a.width, b.x + b.width);
+	int y2 = max(a.y + a.height, b.y + b.height);
+	return cvRect(x1, y1, x2 - x1, y2 - y1);
+}
+
+// true if the rects overlap or touch
+static bool rects_touch(CvRect a, CvRect b) {
+	return a.x <= b.x + b.width && b.x <= a.x + a.width &&
+			a.y <= b.y + b.height && b.y <= a.y + a.height;
+}
+
+// clip r to the image, returns false if nothing is left
+static bool clip_rect(CvRect& r, IplImage *img) {
+	int x1 = max(r.x, 0);
+	int y1 = max(r.y, 0);
+	int x2 = min(r.x + r.width, img->width);
+	int y2 = min(r.y + r.height, img->height);
+	if(x2 <= x1 || y2 <= y1) {
+		return false;
+	}
+	r = cvRect(x1, y1, x2 - x1, y2 - y1);
+	return true;
+}
+
+DebugOverlay::DebugOverlay()
+: last_target(NULL), needs_full_clear(true), scale(1)
+{}
+
+void DebugOverlay::clear() {
+	commands.clear();
+	points.clear();
+	pending.clear();
+}
+
+void DebugOverlay::invalidate() {
+	needs_full_clear = true;
+}
+
+void DebugOverlay::polygon(const CvPoint *pts, int n, CvScalar color, int thickness) {
+	if(n <= 0) {
+		return;
+	}
+	Command cmd;
+	cmd.type = POLYGON;
+	cmd.color = color;
+	cmd.thickness = thickness;
+	cmd.p1 = cvPoint((int)points.size(), n);
+	int x1 = pts[0].x, y1 = pts[0].y, x2 = pts[0].x, y2 = pts[0].y;
+	for(int i=0; i<n; i++) {
+		points.push_back(cvPoint(pts[i].x * scale, pts[i].y * scale));
+		x1 = min(x1, pts[i].x);
+		y1 = min(y1, pts[i].y);
+		x2 = max(x2, pts[i].x);
+		y2 = max(y2, pts[i].y);
+	}
+	push(cmd, cvRect(x1 * scale, y1 * scale, (x2 - x1) * scale, (y2 - y1) * scale));
+}
+
+void DebugOverlay::rect(CvPoint p1, CvPoint p2, CvScalar color, int thickness) {
+	p1 = cvPoint(p1.x * scale, p1.y * scale);
+	p2 = cvPoint(p2.x * scale, p2.y * scale);
+	Command cmd;
+	cmd.type = RECT;
+	cmd.color = color;
+	cmd.thickness = thickness;
+	cmd.p1 = p1;
+	cmd.p2 = p2;
+	push(cmd, cvRect(min(p1.x, p2.x), min(p1.y, p2.y),
+			abs(p2.x - p1.x), abs(p2.y - p1.y)));
+}
+
+void DebugOverlay::circle(CvPoint center, int radius, CvScalar color, int thickness) {
+	center = cvPoint(center.x * scale, center.y * scale);
+	Command cmd;
+	cmd.type = CIRCLE;
+	cmd.color = color;
+	cmd.thickness = thickness;
+	cmd.p1 = center;
+	cmd.radius = radius;
+	push(cmd, cvRect(center.x - radius, center.y - radius, 2*radius, 2*radius));
+}
+
+void DebugOverlay::line(CvPoint p1, CvPoint p2, CvScalar color, int thickness) {
+	p1 = cvPoint(p1.x * scale, p1.y * scale);
+	p2 = cvPoint(p2.x * scale, p2.y * scale);
+	Command cmd;
+	cmd.type = LINE;
+	cmd.color = color;
+	cmd.thickness = thickness;
+	cmd.p1 = p1;
+	cmd.p2 = p2;
+	push(cmd, cvRect(min(p1.x, p2.x), min(p1.y, p2.y),
+			abs(p2.x - p1.x), abs(p2.y - p1.y)));
+}
+
+void DebugOverlay::append(const DebugOverlay& other) {
+	int offset = (int)points.size();
+	points.insert(points.end(), other.points.begin(), other.points.end());
+	for(size_t i=0; i<other.commands.size(); i++) {
+		Command cmd = other.commands[i];
+		if(cmd.type == POLYGON) {
+			cmd.p1.x += offset;
+		}
+		commands.push_back(cmd);
+		add_dirty(pending, cmd.bounds);
+	}
+}
+
+// pads bounds for line thickness and antialiasing slop and records the command
+void DebugOverlay::push(Command& cmd, CvRect bounds) {
+	int pad = (cmd.thickness > 0 ? cmd.thickness : 1) + 2;
+	cmd.bounds = cvRect(bounds.x - pad, bounds.y - pad,
+			bounds.width + 2*pad + 1, bounds.height + 2*pad + 1);
+	commands.push_back(cmd);
+	add_dirty(pending, cmd.bounds);
+}
+
+// merges r into rects, coalescing anything it touches
+void DebugOverlay::add_dirty(vector<CvRect>& rects, CvRect r) {
+	bool merged = true;
+	while(merged) {
+		merged = false;
+		for(size_t i=0; i<rects.size(); i++) {
+			if(rects_touch(rects[i], r)) {
+				r = rect_union(rects[i], r);
+				rects.erase(rects.begin() + i);
+				merged = true;
+				break;
+			}
+		}
+	}
+	rects.push_back(r);
+	if(rects.size() > MAX_DIRTY_RECTS) {
+		CvRect all = rects[0];
+		for(size_t i=1; i<rects.size(); i++) {
+			all = rect_union(all, rects[i]);
+		}
+		rects.clear();
+		rects.push_back(all);
+	}
+}
+
+void DebugOverlay::render(IplImage *debug_image) {
+	if(debug_image != last_target) {
+		needs_full_clear = true;
+		last_target = debug_image;
+	}
+
+	// wipe last frame's drawing
+	if(needs_full_clear) {
+		cvZero(debug_image);
+		needs_full_clear = false;
+	} else {
+		for(size_t i=0; i<dirty.size(); i++) {
+			CvRect r = dirty[i];
+			if(clip_rect(r, debug_image)) {
+				cvSetImageROI(debug_image, r);
+				cvZero(debug_image);
+			}
+		}
+		cvResetImageROI(debug_image);
+	}
+
+	for(size_t i=0; i<commands.size(); i++) {
+		const Command& cmd = commands[i];
+		switch(cmd.type) {
+		case POLYGON: {
+			CvPoint *pts = &points[cmd.p1.x];
+			int n = cmd.p1.y;
+			cvPolyLine(debug_image, &pts, &n, 1, 1, cmd.color, cmd.thickness, 8);
+			break;
+		}
+		case RECT:
+			cvRectangle(debug_image, cmd.p1, cmd.p2, cmd.color, cmd.thickness);
+			break;
+		case CIRCLE:
+			cvCircle(debug_image, cmd.p1, cmd.radius, cmd.color, cmd.thickness);
+			break;
+		case LINE:
+			cvLine(debug_image, cmd.p1, cmd.p2, cmd.color, cmd.thickness);
+			break;
+		}
+	}
+
+	// what we drew now is what needs wiping next time
+	dirty = pending;
+}
+
+int DebugOverlay::dirty_area() const {
+	int area = 0;
+	for(size_t i=0; i<dirty.size(); i++) {
+		area += dirty[i].width * dirty[i].height;
+	}
+	return area;
+}
@@ -0,0 +1,84 @@
+/*
+ * debug_overlay.h
+ *
+ * Command list of debug draw primitives (contours, hulls, boxes, defect circles,
+ * fingertip lines).  find_hands_and_shoot records into it during the normal pass,
+ * nothing gets recomputed for drawing.  render() rasterizes the list into the debug
+ * image only when somebody actually looks at it, and only clears the rectangles that
+ * were drawn into the last time instead of the whole frame.
+ * Implementation in debug_overlay.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef DEBUG_OVERLAY_H_
+#define DEBUG_OVERLAY_H_
+
+#include "cv.h"
+#include <vector>
+
+class DebugOverlay {
+public:
+	DebugOverlay();
+
+	// drop the recorded commands, start a new frame
+	void clear();
+	// next render() zeroes the whole target (eg new window, new image)
+	void invalidate();
+
+	// coordinates recorded from now on are multiplied by scale (eg for a search
+	// on a downscaled mask), [1]
+	void set_scale(int _scale) { scale = _scale; }
+	int scale_factor() const { return scale; }
+
+	// recording -- cheap, just copies the args
+	// closed polygon, pts are copied
+	void polygon(const CvPoint *pts, int n, CvScalar color, int thickness);
+	void rect(CvPoint p1, CvPoint p2, CvScalar color, int thickness);
+	// thickness CV_FILLED for filled circle
+	void circle(CvPoint center, int radius, CvScalar color, int thickness);
+	void line(CvPoint p1, CvPoint p2, CvScalar color, int thickness);
+
+	// append all of other's commands after ours
+	void append(const DebugOverlay& other);
+
+	int size() const { return (int)commands.size(); }
+
+	// zero the dirty rects from the last render and rasterize the commands
+	// debug_image -- 3 channel image, same size as the mask that was processed
+	void render(IplImage *debug_image);
+
+	// pixels covered by the last render's dirty rects
+	int dirty_area() const;
+
+private:
+	enum CommandType { POLYGON, RECT, CIRCLE, LINE };
+	struct Command {
+		CommandType type;
+		CvScalar color;
+		int thickness;
+		// POLYGON: p1.x is the offset into points, p1.y the count
+		// RECT, LINE: end points
+		// CIRCLE: p1 center, radius
+		CvPoint p1, p2;
+		int radius;
+		// bounding rect of what gets drawn, already padded for thickness
+		CvRect bounds;
+	};
+
+	void push(Command& cmd, CvRect bounds);
+	static void add_dirty(std::vector<CvRect>& rects, CvRect r);
+
+	std::vector<Command> commands;
+	std::vector<CvPoint> points;
+	// rects covering this frame's commands
+	std::vector<CvRect> pending;
+	// rects drawn into by the last render -- to be zeroed by the next one
+	std::vector<CvRect> dirty;
+	// image the dirty rects refer to
+	IplImage *last_target;
+	bool needs_full_clear;
+	int scale;
+};
+
+#endif /* DEBUG_OVERLAY_H_ */
@@ -35,8 +35,64 @@
  *								a second time, or you can let it run until you quit
  *						-- if you are already in debug mode, a debug video file will be saved as well
  *							("fingershooter_debug.avi")
- *	f       save frames of image, backproject, hue, hsv, and debug if on, as jpegs in ./temp
+ *	f       dump the flight recorder (--record) -- the last seconds of input frames and the
+ *								hands found in them, written in the background, see flight_recorder.h
+ *	m       print live image / histogram / storage buffers and bytes, see cv_handles.h
+ *	b       print bullet counts and how often the bullet limits kicked in, see bullet_budget.h
+ *	t       with --trace, write the last frames' timeline as Chrome trace JSON, see trace.h
 
+ *
+ *	Command line:
+ *	fingershooter                               calibrate from the camera and run
+ *	fingershooter image x y width height        run on an image, histogram from the selection
+ *	fingershooter --huesat [image x y w h]      same, but with a 2D hue/saturation histogram
+ *	fingershooter --tiles [...]                 per-pixel stages run tiled over all cores
+ *	fingershooter --parallel [...]              candidate contours analysed in parallel
+ *	fingershooter --motion [...]                still frames skip detection, unchanged contours
+ *	                                            keep their last result
+ *	fingershooter --budget ms [...]             low latency mode, frames degrade or drop to stay
+ *	                                            under ms from capture to display
+ *	fingershooter --lowmem [...]                low memory profile, colour stages in strips, no
+ *	                                            backprojection window, peak image memory at exit
+ *	fingershooter --bullets hand:rate:live [...]
+ *	                                            bullet limits -- per hand each frame (a cap, not
+ *	                                            a rate), over all hands per second, live at once
+ *	                                            (default 10:1200:3000, 0 no limit)
+ *	fingershooter --idle secs [...]             power saving, after secs without hands only a cheap
+ *	                                            skin count on a small frame a few times a second,
+ *	                                            cpu time per minute in each state at exit
+ *	fingershooter --record secs[:yuyv|nv12][:post=secs][:spike=factor][:mb=cap] [...]
+ *	                                            flight recorder of the last secs, dumped on 'f',
+ *	                                            SIGUSR1 or a latency spike (yuyv, at most 256 MB
+ *	                                            unless mb says otherwise, off unless given)
+ *	fingershooter --publish name[:mask][:slots=N] [...]
+ *	                                            each frame's hands (and with mask the raw
+ *	                                            backprojection) into shared memory for other
+ *	                                            processes, see hand_events_reader.h
+ *	fingershooter --serve [addr:]port[:quality=Q] [...]
+ *	                                            the windows as MJPEG over http, /image /backproject
+ *	                                            /debug, localhost unless addr is given, see
+ *	                                            mjpeg_server.h
+ *	fingershooter --trace frames [...]          record a per thread timeline, the last frames
+ *	                                            written as Chrome trace JSON on 't' and at exit
+ *	fingershooter --stage thread:settings [...]  pin / prioritize the main thread (capture, bullets,
+ *	                                            writer) or the vision pool, set once at startup,
+ *	                                            eg vision:cores=2-5:fifo=10, main:cores=1:localmem
+ *	                                            -- repeatable, stage time histograms at exit
+ *	fingershooter --yuv yuyv|nv12 WxH file.yuv x y w h | incident.jsonl
+ *	                                            frames from a raw camera format file ("-" for stdin),
+ *	                                            skin straight from chroma, histogram from the
+ *	                                            selection in the first frame, or from a flight
+ *	                                            recorder incident's jsonl (no --tiles)
+ *	fingershooter --bench [name]                run the timing benchmarks in benchmarks.cpp
+ *	fingershooter --batch out.jsonl calib_image x y width height [-j workers] [-c chunk_frames] files...
+ *	                                            detection records for recorded videos, no gui
+ *	fingershooter --tune labels.txt|synth:N [calib_image x y width height] [-j workers] [-g grid]
+ *	              [-c cache] [-o out.csv]       sweep the detector's knobs against labelled
+ *	                                            fingertips, accuracy vs time Pareto table
+ *
+ *	FINGERSHOOTER_SIMD=scalar|sse2|avx2|avx512|neon in the environment forces the
+ *	per-pixel kernels' instruction set, otherwise the best the cpu has, see simd_dispatch.h
  *
  *	Video Writing Issues:
  *	Note that if you want to save the video, you may have to tweak the camera parameters, especially the
@@ -50,10 +106,32 @@
 #include <stdio.h>
 #include <ctype.h>
 #include <stdlib.h>
+#include <string.h>
 #include <iostream>
 
 #include "bullet.h"
 #include "open_hands.h"
+#include "debug_overlay.h"
+#include "benchmarks.h"
+#include "batch.h"
+#include "skin_lut.h"
+#include "task_pool.h"
+#include "tile_pipeline.h"
+#include "latency_budget.h"
+#include "motion_gate.h"
+#include "yuv_source.h"
+#include "hue_kernel.h"
+#include "simd_dispatch.h"
+#include "cv_handles.h"
+#include "strip_segmenter.h"
+#include "stage_threads.h"
+#include "bullet_budget.h"
+#include "idle_watch.h"
+#include "tuner.h"
+#include "trace.h"
+#include "flight_recorder.h"
+#include "hand_publisher.h"
+#include "mjpeg_server.h"
 
 //******* unix/linux only for sleeping
 #include "time.h"
@@ -61,14 +139,14 @@
 using namespace std;
 
 // Returns a histogram with hue and saturation values obtained by sampling img in rect selection
-// remember to cvReleaseHist(&hist) when done
 // param: show [false]  -- if true show red rectangle in image of selection and pic of hist
-CvHistogram* createHueSatHist(IplImage* img, CvRect selection, bool show=false);
+Histogram createHueSatHist(IplImage* img, CvRect selection, bool show=false);
 
 // Returns a histogram with hue values obtained by sampling img in rect selection
-// remember to cvReleaseHist(&hist) when done
 // param: show [false]  -- if true show red rectangle in image of selection and pic of hist
-CvHistogram* createHueHist(IplImage* img, CvRect selection, bool show=false);
+// saves the image and a picture of the histogram in ./images, calc_hue_hist (skin_lut.h)
+// is just the histogram
+Histogram createHueHist(IplImage* img, CvRect selection, bool show=false);
 
 CvScalar hsv2rgb( float hue );
 
@@ -78,9 +156,9 @@ void test_huehist();
 // draw red rect around selection on image
 void draw_selection(IplImage *img, CvRect selection);
 
-// returns a hue (or hue/sat if modified) histogram
+// returns a hue histogram, or hue/sat histogram if hue_sat is true,
 //based on selection drawn on image taken from capture
-CvHistogram* calibrate();
+Histogram calibrate(bool hue_sat=false);
 
 // initializes video writer to write frames to output file filename
 // at the given frame rate and size
@@ -89,45 +167,46 @@ CvHistogram* calibrate();
 void init_vidwriter(CvVideoWriter **writer, const char *filename,
 		int framerate, CvSize frame_size);
 
+// fingershooter --batch out.jsonl calib_image x y w h [-j workers] [-c chunk_frames] files...
+// runs the detector over recorded video files, no gui, see batch.h
+int batch_main(int argc, char* argv[]);
+
+// fingershooter --tune labels.txt|synth:N [calib_image x y w h] [-j workers] [-g grid]
+// 		[-c cache] [-o out.csv]
+// sweeps the detector's knobs over labelled frames, no gui, see tuner.h
+int tune_main(int argc, char* argv[]);
+
 // all bullets drawn on screen
 vector<Bullet*> g_bullets = vector<Bullet*>();
 
-void fire_bullet(Bullet *b) {
-	g_bullets.push_back(b);
+// spawn limits, live cap and level of detail for g_bullets, see bullet_budget.h
+BulletBudget *g_bullet_budget = 0;
+
+// V4L2 stamps each buffer when the camera filled it, on the monotonic clock
+// cvGetTickCount also reads, and the capture hands that over as CV_CAP_PROP_POS_MSEC
+// returns it in cvGetTickCount ticks, or 0 if there isn't one or it can't be that
+// clock (eg a file's position) -- after the read returned, or over a second before
+// it started
+static int64 driver_capture_ticks(CvCapture *capture, int64 read_start, int64 read_end) {
+	double ms = cvGetCaptureProperty(capture, CV_CAP_PROP_POS_MSEC);
+	if(ms <= 0) {
+		return 0;
+	}
+	// cvGetTickFrequency is ticks per microsecond
+	int64 ticks = (int64)(ms * 1000 * cvGetTickFrequency());
+	int64 second = (int64)(1e6 * cvGetTickFrequency());
+	if(ticks > read_end || ticks < read_start - second) {
+		return 0;
+	}
+	return ticks;
 }
 
 void update_bullets(IplImage *image) {
-	if(g_bullets.empty()) {
-		return;
-	}
-	vector<Bullet*>::iterator it = g_bullets.end();
-	while(it != g_bullets.begin()) {
-		--it;
-		Bullet *b = *it;
-		b->update();
-
-//		b->print();
-
-		int x = b->pos.x;
-		int y = b->pos.y;
-		int w = image->width;
-		int h = image->height;
-		// cleanup old bullets
-		if(x <= 0 || x >= w  ||
-				y <= 0 || y >= h ) {
-			g_bullets.erase(it);
-			delete b;
-		}
-	}
-//	cout<<"g_bullets.size(): " << g_bullets.size() << endl;
+	g_bullet_budget->update(g_bullets, image);
 }
 
-void draw_bullets(IplImage *image) {
-	for(int i=0; i< g_bullets.size(); i++) {
-		cvCircle(image, g_bullets[i]->pos,
-				g_bullets[i]->radius,
-				g_bullets[i]->color, CV_FILLED);
-	}
+void draw_bullets(IplImage *image, const LatencyBudget *budget) {
+	g_bullet_budget->draw(g_bullets, image, budget);
 }
 
 int main(int argc, char* argv[])
@@ -136,17 +215,163 @@ int main(int argc, char* argv[])
 //	test();
 //	return 0;
 
-	IplImage *image = 0, *debug_image = 0,
-			*hsv = 0, *hue = 0, *sat = 0, *v = 0,
-			*backproject = 0, *backproject_copy = 0;
-	const int NUM_TEMPS = 3;
-	IplImage *temp_images[NUM_TEMPS];
+	// fingershooter --bench [name] -- run timing benchmarks and quit
+	if(argc >= 2 && strcmp(argv[1], "--bench") == 0) {
+		return run_benchmarks(argc >= 3 ? argv[2] : NULL) ? 0 : 1;
+	}
+	if(argc >= 2 && strcmp(argv[1], "--batch") == 0) {
+		return batch_main(argc, argv);
+	}
+	if(argc >= 2 && strcmp(argv[1], "--tune") == 0) {
+		return tune_main(argc, argv);
+	}
 
-	CvHistogram *hist = 0;
+	// mode flags, ahead of the usual args
+	// --huesat -- segment with a 2D hue/saturation histogram instead of hue only
+	// --tiles -- run the per-pixel stages tile by tile on all cores, see tile_pipeline.h
+	// --parallel -- analyse the candidate contours in parallel on all cores
+	// --motion -- skip detection on still frames, reuse unchanged contours, see motion_gate.h
+	// --budget ms -- low latency mode, degrade / drop frames to keep capture to display
+	// 			under ms, see latency_budget.h
+	// --yuv fmt WxH file -- raw YUYV / NV12 frames instead of the camera, see yuv_source.h,
+	// 			then a selection or an incident's jsonl for the histogram
+	// --lowmem -- keep as few full frame buffers as possible, see strip_segmenter.h
+	// --bullets hand:rate:live -- bullet limits, see bullet_budget.h
+	// --stage thread:settings -- cores, scheduling, memory policy for the main thread or
+	// 			the vision pool, see stage_threads.h
+	// --idle secs -- watch mode after secs without hands, see idle_watch.h
+	// --trace frames -- per thread timeline of the last frames, see trace.h
+	// --record settings -- flight recorder of the last seconds, see flight_recorder.h
+	// --publish name -- hands into shared memory for other processes, see hand_publisher.h
+	// --serve port -- the windows over http, see mjpeg_server.h
+	bool hue_sat = false;
+	bool tiled = false;
+	bool parallel_contours = false;
+	bool low_memory = false;
+	// stages time themselves either way, the times are printed if any were configured
+	StageControls stages;
+	bool staged = false;
+	LatencyBudget *budget = 0;
+	BulletLimits bullet_limits;
+	IdleWatch *idle = 0;
+	RecorderSettings recorder_settings;
+	PublisherSettings publisher_settings;
+	bool publishing = false;
+	ServerSettings server_settings;
+	bool serving = false;
+	bool use_motion = false;
+	YuvFileSource *yuv_source = 0;
+	char **yuv_args = 0;
+	while(argc >= 2) {
+		int used = 1;
+		if(strcmp(argv[1], "--huesat") == 0) {
+			hue_sat = true;
+		} else if(strcmp(argv[1], "--tiles") == 0) {
+			tiled = true;
+		} else if(strcmp(argv[1], "--parallel") == 0) {
+			parallel_contours = true;
+		} else if(strcmp(argv[1], "--lowmem") == 0) {
+			low_memory = true;
+		} else if(strcmp(argv[1], "--bullets") == 0 && argc >= 3) {
+			if(!parse_bullet_limits(argv[2], &bullet_limits)) {
+				printf("usage: --bullets per_hand_frame:per_second:live, eg 5:600:2000\n");
+				return 1;
+			}
+			used = 2;
+		} else if(strcmp(argv[1], "--record") == 0 && argc >= 3) {
+			if(!parse_recorder_settings(argv[2], &recorder_settings)) {
+				printf("usage: --record secs[:yuyv|nv12][:post=secs][:spike=factor][:mb=cap]\n");
+				return 1;
+			}
+			used = 2;
+		} else if(strcmp(argv[1], "--publish") == 0 && argc >= 3) {
+			if(!parse_publisher_settings(argv[2], &publisher_settings)) {
+				printf("usage: --publish /name[:mask][:slots=N]\n");
+				return 1;
+			}
+			publishing = true;
+			used = 2;
+		} else if(strcmp(argv[1], "--serve") == 0 && argc >= 3) {
+			if(!parse_server_settings(argv[2], &server_settings)) {
+				printf("usage: --serve [address:]port[:quality=Q], eg 8080 or 0.0.0.0:8080\n");
+				return 1;
+			}
+			serving = true;
+			used = 2;
+		} else if(strcmp(argv[1], "--trace") == 0 && argc >= 3) {
+			enable_trace(atoi(argv[2]));
+			trace_thread_name("main");
+			used = 2;
+		} else if(strcmp(argv[1], "--idle") == 0 && argc >= 3) {
+			delete idle;
+			idle = new IdleWatch(atof(argv[2]));
+			used = 2;
+		} else if(strcmp(argv[1], "--stage") == 0 && argc >= 3) {
+			if(!stages.configure(argv[2])) {
+				printf("usage: --stage main|vision:[cores=2,4-6][:fifo=prio]"
+						"[:nice=n][:localmem]\n");
+				return 1;
+			}
+			staged = true;
+			used = 2;
+		} else if(strcmp(argv[1], "--motion") == 0) {
+			use_motion = true;
+		} else if(strcmp(argv[1], "--budget") == 0 && argc >= 3) {
+			budget = new LatencyBudget(atof(argv[2]));
+			used = 2;
+		} else if(strcmp(argv[1], "--yuv") == 0 && argc >= 5) {
+			// opened once the main thread's settings are on, see below
+			yuv_args = argv + 2;
+			used = 4;
+		} else {
+			break;
+		}
+		argv += used;
+		argc -= used;
+	}
+	// the main thread's cores, scheduling and memory policy, once and before any
+	// frame buffers -- a memory policy only places what's allocated after it
+	stages.apply_main();
+	if(yuv_args) {
+		YuvFormat fmt;
+		int w = 0, h = 0;
+		yuv_source = new YuvFileSource();
+		if(!parse_yuv_format(yuv_args[0], &fmt) || sscanf(yuv_args[1], "%dx%d", &w, &h) != 2 ||
+				!yuv_source->open(yuv_args[2], fmt, w, h)) {
+			printf("usage: --yuv yuyv|nv12 WxH file.yuv x y width height | incident.jsonl\n");
+			delete yuv_source;
+			delete idle;
+			return 1;
+		}
+	}
+	// 2D histogram expanded into a lookup table, see skin_lut.h
+	HueSatLut *huesat_lut = 0;
+	TaskPool *pool = 0;
+	TilePipeline *tile_pipeline = 0;
+	StripSegmenter *strips = 0;
+	// skin from the raw frames' chroma, see skin_lut.h
+	UvSkinLut *uv_lut = 0;
+	// bgr made from the raw frames for showing and saving, and a header over the raw
+	// frame for the motion gate
+	Image yuv_image;
+	IplImage yuv_raw;
+
+	// the current frame, owned by the capture (or yuv_image)
+	IplImage *image = 0;
+	// only the ones this mode reads get allocated, debug_image only while it's wanted
+	Image debug_image, hsv, hue, backproject, backproject_copy;
+
+	Histogram hist;
 
 
 	// bullets coming from hands found
 	vector<Bullet*> new_bullets = vector<Bullet*>();
+	BulletBudget bullet_budget(bullet_limits);
+	g_bullet_budget = &bullet_budget;
+
+	// debug imagery recorded by find_hands_and_shoot, rendered into debug_image
+	// only when the debug window or debug writer wants it
+	DebugOverlay debug_overlay;
 
 
 	// **** if initializing hist to flesh colors based on stored image
@@ -184,14 +409,44 @@ int main(int argc, char* argv[])
 	// for testing with image only, then need selection rect as well
 	// to get histogram with
 	// assume argv[1] is image filename, argv[2-5] are x,y,width,height of selection in image
-	if(argc == 6) {
+	if(argc == 6 && !yuv_source) {
 		image_only = true;
 		printf("image_only\n");
 	}
-	// set histogram here if not image only
-	if(!image_only) {
+	// raw frames have no camera to calibrate from, the histogram comes from a
+	// selection in the first frame or the incident the frames were recorded in
+	if(yuv_source && argc == 2) {
+		if(!load_incident_hist(argv[1], &hist)) {
+			delete yuv_source;
+			delete idle;
+			return 1;
+		}
+		// the lookup tables follow the recorded histogram's layout
+		hue_sat = cvGetDims(hist->bins) == 2;
+	} else if(yuv_source && argc != 5) {
+		printf("--yuv needs the histogram's selection in the first frame or the incident's "
+				"jsonl, there's no camera to calibrate from:\n"
+				"  --yuv yuyv|nv12 WxH file.yuv x y width height | incident.jsonl\n");
+		delete yuv_source;
+		delete idle;
+		return 1;
+	}
+	char **sel_args = image_only ? argv + 2 : yuv_source && argc == 5 ? argv + 1 : NULL;
+	// options this mode can't use, said out loud rather than dropped
+	if(yuv_source && tiled) {
+		printf("warning: --tiles works from bgr frames, ignored with --yuv\n");
+		tiled = false;
+	}
+	if(image_only && recorder_settings.secs > 0) {
+		printf("warning: --record needs a stream of frames, ignored for a single image\n");
+	}
+	if(image_only && serving) {
+		printf("warning: --serve needs a stream of frames, ignored for a single image\n");
+	}
+	// set histogram here if no selection to take it from
+	if(!sel_args && !hist) {
 		// prompt user to calibrate histogram of flesh color
-		hist = calibrate();
+		hist = calibrate(hue_sat);
 	}
 
 	// let user know about the latest features ..
@@ -204,15 +459,25 @@ int main(int argc, char* argv[])
 	printf("							a second time, or you can let it run until you quit\n");
 	printf("					-- if you are already in debug mode, a debug video file will be saved as well\n");
 	printf("						(\"fingershooter_debug.avi\")\n");
-	printf("f      save frames of image, backproject, hue, hsv, and debug if on, as jpegs in ./temp\n\n");
+	printf("m      print live buffers and bytes\n");
+	printf("b      print bullet counts and how often the bullet limits held bullets back\n");
+	if(!image_only && recorder_settings.secs > 0) {
+		printf("f      dump the last seconds of frames and hands in the background (incident_N.yuv)\n");
+	}
+	if(g_trace_on) {
+		printf("t      write the last frames' timeline as Chrome trace JSON\n");
+	}
+	printf("\n");
 
 	CvCapture* capture = NULL;
-	if(image_only) {
+	if(yuv_source) {
+		// no capture, the frames come from the raw file
+	} else if(image_only) {
 		capture = cvCreateFileCapture( argv[1] );
 	} else {
 		capture = cvCaptureFromCAM(CV_CAP_ANY);
 	}
-	if(capture == NULL) {
+	if(capture == NULL && !yuv_source) {
 		printf("No capture\n");
 		return 1;
 	}
@@ -224,132 +489,375 @@ int main(int argc, char* argv[])
 //	cvNamedWindow("Hue", CV_WINDOW_AUTOSIZE );
 
 
-	image = cvQueryFrame( capture );
+	if(yuv_source) {
+		if(yuv_source->read()) {
+			yuv_image.ensure(yuv_source->size(), 8, 3);
+			yuv_to_bgr(yuv_source->frame(), yuv_image);
+			// yuyv as 2 channels, nv12 by its luma plane -- either way a change shows
+			const YuvFrame &frame = yuv_source->frame();
+			cvInitImageHeader(&yuv_raw, yuv_source->size(), 8,
+					frame.fmt == YUV_YUYV ? 2 : 1);
+			cvSetData(&yuv_raw, frame.data, frame.fmt == YUV_YUYV ? frame.width * 2 : frame.width);
+		}
+		image = yuv_image;
+	} else {
+		image = cvQueryFrame( capture );
+	}
 	if( !image ) {
 		printf("No image\n");
 		return 1;
 	}
 	// set output writing size stuff
-	int framerate = (int)cvGetCaptureProperty(capture, CV_CAP_PROP_FPS);
-	int f_width = (int)cvGetCaptureProperty(capture, CV_CAP_PROP_FRAME_WIDTH);
-	int f_height = (int)cvGetCaptureProperty(capture, CV_CAP_PROP_FRAME_HEIGHT);
+	int framerate = 0, f_width = image->width, f_height = image->height;
+	if(capture) {
+		framerate = (int)cvGetCaptureProperty(capture, CV_CAP_PROP_FPS);
+		f_width = (int)cvGetCaptureProperty(capture, CV_CAP_PROP_FRAME_WIDTH);
+		f_height = (int)cvGetCaptureProperty(capture, CV_CAP_PROP_FRAME_HEIGHT);
+	}
 	framerate = framerate > 0 ? framerate: 15;
 	f_width = f_width > 0 ? f_width: 640;
 	f_height = f_height > 0 ? f_height: 480;
 	printf("cam capture: "
 			"framerate=%d, f_width=%d, f_height=%d\n", framerate, f_width, f_height);
-
-	// set histogram if image only
-	if(image_only) {
-		CvRect selection = cvRect(atoi(argv[2]), atoi(argv[3]), atoi(argv[4]), atoi(argv[5]));
-		hist = createHueHist(image, selection, true);
+	printf("pixel kernels: %s\n", simd_level_name(simd_level()));
+
+	// set histogram if image only, or from the first raw frame
+	if(sel_args) {
+		CvRect selection = cvRect(atoi(sel_args[0]), atoi(sel_args[1]),
+				atoi(sel_args[2]), atoi(sel_args[3]));
+		if(hue_sat) {
+			hist = createHueSatHist(image, selection, true);
+		} else {
+			hist = createHueHist(image, selection, true);
+		}
+	}
+	if(hue_sat) {
+		huesat_lut = new HueSatLut();
+		huesat_lut->build(hist);
+	}
+	// hue only, the histogram as a 256 entry table
+	HueLut hue_lut;
+	hue_lut.build(hist);
+	if(yuv_source) {
+		uv_lut = new UvSkinLut();
+		uv_lut->build(hist);
+	}
+	// the hand search, find_hands_and_shoot goes through it -- vision cores, if given,
+	// decide the worker count of its pool
+	HandFinder *finder = new HandFinder(RuntimeHandConfig(),
+			parallel_contours ? stages.pool_workers() : 1, use_motion,
+			StageControls::init_pool_thread, &stages);
+	set_hand_finder(finder);
+	// [NULL] still frames skip detection
+	MotionGate *motion_gate = finder->motion();
+	if(finder->pool()) {
+		pool = finder->pool();
+	} else if(tiled) {
+		pool = new TaskPool(stages.pool_workers(), StageControls::init_pool_thread, &stages);
+	}
+	if(tiled) {
+		// cleans the tiles the way the finder's detector would
+		tile_pipeline = new TilePipeline(pool, finder->config());
+		tile_pipeline->set_hist(hist);
+		tile_pipeline->set_lut(huesat_lut);
 	}
 
-	debug_image = cvCreateImage( cvGetSize(image), 8, 3 );
-	hsv = cvCreateImage( cvGetSize(image), 8, 3 );
-	hue = cvCreateImage( cvGetSize(image), 8, 1 );
-	sat = cvCreateImage( cvGetSize(image), 8, 1 );
-	v = cvCreateImage( cvGetSize(image), 8, 1 );
-
-	backproject = cvCreateImage( cvGetSize(image), 8, 1);
-	backproject_copy = cvCreateImage( cvGetSize(image), 8, 1);
-
+	if(low_memory && !tiled && !yuv_source) {
+		strips = new StripSegmenter();
+		strips->set_hist(hist);
+		strips->set_lut(huesat_lut);
+	}
+	if(idle) {
+		idle->set_hist(hist);
+		idle->set_lut(huesat_lut);
+	}
+	// whole frame colour planes only for the plain path, and only the one it reads
+	bool whole_frame = !tiled && !yuv_source && !strips;
+	if(whole_frame && hue_sat) {
+		hsv.ensure( cvGetSize(image), 8, 3 );
+	}
+	if(whole_frame && !hue_sat) {
+		hue.ensure( cvGetSize(image), 8, 1 );
+	}
 
-	for(int i=0; i<NUM_TEMPS; i++) {
-			temp_images[i] = cvCreateImage( cvGetSize(image), 8, 1);
+	backproject.ensure( cvGetSize(image), 8, 1);
+	// the raw backprojection is kept only to show it, low memory doesn't
+	bool show_backproject = !low_memory;
+	if(show_backproject) {
+		backproject_copy.ensure( cvGetSize(image), 8, 1);
+	} else {
+		cvDestroyWindow("Backproject");
 	}
 
+	// the last seconds of input, kept for dumping when something goes wrong, if asked for
+	FlightRecorder recorder;
+	if(!image_only && recorder_settings.secs > 0) {
+		recorder.start(recorder_settings, framerate, cvGetSize(image),
+				yuv_source ? yuv_source->frame().fmt : recorder_settings.fmt);
+		// so an incident can be replayed with the same skin
+		recorder.set_hist(hist);
+	}
+	// hands out to other processes, the mask is the raw backprojection so it needs keeping
+	HandPublisher publisher;
+	if(publishing) {
+		if(publisher_settings.masks && !show_backproject) {
+			printf("publish: no masks with --lowmem\n");
+			publisher_settings.masks = false;
+		}
+		if(!publisher.open(publisher_settings, cvGetSize(image))) {
+			return 1;
+		}
+	}
+	// the windows for watching from elsewhere
+	MjpegServer server;
+	if(serving && !image_only && !server.start(server_settings)) {
+		return 1;
+	}
+	// --trace files written so far
+	int traces_written = 0;
+	char trace_file[64];
+	long frame_no = 0;
 	try {
 	while(1) {
 
-		if(!image_only) {
-			image = cvQueryFrame( capture );
+		trace_frame(frame_no++);
+		int64 frame_start = cvGetTickCount();
+		stages.begin(STAGE_CAPTURE);
+		int64 read_start = cvGetTickCount();
+		{
+			TRACE_SCOPE("capture");
+			if(yuv_source) {
+				image = yuv_source->read() ? yuv_image.get() : NULL;
+			} else if(!image_only) {
+				image = cvQueryFrame( capture );
+			}
 		}
+		stages.end(STAGE_CAPTURE);
 		if( !image ) {
 			printf("No image\n");
 			break;
 		}
+		// when the frame was captured -- the driver's stamp if there is one
+		int64 read_end = cvGetTickCount();
+		int64 driver_ticks = capture ? driver_capture_ticks(capture, read_start, read_end) : 0;
+		// for the budget, failing that from before the read, so the wait for it counts
+		int64 capture_ticks = driver_ticks ? driver_ticks : read_start;
+		// for other processes, failing that when the read returned -- not before the wait,
+		// which would make every frame look as old as the camera's frame interval
+		uint64_t capture_ns = he_now_ns() - (uint64_t)(ticks_to_ms(cvGetTickCount() -
+				(driver_ticks ? driver_ticks : read_end)) * 1e6);
+		// as it came in, before any bullets are drawn on it
+		if(recorder.enabled()) {
+			if(yuv_source) {
+				recorder.record(yuv_source->frame());
+			} else {
+				recorder.record(image);
+			}
+		}
+		bool want_debug = debug_mode || (save_mode && debug_writer) ||
+				server.wants(STREAM_DEBUG);
+		DebugOverlay *overlay = want_debug ? &debug_overlay : NULL;
+
+		stages.begin(STAGE_VISION);
+		// raw frames are made bgr first if the watch needs to look at them
+		bool bgr_ready = false;
+		if(yuv_source && idle && idle->watching()) {
+			TRACE_SCOPE("colour conversion");
+			yuv_to_bgr(yuv_source->frame(), image);
+			bgr_ready = true;
+		}
+		// watching and nobody walked in -- only the bullets still in flight
+		// if somebody did, this same frame goes through everything
+		bool was_watching = idle && idle->watching();
+		bool watch_only = was_watching && !idle->check(image);
+		// the frame's latency budget runs from its capture -- not for watch frames, whose
+		// wait for the next one is the point, not lag
+		if(budget && !watch_only) {
+			if(was_watching) {
+				// just woke: what the watch frames did says nothing about this load, and
+				// a driver stamp may be from before the wait, so time it from the read
+				budget->reset();
+				capture_ticks = read_start;
+			}
+			budget->start_frame(capture_ticks);
+		}
+		// backprojected this frame, rather than reusing the last hands
+		bool projected = false;
+		// nothing moved since the hands were found -- they are still right
+		// a frame dropped for the budget isn't analysed, so it can't be the reference
+		bool still = !watch_only && motion_gate &&
+				motion_gate->update(yuv_source ? &yuv_raw : image,
+						!budget || budget->level() != LatencyBudget::REUSE) == 0;
+
+		if(watch_only) {
+			// nothing to find
+		} else if(still || (budget && budget->level() == LatencyBudget::REUSE)) {
+			// dropped to stay in budget, or nothing to look at
+			// -- keep shooting from the last hands
+			bullet_budget.note_held_back(shoot_last_hands(new_bullets, overlay,
+					bullet_limits.per_hand_frame));
+		} else {
+			projected = true;
+			if(yuv_source) {
+				// skin straight from the chroma, no bgr or hsv
+				TRACE_SCOPE("backprojection");
+				uv_lut->backproject(yuv_source->frame(), backproject);
+			} else if(strips) {
+				// a few rows at a time, no whole frame colour planes
+				TRACE_SCOPE("colour conversion + backprojection");
+				strips->run(image, backproject);
+			} else if(tiled) {
+				// everything up to the contour search, tile by tile
+				// backproject comes out cleaned, backproject_copy gets the raw one for showing
+				tile_pipeline->run(image, backproject, backproject_copy.get());
+			} else {
+				int64 t = g_trace_on ? cvGetTickCount() : 0;
+				if(hue_sat) {
+					// 2d hist with hue and saturation, straight from hsv through the table
+					cvCvtColor( image, hsv, CV_BGR2HSV );
+					if(t) {
+						int64 now = cvGetTickCount();
+						trace_span("colour conversion", t, now);
+						t = now;
+					}
+					huesat_lut->backproject(hsv, backproject);
+				} else {
+					// if only using 1d hist with hue -- just the hue, no hsv image
+					bgr_to_hue( image, hue );
+					if(t) {
+						int64 now = cvGetTickCount();
+						trace_span("colour conversion", t, now);
+						t = now;
+					}
+					hue_lut.backproject( hue, backproject );
+				}
+				if(t) {
+					trace_span("backprojection", t, cvGetTickCount());
+				}
+			}
+			if(show_backproject && !tiled) {
+				cvCopy(backproject, backproject_copy);
+			}
 
-		// set up hsv, hue, and sat images
-		cvCvtColor( image, hsv, CV_BGR2HSV );
-		cvSplit( hsv, hue, sat, v, 0 );
-
-		// if only using 1d hist with hue
-		cvCalcBackProject( &hue, backproject, hist );
+			if(show_backproject) {
+				TRACE_SCOPE("display");
+				cvShowImage("Backproject", backproject_copy);
+				server.offer(STREAM_BACKPROJECT, backproject_copy);
+			}
 
-		// test
-//		Bullet b = Bullet(cvPoint(100, 100), cvPoint(25, 25), CV_RGB(255, 0, 0), 5);
-//		fire_bullet(b);
+			// find hands and get new bullets from them if found
+			// overlay records the debug imagery if it's wanted
+			bullet_budget.note_held_back(find_hands_and_shoot(backproject, new_bullets, 6,
+					overlay, tiled, budget, bullet_limits.per_hand_frame));
+		}
+		if(idle && !watch_only) {
+			idle->frame_done(!new_bullets.empty());
+		}
+		stages.end(STAGE_VISION);
+		if(publishing) {
+			TRACE_SCOPE("publish");
+			publisher.publish(watch_only ? vector<Hand>() : last_found_hands(), capture_ns,
+					projected && show_backproject ? backproject_copy.get() : NULL);
+		}
 
-		cvCopy(backproject, backproject_copy);
-		cvShowImage("Backproject", backproject_copy);
 
-		// find hands and get new bullets from them if found
-		if(debug_mode) {
-			// show the debug image
-			find_hands_and_shoot(backproject, new_bullets, 6, true, debug_image);
-		} else {
-			// normal
-			find_hands_and_shoot(backproject, new_bullets, 6);
+		// raw frames only become bgr now, for showing and saving
+		if(yuv_source && !bgr_ready) {
+			TRACE_SCOPE("colour conversion");
+			yuv_to_bgr(yuv_source->frame(), image);
 		}
 
-
+		stages.begin(STAGE_BULLETS);
 //		printf("new bullets: %d\n", new_bullets.size());
-		for(int i=0; i<new_bullets.size(); i++) {
-			fire_bullet(new_bullets[i]);
-		}
-		new_bullets.clear();
+		// as many as the limits allow go live, the rest are dropped
+		bullet_budget.admit(g_bullets, new_bullets);
 //		cout << "past fire bullets" << endl;
-		update_bullets(image);
-		draw_bullets(image);
+		{
+			TRACE_SCOPE("bullet update");
+			update_bullets(image);
+		}
+		{
+			TRACE_SCOPE("bullet draw");
+			draw_bullets(image, watch_only ? NULL : budget);
+		}
+		stages.end(STAGE_BULLETS);
 //		cout << "past drawing bullets" << endl;
 
-		// if using 2d hist with hue and saturation
-//		IplImage* planes[] = { hue, sat };
-//		cvCalcBackProject( planes, backproject, hist );
-
-		cvShowImage("Image", image);
-		if (debug_mode) {
-			cvShowImage("DebugImage", debug_image);
+		{
+			TRACE_SCOPE("display");
+			cvShowImage("Image", image);
+			server.offer(STREAM_IMAGE, image);
+			if(want_debug) {
+				if(!debug_image) {
+					debug_image.ensure( cvGetSize(image), 8, 3 );
+					debug_overlay.invalidate();
+				}
+				debug_overlay.render(debug_image);
+				server.offer(STREAM_DEBUG, debug_image);
+			}
+			if (debug_mode) {
+				cvShowImage("DebugImage", debug_image);
+			}
 		}
 		if(save_mode) {
+			TRACE_SCOPE("video write");
+			stages.begin(STAGE_WRITER);
 			if(writer) {
 				cvWriteFrame(writer, image);
 			}
 			if(debug_writer) {
 				cvWriteFrame(debug_writer, debug_image);
 			}
+			stages.end(STAGE_WRITER);
 		}
 //		cvShowImage("Hsv", hsv);
 
 //		cvShowImage("Hue", hue);
 //		cvShowImage("HsvMask", hsv_mask);
 
+		// watch frames look for no hands
+		recorder.end_frame(watch_only ? vector<Hand>() : last_found_hands(),
+				ticks_to_ms(cvGetTickCount() - frame_start));
+
 		char c;
 		if(image_only) {
 			c = cvWaitKey(0);
 			break;
 		}
-		c = cvWaitKey(10);
+		// in low latency mode don't sit in the event loop any longer than it takes
+		// watching, sit in it until the next watch frame is due
+		c = cvWaitKey(watch_only ? idle->wait_ms() : budget ? 1 : 10);
+		if(budget && !watch_only) {
+			budget->end_frame();
+		}
 		if(c == 27){
 			break;
 		} else if(c == 'f') {
-			// save frames
-			cvSaveImage("./temp/image.jpg", image);
-			cvSaveImage("./temp/hsv.jpg", hsv);
-			cvSaveImage("./temp/backproject.jpg", backproject_copy);
-			cvSaveImage("./temp/hue.jpg", hue);
-			if(debug_mode) {
-				cvSaveImage("./temp/debug.jpg", debug_image);
+			// the dump is written in the background, the loop doesn't wait
+			if(recorder.enabled()) {
+				recorder.trigger("key");
+			} else {
+				printf("no flight recorder, see --record\n");
 			}
+		} else if(c == 'm') {
+			print_alloc_report();
+		} else if(c == 'b') {
+			bullet_budget.print_stats();
+		} else if(c == 't' && g_trace_on) {
+			sprintf(trace_file, "fingershooter_trace_%d.json", ++traces_written);
+			write_trace(trace_file);
 		} else if(c == 'd') {
 			// toggle debug mode
 			// ie show the debug image frames
 			debug_mode = !debug_mode;
 			if(debug_mode) {
+				debug_overlay.invalidate();
 				cvNamedWindow("DebugImage", CV_WINDOW_AUTOSIZE );
 			} else {
 				cvDestroyWindow("DebugImage");
+				if(low_memory && !(save_mode && debug_writer)) {
+					debug_image.reset();
+				}
 			}
 		} else if(c == 's') {
 			// toggle video save mode
@@ -377,7 +885,7 @@ int main(int argc, char* argv[])
 		}
 
 	}
-	} catch (exception e) {
+	} catch (const exception& e) {
 		cvReleaseCapture(&capture);
 		cerr << "std::exception caught:" << endl;
 		cerr << e.what() << endl;
@@ -386,20 +894,49 @@ int main(int argc, char* argv[])
 		cerr << "unknown exception caught" << endl;
 	}
 
-	cvReleaseHist(&hist);
-
-//	cvReleaseImage( &image);
-	cvReleaseImage( &debug_image);
-	cvReleaseImage( &hsv);
-	cvReleaseImage( &hue);
-	cvReleaseImage( &sat);
-	cvReleaseImage( &v);
-	cvReleaseImage( &backproject);
-	cvReleaseImage( &backproject_copy);
-
-	for(int i=0; i<NUM_TEMPS; i++) {
-		cvReleaseImage(&temp_images[i]);
+	if(g_trace_on) {
+		write_trace("fingershooter_trace.json");
+	}
+	bullet_budget.print_stats();
+	recorder.print_stats();
+	publisher.print_stats();
+	server.print_stats();
+	if(idle) {
+		idle->print_stats();
+		delete idle;
+	}
+	if(staged) {
+		stages.print_stats();
+	}
+	if(budget) {
+		budget->print_stats();
+		delete budget;
+	}
+	if(motion_gate) {
+		motion_gate->print_stats();
 	}
+	if(tile_pipeline) {
+		tile_pipeline->print_timing();
+		delete tile_pipeline;
+	}
+	if(pool != finder->pool()) {
+		delete pool;
+	}
+	set_hand_finder(NULL);
+	delete finder;
+	if(low_memory) {
+		// the capture's own frame isn't counted, it's there in every mode
+		long frame_bytes = (long)backproject->width * backproject->height * 3;
+		printf("Low memory: peak image memory %.1f KB, %.2f frame equivalents "
+				"(%dx%d bgr frame %.1f KB)\n", alloc_stats(ALLOC_IMAGE).peak_bytes / 1024.,
+				(double)alloc_stats(ALLOC_IMAGE).peak_bytes / frame_bytes,
+				backproject->width, backproject->height, frame_bytes / 1024.);
+	}
+	delete strips;
+	delete huesat_lut;
+	delete uv_lut;
+	delete yuv_source;
+	// images and histogram go with main's scope
 	cvReleaseCapture(&capture);
 	if(writer != NULL) {
 		cvReleaseVideoWriter(&writer);
@@ -411,10 +948,41 @@ int main(int argc, char* argv[])
 	cvDestroyAllWindows();
 }
 
+// fingershooter --batch out.jsonl calib_image x y w h [-j workers] [-c chunk_frames] files...
+// histogram comes from the selection in calib_image, same as the image only mode
+int batch_main(int argc, char* argv[]) {
+	if(argc < 9) {
+		printf("usage: %s --batch out.jsonl calib_image x y width height "
+				"[-j workers] [-c chunk_frames] files...\n", argv[0]);
+		return 1;
+	}
+	BatchOptions opts;
+	opts.output = argv[2];
+	Image calib(cvLoadImage(argv[3]));
+	if(!calib) {
+		printf("batch: can't load calibration image %s\n", argv[3]);
+		return 1;
+	}
+	CvRect selection = cvRect(atoi(argv[4]), atoi(argv[5]), atoi(argv[6]), atoi(argv[7]));
+	for(int i=8; i<argc; i++) {
+		if(strcmp(argv[i], "-j") == 0 && i+1 < argc) {
+			opts.num_workers = atoi(argv[++i]);
+		} else if(strcmp(argv[i], "-c") == 0 && i+1 < argc) {
+			opts.chunk_frames = atoi(argv[++i]);
+		} else {
+			opts.inputs.push_back(argv[i]);
+		}
+	}
+
+	// no gui, so nothing shown or saved to ./images
+	Histogram hist = calc_hue_hist(calib, selection);
+	return run_batch(opts, hist);
+}
+
 // Prompts user to create a flesh color histogram by positioning hand and hitting a key
 // Displays selection region in image and image of histogram (see createHueHist)
-// returns a hue histogram (or hue/sat if modified)
-CvHistogram* calibrate() {
+// returns a hue histogram, or hue/sat histogram if hue_sat is true
+Histogram calibrate(bool hue_sat) {
 	CvCapture *capture = 0;
 	capture = cvCaptureFromCAM(CV_CAP_ANY);
 	if( capture == NULL ) {
@@ -439,9 +1007,9 @@ CvHistogram* calibrate() {
 	int remaining_secs = delay;
 	bool timer_mode = false;
 	time_t start_time, curr_time;
-	CvFont* font =  new CvFont();
-	cvInitFont( font, CV_FONT_HERSHEY_SIMPLEX, 1, 1, 0, 3, 8);
-	char time_str[5];
+	CvFont font;
+	cvInitFont( &font, CV_FONT_HERSHEY_SIMPLEX, 1, 1, 0, 3, 8);
+	char time_str[12];
 	CvPoint time_pt = cvPoint(100, 100);
 
 
@@ -472,7 +1040,7 @@ CvHistogram* calibrate() {
 				cvZero(img);
 				cvResetImageROI(img);
 				sprintf(time_str, "%d", remaining_secs);
-				cvPutText(img, time_str, time_pt, font, CV_RGB(255, 255, 255));
+				cvPutText(img, time_str, time_pt, &font, CV_RGB(255, 255, 255));
 			}
 		}
 		cvShowImage("calibrate", img);
@@ -482,13 +1050,14 @@ CvHistogram* calibrate() {
 			start_time = time(NULL);
 			curr_time = time(NULL);
 //			sprintf(time_str, "&d", remaining_secs);
-//			cvPutText(img, time_str, time_pt, font, CV_RGB(127, 127, 0));
+//			cvPutText(img, time_str, time_pt, &font, CV_RGB(127, 127, 0));
 		} else if(c != -1) {
 			break;
 		}
 	}
-	CvHistogram *hist = createHueHist(img, selection, true);
-//	CvHistogram *hist = createHueSatHist(img, selection, true);
+	// moved out to the caller
+	Histogram hist = hue_sat ? createHueSatHist(img, selection, true) :
+			createHueHist(img, selection, true);
 
 
 	cvDestroyWindow("calibrate");
@@ -542,41 +1111,15 @@ void init_vidwriter(CvVideoWriter **writer, const char *filename,
 
 
 // Returns a histogram with hue values obtained by sampling img in rect selection
-// remember to cvReleaseHist(&hist) when done
 // param: show [false]  -- if true show red rectangle in image of selection and pic of hist
-CvHistogram* createHueHist(IplImage* img, CvRect selection, bool show) {
-	int hdims = 16;
-	float hranges_arr[] = {0,180};
-	float* hranges = hranges_arr;
-//	int vmin = 10, vmax = 256, smin = 30;
-	CvHistogram *hist = 0;
-	IplImage *hsv = 0, *hue = 0; // *mask = 0;
-	hsv = cvCreateImage( cvGetSize(img), 8, 3 );
-	hue = cvCreateImage( cvGetSize(img), 8, 1 );
-//	mask = cvCreateImage( cvGetSize(img), 8, 1 );
-	hist = cvCreateHist( 1, &hdims, CV_HIST_ARRAY, &hranges, 1 );
-
-	cvCvtColor( img, hsv, CV_BGR2HSV );
-	cvSplit( hsv, hue, 0, 0, 0 );
-
-	float max_val = 0.f;
-	cvSetImageROI( hue, selection );
-//	cvSetImageROI( mask, selection );
-	cvCalcHist( &hue, hist, 0 );  // orig cvCalcHist( &hue, hist, 0, mask );
-	cvGetMinMaxHistValue( hist, 0, &max_val, 0, 0 );
-	cvConvertScale( hist->bins, hist->bins, max_val ? 255. / max_val : 0., 0 );
-//	cvResetImageROI( hue );
-//	cvResetImageROI( mask );
-
-	cvReleaseImage( &hsv);
-	cvReleaseImage( &hue);
-//	cvReleaseImage( &mask);
+Histogram createHueHist(IplImage* img, CvRect selection, bool show) {
+	int hdims = HUE_BINS;
+	Histogram hist = calc_hue_hist( img, selection );
 
 	// ********* create and save image of histogram, image, and image with rect *********
 	//
-	IplImage *histimg = 0;
 //	copy = cvCreateImage( cvGetSize(img), 8, 3 );
-	histimg = cvCreateImage( cvSize(320,200), 8, 3 );
+	Image histimg( cvSize(320,200), 8, 3 );
 	cvZero( histimg );
 //	cvCopy(img, copy, 0);
 	// draw red rect around selection
@@ -604,7 +1147,7 @@ CvHistogram* createHueHist(IplImage* img, CvRect selection, bool show) {
 		cvShowImage("img", img);
 		cvShowImage("hist", histimg);
 
-		char c = cvWaitKey(0);
+		cvWaitKey(0);
 		cvDestroyWindow("img");
 		cvDestroyWindow("hist");
 	}
@@ -613,7 +1156,6 @@ CvHistogram* createHueHist(IplImage* img, CvRect selection, bool show) {
 //	cvSaveImage("./images/calibrate_image_w_selection.jpg", copy);
 	cvSaveImage("./images/calibrate_hist.jpg", histimg);
 //	cvReleaseImage(&copy);
-	cvReleaseImage( &histimg);
 
 	// ***************
 
@@ -622,9 +1164,8 @@ CvHistogram* createHueHist(IplImage* img, CvRect selection, bool show) {
 }
 
 // Returns a histogram with hue and saturation values obtained by sampling img in rect selection
-// remember to cvReleaseHist(&hist) when done
 // param: show [false]  -- if true show red rectangle in image of selection and pic of hist
-CvHistogram* createHueSatHist(IplImage* img, CvRect selection, bool show) {
+Histogram createHueSatHist(IplImage* img, CvRect selection, bool show) {
 	// ********** orig ********
 //    IplImage* hsv = cvCreateImage( cvGetSize(img), 8, 3 );
 ////    IplImage* copy = cvCreateImage( cvGetSize(img), 8, 3 );
@@ -650,7 +1191,7 @@ CvHistogram* createHueSatHist(IplImage* img, CvRect selection, bool show) {
 	// ****************************
 
 	CvSize sel_size = cvSize(selection.width, selection.height);
-	IplImage* hsv = cvCreateImage( sel_size, 8, 3 );
+	Image hsv( sel_size, 8, 3 );
     cvSetImageROI(img, selection);
     cvCvtColor( img, hsv, CV_BGR2HSV );
     cvResetImageROI(img);
@@ -661,9 +1202,9 @@ CvHistogram* createHueSatHist(IplImage* img, CvRect selection, bool show) {
 //	char c = cvWaitKey(0);
 //	cvDestroyWindow("huesat");
 
-    IplImage* h_plane  = cvCreateImage( sel_size, 8, 1 );
-    IplImage* s_plane  = cvCreateImage( sel_size, 8, 1 );
-    IplImage* v_plane  = cvCreateImage( sel_size, 8, 1 );
+    Image h_plane( sel_size, 8, 1 );
+    Image s_plane( sel_size, 8, 1 );
+    Image v_plane( sel_size, 8, 1 );
 
 
     IplImage* planes[] = { h_plane, s_plane };
@@ -673,27 +1214,14 @@ CvHistogram* createHueSatHist(IplImage* img, CvRect selection, bool show) {
 
     // Build the histogram and compute its contents.
     //
-    int h_bins = 30, s_bins = 32;
-    CvHistogram* hist;
-    {
-      int    hist_size[] = { h_bins, s_bins };
-      float  h_ranges[]  = { 0, 180 };          // hue is [0,180]
-      float  s_ranges[]  = { 0, 255 };
-      float* ranges[]    = { h_ranges, s_ranges };
-      hist = cvCreateHist(
-        2,
-        hist_size,
-        CV_HIST_ARRAY,
-        ranges,
-        1
-      );
-    }
+    int h_bins = HUESAT_H_BINS, s_bins = HUESAT_S_BINS;
+    Histogram hist = create_hue_sat_hist_bins();
     cvCalcHist( planes, hist, 0, 0 );
 
     // Create an image to use to visualize our histogram.
     //
     int scale = 10;
-    IplImage* hist_img = cvCreateImage(
+    Image hist_img(
       cvSize( h_bins * scale, s_bins * scale ),
       8,
       3
@@ -702,13 +1230,14 @@ CvHistogram* createHueSatHist(IplImage* img, CvRect selection, bool show) {
 
     // populate our visualization with little gray squares.
     //
+    // scale to [0,255] like the hue histogram so it can be backprojected
     float max_value = 0;
     cvGetMinMaxHistValue( hist, 0, &max_value, 0, 0 );
+    cvConvertScale( hist->bins, hist->bins, max_value ? 255. / max_value : 0., 0 );
 
     for( int h = 0; h < h_bins; h++ ) {
         for( int s = 0; s < s_bins; s++ ) {
-            float bin_val = cvQueryHistValue_2D( hist, h, s );
-            int intensity = cvRound( bin_val * 255 / max_value );
+            int intensity = cvRound( cvQueryHistValue_2D( hist, h, s ) );
             cvRectangle(
               hist_img,
               cvPoint( h*scale, s*scale ),
@@ -756,7 +1285,7 @@ CvHistogram* createHueSatHist(IplImage* img, CvRect selection, bool show) {
     	cvShowImage("img", img);
     	cvShowImage("hist", hist_img);
 
-    	char c = cvWaitKey(0);
+    	cvWaitKey(0);
     	cvDestroyWindow("img");
     	cvDestroyWindow("hist");
     }
@@ -764,12 +1293,7 @@ CvHistogram* createHueSatHist(IplImage* img, CvRect selection, bool show) {
 //    cvSaveImage("./images/calibrate_image_w_selection.jpg", copy);
     cvSaveImage("./images/calibrate_hist.jpg", hist_img);
 
-    cvReleaseImage(&hsv);
 //    cvReleaseImage(&copy);
-    cvReleaseImage(&hist_img);
-//    cvReleaseImage(&h_plane);
-//    cvReleaseImage(&s_plane);
-    cvReleaseImage(&v_plane);
 
     return hist;
 }
@@ -801,20 +1325,20 @@ void draw_selection(IplImage *img, CvRect selection) {
 }
 
 void test_huehist() {
-	IplImage *image = 0;
+	Image image;
 	CvRect sel;
 
-	image = cvLoadImage("./images/dl4.jpg");
+	image.reset(cvLoadImage("./images/dl4.jpg"));
 	sel = cvRect(230, 220, 150, 170);
 	draw_selection(image, sel);
 	createHueHist(image, sel, true);
 
-	image = cvLoadImage("./images/lml1.jpg");
+	image.reset(cvLoadImage("./images/lml1.jpg"));
 	sel = cvRect(150, 320, 100, 120);
 	draw_selection(image, sel);
 	createHueHist(image, sel, true);
 
-	image = cvLoadImage("./images/lncl4.jpg");
+	image.reset(cvLoadImage("./images/lncl4.jpg"));
 	sel = cvRect(150, 320, 100, 120);
 	draw_selection(image, sel);
 	createHueHist(image, sel, true);
@@ -822,11 +1346,74 @@ void test_huehist() {
 	// image of Thibault's example
 	// cmd line:
 	//  ./images/thib.jpg 330 360 75 60
-	image = cvLoadImage("./images/thib.jpg");
+	image.reset(cvLoadImage("./images/thib.jpg"));
 	sel = cvRect(330, 360, 75, 60);
 	draw_selection(image, sel);
 	createHueHist(image, sel, true);
-
-	cvReleaseImage(&image);
 }
 
+
+// fingershooter --tune labels.txt|synth:N [calib_image x y w h] [-j workers] [-g grid]
+// 		[-c cache] [-o out.csv]
+// labelled frames need the calibration selection for their histogram, synthetic scenes
+// take it from their first palm
+int tune_main(int argc, char* argv[]) {
+	int synth_frames = 0;
+	bool synth = argc >= 3 && sscanf(argv[2], "synth:%d", &synth_frames) == 1;
+	int first_opt = synth ? 3 : 8;
+	if(argc < first_opt || (synth && synth_frames <= 0)) {
+		printf("usage: %s --tune labels.txt calib_image x y width height [-j workers] "
+				"[-g grid] [-c cache] [-o out.csv]\n"
+				"       %s --tune synth:N [-j workers] [-g grid] [-c cache] [-o out.csv]\n",
+				argv[0], argv[0]);
+		return 1;
+	}
+	int num_workers = 0;
+	const char *grid = DEFAULT_TUNE_GRID;
+	const char *cache = "fingershooter_tune.cache";
+	const char *csv = NULL;
+	for(int i=first_opt; i<argc; i++) {
+		if(strcmp(argv[i], "-j") == 0 && i+1 < argc) {
+			num_workers = atoi(argv[++i]);
+		} else if(strcmp(argv[i], "-g") == 0 && i+1 < argc) {
+			grid = argv[++i];
+		} else if(strcmp(argv[i], "-c") == 0 && i+1 < argc) {
+			cache = argv[++i];
+		} else if(strcmp(argv[i], "-o") == 0 && i+1 < argc) {
+			csv = argv[++i];
+		} else {
+			printf("tune: unknown option %s\n", argv[i]);
+			return 1;
+		}
+	}
+	vector<TuneParams> sets;
+	if(!parse_tune_grid(grid, sets)) {
+		printf("tune: bad grid \"%s\", eg threshold=10,15,20:depth_pct=20,25,30\n", grid);
+		return 1;
+	}
+
+	TuneCorpus corpus;
+	Histogram hist;
+	if(synth) {
+		corpus.add_synth(synth_frames);
+		hist = make_synth_hist(*corpus.synth_params());
+	} else {
+		if(!corpus.load_labels(argv[2])) {
+			return 1;
+		}
+		Image calib(cvLoadImage(argv[3]));
+		if(!calib) {
+			printf("tune: can't load calibration image %s\n", argv[3]);
+			return 1;
+		}
+		CvRect selection = cvRect(atoi(argv[4]), atoi(argv[5]), atoi(argv[6]), atoi(argv[7]));
+		hist = calc_hue_hist(calib, selection);
+	}
+	if(!corpus.map_cache(cache, hist)) {
+		return 1;
+	}
+	vector<TuneResult> results;
+	run_sweep(corpus, sets, num_workers, results);
+	print_pareto(corpus, sets, results, csv);
+	return 0;
+}
@@ -0,0 +1,449 @@
+/*
+ * flight_recorder.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "flight_recorder.h"
+#include "batch.h"
+#include "benchmarks.h"
+#include "skin_lut.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <algorithm>
+#include <ctime>
+#include <signal.h>
+
+//******* unix/linux only for the pid in the incident names
+#include <unistd.h>
+
+using namespace std;
+
+// how fast the running mean frame time follows, per frame
+#define MEAN_RATE .05
+// seconds before spikes count, while the camera and caches settle
+#define WARMUP_SECS 2
+// hands a slot holds without allocating
+#define SLOT_HANDS 8
+
+static volatile sig_atomic_t dump_signalled = 0;
+
+static void on_dump_signal(int) {
+	dump_signalled = 1;
+}
+
+static const char* format_name(YuvFormat fmt) {
+	return fmt == YUV_NV12 ? "nv12" : "yuyv";
+}
+
+RecorderSettings::RecorderSettings()
+: secs(0), max_mb(256), fmt(YUV_YUYV), post_secs(1), spike_factor(3), spike_ms(30)
+{}
+
+bool parse_recorder_settings(const char *spec, RecorderSettings *s) {
+	char *end;
+	s->secs = strtod(spec, &end);
+	if(end == spec || s->secs < 0) {
+		return false;
+	}
+	while(*end == ':') {
+		const char *part = end + 1;
+		if(strncmp(part, "yuyv", 4) == 0) {
+			s->fmt = YUV_YUYV;
+			end = (char *)part + 4;
+		} else if(strncmp(part, "nv12", 4) == 0) {
+			s->fmt = YUV_NV12;
+			end = (char *)part + 4;
+		} else if(strncmp(part, "post=", 5) == 0) {
+			s->post_secs = strtod(part + 5, &end);
+			if(end == part + 5 || s->post_secs < 0) {
+				return false;
+			}
+		} else if(strncmp(part, "spike=", 6) == 0) {
+			s->spike_factor = strtod(part + 6, &end);
+			if(end == part + 6 || s->spike_factor < 0) {
+				return false;
+			}
+		} else if(strncmp(part, "mb=", 3) == 0) {
+			s->max_mb = strtod(part + 3, &end);
+			if(end == part + 3 || s->max_mb < 0) {
+				return false;
+			}
+		} else {
+			return false;
+		}
+	}
+	return *end == 0;
+}
+
+bool load_incident_hist(const char *jsonl_path, Histogram *hist) {
+	FILE *f = fopen(jsonl_path, "r");
+	if(!f) {
+		printf("can't read %s\n", jsonl_path);
+		return false;
+	}
+	string line;
+	int c;
+	while((c = fgetc(f)) != EOF && c != '\n') {
+		line += (char)c;
+	}
+	fclose(f);
+	const char *dims = strstr(line.c_str(), "\"hist_dims\":[");
+	const char *p = strstr(line.c_str(), "\"hist\":[");
+	int sizes[2] = { 0, 1 };
+	int ndims = dims ? sscanf(dims + 13, "%d,%d", &sizes[0], &sizes[1]) : 0;
+	if(ndims == 1 && sizes[0] == HUE_BINS) {
+		*hist = create_hue_hist_bins();
+	} else if(ndims == 2 && sizes[0] == HUESAT_H_BINS && sizes[1] == HUESAT_S_BINS) {
+		*hist = create_hue_sat_hist_bins();
+	} else {
+		printf("%s: no histogram on the incident line\n", jsonl_path);
+		return false;
+	}
+	p = p ? p + 8 : NULL;
+	for(int i=0; p && i<sizes[0] * sizes[1]; i++) {
+		char *end;
+		double v = strtod(p, &end);
+		if(end == p || (*end != ',' && *end != ']')) {
+			p = NULL;
+			break;
+		}
+		float *bin = ndims == 1 ? cvGetHistValue_1D(*hist, i) :
+				cvGetHistValue_2D(*hist, i / sizes[1], i % sizes[1]);
+		*bin = (float)v;
+		p = end + 1;
+	}
+	if(!p) {
+		printf("%s: the histogram's bins don't parse\n", jsonl_path);
+		hist->reset();
+		return false;
+	}
+	return true;
+}
+
+FlightRecorder::FlightRecorder()
+: fmt(YUV_YUYV), width(0), height(0), frame_bytes(0), slots(0), fps(0), written(0),
+  claimed(false), converter_started(false), convert_seq(-1), convert_to(NULL),
+  quitting(false), reason(NULL), post_frames(0), post_left(0), mean_ms(0), warmup(0),
+  cooldown(0), dumper_started(false), dumping(false), dump_next(0), dump_end(0),
+  dump_reason(NULL), incidents(0), dropped(0), busy(0), ignored(0)
+{
+	prefix[0] = 0;
+	pthread_mutex_init(&convert_lock, NULL);
+	pthread_cond_init(&convert_work, NULL);
+	pthread_cond_init(&convert_done, NULL);
+}
+
+FlightRecorder::~FlightRecorder() {
+	if(converter_started) {
+		pthread_mutex_lock(&convert_lock);
+		quitting = true;
+		pthread_cond_signal(&convert_work);
+		pthread_mutex_unlock(&convert_lock);
+		pthread_join(converter, NULL);
+	}
+	if(dumper_started) {
+		pthread_join(dumper, NULL);
+	}
+	pthread_cond_destroy(&convert_done);
+	pthread_cond_destroy(&convert_work);
+	pthread_mutex_destroy(&convert_lock);
+}
+
+void FlightRecorder::start(const RecorderSettings& _settings, double _fps, CvSize size,
+		YuvFormat _fmt) {
+	settings = _settings;
+	fmt = _fmt;
+	fps = _fps > 0 ? _fps : 15;
+	// yuv pairs pixels across, nv12 rows too
+	width = size.width & ~1;
+	height = fmt == YUV_NV12 ? size.height & ~1 : size.height;
+	frame_bytes = yuv_frame_bytes(fmt, width, height);
+	slots = max(1, (int)(settings.secs * fps + .5));
+	if(settings.max_mb > 0 && (double)slots * frame_bytes > settings.max_mb * (1 << 20)) {
+		slots = max(1, (int)(settings.max_mb * (1 << 20) / frame_bytes));
+		printf("recorder: %.1f s is over %.0f MB, keeping %.1f s\n", settings.secs,
+				settings.max_mb, slots / fps);
+	}
+	post_frames = (int)(settings.post_secs * fps + .5);
+	warmup = (long)(WARMUP_SECS * fps);
+	// every page touched now, not in the middle of the first frames
+	data.assign((size_t)slots * frame_bytes, 0);
+	ring.resize(slots);
+	for(int i=0; i<slots; i++) {
+		ring[i].seq = -1;
+		ring[i].frame_ms = 0;
+		ring[i].hands.reserve(SLOT_HANDS);
+	}
+	// this run's incidents sort together, and don't overwrite another run's
+	char stamp[32];
+	time_t now = time(NULL);
+	strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", localtime(&now));
+	sprintf(prefix, "incident_%s_%d", stamp, (int)getpid());
+	signal(SIGUSR1, on_dump_signal);
+	printf("recorder: last %d frames (%.1f s) of %dx%d %s, %.1f MB, 'f' or SIGUSR1 to dump\n",
+			slots, slots / fps, width, height, format_name(fmt),
+			(double)slots * frame_bytes / (1 << 20));
+}
+
+void FlightRecorder::set_hist(const CvHistogram *hist) {
+	int sizes[2] = { 0, 1 };
+	int dims = cvGetDims(hist->bins, sizes);
+	char buf[64];
+	if(dims == 2) {
+		sprintf(buf, ",\"hist_dims\":[%d,%d],\"hist\":[", sizes[0], sizes[1]);
+	} else {
+		sprintf(buf, ",\"hist_dims\":[%d],\"hist\":[", sizes[0]);
+	}
+	hist_json = buf;
+	for(int i=0; i<sizes[0]; i++) {
+		for(int j=0; j<sizes[1]; j++) {
+			// enough digits that the replay gets the same floats back
+			sprintf(buf, "%s%.9g", i || j ? "," : "", dims == 2 ?
+					cvQueryHistValue_2D(hist, i, j) : cvQueryHistValue_1D(hist, i));
+			hist_json += buf;
+		}
+	}
+	hist_json += "]";
+}
+
+uchar* FlightRecorder::claim() {
+	long seq = written;
+	if(dumping) {
+		__sync_synchronize();
+		long old = seq - slots;
+		if(old >= dump_next && old < dump_end) {
+			dropped++;
+			return NULL;
+		}
+	}
+	return &data[(size_t)(seq % slots) * frame_bytes];
+}
+
+void FlightRecorder::record(const IplImage *bgr) {
+	claimed = false;
+	if(!enabled() || bgr->width < width || bgr->height < height) {
+		return;
+	}
+	if(!converter_started) {
+		if(pthread_create(&converter, NULL, convert_main, this) != 0) {
+			fprintf(stderr, "recorder: can't start the conversion thread\n");
+			slots = 0;
+			return;
+		}
+		converter_started = true;
+	}
+	pthread_mutex_lock(&convert_lock);
+	bool converting = convert_seq >= 0;
+	pthread_mutex_unlock(&convert_lock);
+	// still on the last frame, and staging is what it's reading
+	if(converting) {
+		busy++;
+		return;
+	}
+	uchar *p = claim();
+	if(!p) {
+		return;
+	}
+	// the copy is all the loop pays, the conversion happens over there
+	staging.ensure(cvGetSize(bgr), 8, 3);
+	cvCopy(bgr, staging);
+	pthread_mutex_lock(&convert_lock);
+	convert_seq = written;
+	convert_to = p;
+	pthread_cond_signal(&convert_work);
+	pthread_mutex_unlock(&convert_lock);
+	claimed = true;
+}
+
+void* FlightRecorder::convert_main(void *arg) {
+	((FlightRecorder *)arg)->convert();
+	return NULL;
+}
+
+void FlightRecorder::convert() {
+	YuvFrame frame;
+	frame.fmt = fmt;
+	frame.width = width;
+	frame.height = height;
+	pthread_mutex_lock(&convert_lock);
+	while(1) {
+		while(convert_seq < 0 && !quitting) {
+			pthread_cond_wait(&convert_work, &convert_lock);
+		}
+		if(convert_seq < 0) {
+			break;
+		}
+		frame.data = convert_to;
+		pthread_mutex_unlock(&convert_lock);
+		bgr_to_yuv(staging, frame);
+		pthread_mutex_lock(&convert_lock);
+		convert_seq = -1;
+		pthread_cond_broadcast(&convert_done);
+	}
+	pthread_mutex_unlock(&convert_lock);
+}
+
+void FlightRecorder::record(const YuvFrame& raw) {
+	claimed = false;
+	if(!enabled() || raw.fmt != fmt || raw.width != width || raw.height != height) {
+		return;
+	}
+	uchar *p = claim();
+	if(!p) {
+		return;
+	}
+	memcpy(p, raw.data, frame_bytes);
+	claimed = true;
+}
+
+void FlightRecorder::end_frame(const vector<Hand>& hands, double frame_ms) {
+	if(!enabled()) {
+		return;
+	}
+	if(claimed) {
+		Slot& slot = ring[written % slots];
+		slot.seq = written;
+		slot.frame_ms = frame_ms;
+		slot.hands.assign(hands.begin(), hands.end());
+		// the slot is whole before the dump can see it -- bar a bgr frame's pixels,
+		// which the dump waits on the conversion for
+		__sync_synchronize();
+		written = written + 1;
+		claimed = false;
+	}
+	if(dump_signalled) {
+		dump_signalled = 0;
+		trigger("signal");
+	}
+	check_spike(frame_ms);
+	if(post_left > 0 && --post_left == 0) {
+		start_dump();
+	}
+}
+
+void FlightRecorder::check_spike(double frame_ms) {
+	if(settings.spike_factor <= 0) {
+		return;
+	}
+	if(warmup > 0) {
+		warmup--;
+		mean_ms = mean_ms ? mean_ms + MEAN_RATE * (frame_ms - mean_ms) : frame_ms;
+		return;
+	}
+	if(cooldown > 0) {
+		cooldown--;
+	} else if(frame_ms > settings.spike_factor * mean_ms &&
+			frame_ms > mean_ms + settings.spike_ms) {
+		printf("recorder: %.1f ms frame against a mean of %.1f\n", frame_ms, mean_ms);
+		trigger("latency spike");
+		// one incident, not one per slow frame
+		cooldown = slots;
+	}
+	mean_ms += MEAN_RATE * (frame_ms - mean_ms);
+}
+
+void FlightRecorder::trigger(const char *why) {
+	if(!enabled()) {
+		return;
+	}
+	if(post_left > 0 || dumping) {
+		ignored++;
+		printf("recorder: %s ignored, a dump is already under way\n", why);
+		return;
+	}
+	reason = why;
+	post_left = max(post_frames, 1);
+}
+
+void FlightRecorder::start_dump() {
+	if(dumping) {
+		ignored++;
+		return;
+	}
+	if(dumper_started) {
+		pthread_join(dumper, NULL);
+		dumper_started = false;
+	}
+	dump_end = written;
+	dump_next = max(0L, dump_end - slots);
+	dump_reason = reason;
+	incidents++;
+	dumping = true;
+	__sync_synchronize();
+	if(pthread_create(&dumper, NULL, dump_main, this) != 0) {
+		fprintf(stderr, "recorder: can't start the dump thread\n");
+		dumping = false;
+		return;
+	}
+	dumper_started = true;
+}
+
+void* FlightRecorder::dump_main(void *arg) {
+	((FlightRecorder *)arg)->dump();
+	return NULL;
+}
+
+void FlightRecorder::dump() {
+	int64 start = cvGetTickCount();
+	// the last frames may still be in conversion
+	pthread_mutex_lock(&convert_lock);
+	while(convert_seq >= 0 && convert_seq < dump_end) {
+		pthread_cond_wait(&convert_done, &convert_lock);
+	}
+	pthread_mutex_unlock(&convert_lock);
+	char yuv_name[96], jsonl_name[96];
+	sprintf(yuv_name, "%s_%d.yuv", prefix, incidents);
+	sprintf(jsonl_name, "%s_%d.jsonl", prefix, incidents);
+	FILE *yuv = fopen(yuv_name, "wb");
+	FILE *jsonl = fopen(jsonl_name, "w");
+	long from = dump_next, to = dump_end;
+	string records, times;
+	char buf[64];
+	for(long seq=from; seq<to; seq++) {
+		const Slot& slot = ring[seq % slots];
+		if(yuv) {
+			fwrite(&data[(size_t)(seq % slots) * frame_bytes], 1, frame_bytes, yuv);
+		}
+		append_hands_record(records, yuv_name, (int)(seq - from), slot.hands);
+		sprintf(buf, "%s%.2f", seq > from ? "," : "", slot.frame_ms);
+		times += buf;
+		// the loop may have this slot back now
+		__sync_synchronize();
+		dump_next = seq + 1;
+	}
+	if(jsonl) {
+		fprintf(jsonl, "{\"incident\":%d,\"reason\":\"%s\",\"format\":\"%s\",\"width\":%d,"
+				"\"height\":%d,\"fps\":%.2f,\"frames\":%ld,\"frame_ms\":[%s]%s}\n", incidents,
+				dump_reason, format_name(fmt), width, height, fps, to - from, times.c_str(),
+				hist_json.c_str());
+		fwrite(records.data(), 1, records.size(), jsonl);
+		fclose(jsonl);
+	}
+	if(yuv) {
+		fclose(yuv);
+	}
+	if(!yuv || !jsonl) {
+		fprintf(stderr, "recorder: can't write %s / %s\n", yuv_name, jsonl_name);
+	} else {
+		// without a histogram the replay needs a selection in the first frame instead
+		printf("recorder: incident %d (%s), %ld frames written in %.0f ms -- replay with\n"
+				"  fingershooter --yuv %s %dx%d %s %s\n", incidents, dump_reason, to - from,
+				ticks_to_ms(cvGetTickCount() - start), format_name(fmt), width, height,
+				yuv_name, hist_json.empty() ? "x y width height" : jsonl_name);
+	}
+	__sync_synchronize();
+	dumping = false;
+}
+
+void FlightRecorder::print_stats() const {
+	if(!enabled()) {
+		return;
+	}
+	printf("FlightRecorder: %ld frames recorded, %d incidents dumped, %ld frames not "
+			"recorded while a dump caught up, %ld while the conversion did, %ld triggers "
+			"ignored\n", (long)written, incidents, dropped, busy, ignored);
+}
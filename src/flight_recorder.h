@@ -0,0 +1,185 @@
+/*
+ * flight_recorder.h
+ *
+ * Keeps the last few seconds of input so an incident can be replayed offline.  Off
+ * unless asked for (--record secs), and then every frame goes into a ring allocated up
+ * front -- capped at max_mb, fewer seconds if it comes to more -- as it came off the
+ * camera (before any bullets are drawn on it), with the hands found in it and how long
+ * the frame took.  Frames are kept as raw YUV -- the camera's own YUYV / NV12 with
+ * --yuv, else the BGR frame converted, YUYV by default or NV12 for half the memory of
+ * BGR.  The conversion runs on a thread of its own: the loop only copies the frame
+ * aside, and if the converter is still on the last one this frame isn't recorded.
+ *
+ * A dump is triggered by
+ *
+ * 	the 'f' key
+ * 	SIGUSR1, eg "kill -USR1 <pid>" from outside
+ * 	a latency spike -- a frame taking spike_factor times the running mean, and at
+ * 	least spike_ms more
+ *
+ * and carries on recording post_secs after the trigger so the aftermath is in it too.
+ * The dump runs on a thread of its own while the loop carries on:
+ *
+ * 	incident_<start>_<pid>_N.yuv     the frames, back to back
+ * 	incident_<start>_<pid>_N.jsonl   a line on the incident (with the skin histogram
+ * 	                                 the frames were backprojected with), then a line
+ * 	                                 per frame with its hands, as --batch writes them
+ *
+ * and replayed with
+ *
+ * 	fingershooter --yuv yuyv|nv12 WxH incident_..._N.yuv incident_..._N.jsonl
+ *
+ * which takes the histogram from the incident line, there being no camera to
+ * calibrate from.
+ *
+ * where start is when the recorder started (YYYYmmdd-HHMMSS), so one run's incidents
+ * sort together and never overwrite another's.
+ *
+ * The loop never waits on the dump.  If it comes round to a slot the dump hasn't
+ * written yet, that frame just isn't recorded.
+ * Implementation in flight_recorder.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef FLIGHT_RECORDER_H_
+#define FLIGHT_RECORDER_H_
+
+#include "cv.h"
+#include <vector>
+#include <string>
+
+//******* unix/linux only for the dump and conversion threads
+#include <pthread.h>
+
+#include "cv_handles.h"
+#include "hand_detector.h"
+#include "yuv_source.h"
+
+struct RecorderSettings {
+	RecorderSettings();
+
+	// [0] seconds kept, 0 for no recorder
+	double secs;
+	// most memory the ring takes, in MB, 0 for no cap
+	double max_mb;
+	// how BGR frames are kept, raw frames are kept as they are
+	YuvFormat fmt;
+	// recorded after a trigger before the dump starts
+	double post_secs;
+	// a frame this many times the running mean, and spike_ms over it, is a spike
+	// spike_factor 0 for no automatic dumps
+	double spike_factor;
+	double spike_ms;
+};
+
+// "secs[:yuyv|nv12][:post=secs][:spike=factor][:mb=cap]", eg "10:nv12:spike=4"
+bool parse_recorder_settings(const char *spec, RecorderSettings *s);
+
+// the histogram an incident's jsonl was recorded with, from its first line
+// false (and a message) if the file can't be read or has no histogram of a layout
+// calibration makes
+bool load_incident_hist(const char *jsonl_path, Histogram *hist);
+
+class FlightRecorder {
+public:
+	FlightRecorder();
+	// waits for a dump in progress, and the conversion thread
+	~FlightRecorder();
+
+	// allocates the ring for settings.secs at fps frames of size (up to max_mb), and
+	// takes SIGUSR1
+	// fmt -- how frames are kept, the raw frames' own format for record(YuvFrame)
+	void start(const RecorderSettings& settings, double fps, CvSize size, YuvFormat fmt);
+	bool enabled() const { return slots > 0; }
+	// the histogram the frames are backprojected with, copied into every incident
+	// line for the replay -- 1D hue or 2D hue/sat as calibration makes them
+	void set_hist(const CvHistogram *hist);
+
+	// this frame as it came in, before anything is drawn on it
+	// bgr is copied, and converted on the conversion thread
+	void record(const IplImage *bgr);
+	void record(const YuvFrame& raw);
+	// what the frame came to, call once per frame after record
+	// frame_ms -- capture to display
+	void end_frame(const std::vector<Hand>& hands, double frame_ms);
+
+	// dump the ring after post_secs more frames, unless a dump is already coming
+	void trigger(const char *reason);
+
+	void print_stats() const;
+
+private:
+	struct Slot {
+		long seq;
+		double frame_ms;
+		std::vector<Hand> hands;
+	};
+
+	static void* dump_main(void *arg);
+	static void* convert_main(void *arg);
+	// on the conversion thread, staging into the slots until told to quit
+	void convert();
+	// hands what's in the ring to the dump thread
+	void start_dump();
+	// on the dump thread
+	void dump();
+	// frame_ms against the running mean
+	void check_spike(double frame_ms);
+	// the slot a new frame goes in, NULL if the dump still needs what's there
+	uchar* claim();
+
+	RecorderSettings settings;
+	YuvFormat fmt;
+	int width, height;
+	int frame_bytes;
+	int slots;
+	double fps;
+	std::vector<uchar> data;
+	std::vector<Slot> ring;
+	// set_hist's dims and bins as fields of the incident line, empty until it's called
+	std::string hist_json;
+
+	// frames recorded, the next one is seq written
+	volatile long written;
+	// the frame being recorded was claimed
+	bool claimed;
+
+	// the conversion -- staging is the copied bgr frame, going into convert_to for
+	// frame convert_seq, -1 when there's nothing to do
+	Image staging;
+	pthread_t converter;
+	bool converter_started;
+	pthread_mutex_t convert_lock;
+	pthread_cond_t convert_work;
+	pthread_cond_t convert_done;
+	long convert_seq;
+	uchar *convert_to;
+	bool quitting;
+
+	// trigger, counting down to the dump
+	const char *reason;
+	int post_frames;
+	int post_left;
+	// spike detection
+	double mean_ms;
+	long warmup;
+	long cooldown;
+
+	// the dump -- [dump_next, dump_end) still to write, dumping until it's done
+	pthread_t dumper;
+	bool dumper_started;
+	volatile bool dumping;
+	volatile long dump_next;
+	long dump_end;
+	const char *dump_reason;
+	int incidents;
+	// incident_<start>_<pid>
+	char prefix[64];
+
+	long dropped;
+	long busy;
+	long ignored;
+};
+
+#endif /* FLIGHT_RECORDER_H_ */
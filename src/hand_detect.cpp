@@ -0,0 +1,174 @@
+/*
+ * hand_detect.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "hand_detect.h"
+#include "hue_kernel.h"
+#include "trace.h"
+
+using namespace std;
+
+HandFinder::HandFinder(const RuntimeHandConfig& cfg, int num_workers, bool motion,
+		TaskPool::ThreadInit init, void *init_arg)
+: detector(cfg), contour_pool(NULL), gate(NULL)
+{
+	if(num_workers != 1) {
+		contour_pool = new TaskPool(num_workers, init, init_arg);
+		detector.set_pool(contour_pool);
+	}
+	if(motion) {
+		gate = new MotionGate();
+	}
+}
+
+HandFinder::~HandFinder() {
+	delete gate;
+	delete contour_pool;
+}
+
+int HandFinder::find(
+		IplImage* mask,
+		vector<Hand>& hands,
+		float perimScale,
+		DebugOverlay* overlay,
+		bool mask_cleaned,
+		LatencyBudget* budget) {
+	hands.clear();
+	if(overlay) {
+		overlay->clear();
+	}
+
+	IplImage *search = mask;
+	int factor = budget ? budget->downscale() : 1;
+	if(factor > 1) {
+		coarse.ensure(cvSize(mask->width / factor, mask->height / factor), 8, 1);
+		cvResize(mask, coarse, CV_INTER_NN);
+		search = coarse;
+		if(overlay) {
+			overlay->set_scale(factor);
+		}
+	}
+
+	detector.set_budget(budget);
+	detector.set_motion(gate, factor);
+	if(!mask_cleaned) {
+		detector.clean(search);
+	}
+	detector.find(search, hands, perimScale, overlay);
+	if(budget && detector.capped()) {
+		budget->note_contours_capped();
+	}
+	if(gate) {
+		gate->note_contours_reused(detector.reused());
+	}
+
+	if(factor > 1) {
+		for(size_t i=0; i<hands.size(); i++) {
+			scale_hand(hands[i], factor);
+		}
+		if(overlay) {
+			overlay->set_scale(1);
+		}
+	}
+	return (int)hands.size();
+}
+
+// [NULL] the app's finder for find_hands, see set_hand_finder
+static HandFinder *app_finder = NULL;
+
+void set_hand_finder(HandFinder *finder) {
+	app_finder = finder;
+}
+
+int find_hands(
+		IplImage* mask,
+		vector<Hand>& hands,
+		float perimScale,
+		DebugOverlay* overlay,
+		bool mask_cleaned,
+		LatencyBudget* budget) {
+	if(!app_finder) {
+		// nobody set one -- serial, default knobs, for as long as the program runs
+		static HandFinder defaults;
+		return defaults.find(mask, hands, perimScale, overlay, mask_cleaned, budget);
+	}
+	return app_finder->find(mask, hands, perimScale, overlay, mask_cleaned, budget);
+}
+
+HandDetectBatch::HandDetectBatch(int num_workers, float _perim_scale,
+		const RuntimeHandConfig& cfg)
+: pool(num_workers), perim_scale(_perim_scale), masks(NULL), frames(NULL),
+  hands(NULL), cleaned(false)
+{
+	workers.resize(pool.size());
+	for(size_t i=0; i<workers.size(); i++) {
+		workers[i] = new Worker(cfg);
+	}
+}
+
+HandDetectBatch::~HandDetectBatch() {
+	for(size_t i=0; i<workers.size(); i++) {
+		delete workers[i];
+	}
+}
+
+void HandDetectBatch::detect_task(void *arg, int task, int worker) {
+	HandDetectBatch *self = (HandDetectBatch *)arg;
+	Worker& w = *self->workers[worker];
+	TRACE_SCOPE_ARG("batch frame", task);
+	IplImage *mask;
+	bool clean = !self->cleaned;
+	if(self->frames) {
+		const IplImage *frame = self->frames[task];
+		IplImage *hue_plane = w.hue.ensure( cvGetSize(frame), 8, 1 );
+		mask = w.mask.ensure( cvGetSize(frame), 8, 1 );
+		bgr_to_hue( frame, hue_plane );
+		self->hue_lut.backproject( hue_plane, mask );
+		clean = true;
+	} else {
+		mask = self->masks[task];
+	}
+	vector<Hand>& hands = self->hands[task];
+	hands.clear();
+	if(clean) {
+		w.detector.clean(mask);
+	}
+	w.detector.find(mask, hands, self->perim_scale);
+	w.misshapen += w.detector.misshapen();
+}
+
+void HandDetectBatch::detect(IplImage *const *_masks, int k, vector<Hand> *_hands,
+		bool _cleaned) {
+	masks = _masks;
+	frames = NULL;
+	hands = _hands;
+	cleaned = _cleaned;
+	for(size_t i=0; i<workers.size(); i++) {
+		workers[i]->misshapen = 0;
+	}
+	pool.run(detect_task, this, k);
+}
+
+void HandDetectBatch::detect_frames(const IplImage *const *_frames, int k,
+		const Histogram& hist, vector<Hand> *_hands) {
+	masks = NULL;
+	frames = _frames;
+	// the histogram may have been recalibrated since the last call
+	hue_lut.build(hist);
+	hands = _hands;
+	cleaned = false;
+	for(size_t i=0; i<workers.size(); i++) {
+		workers[i]->misshapen = 0;
+	}
+	pool.run(detect_task, this, k);
+}
+
+long HandDetectBatch::misshapen() const {
+	long n = 0;
+	for(size_t i=0; i<workers.size(); i++) {
+		n += workers[i]->misshapen;
+	}
+	return n;
+}
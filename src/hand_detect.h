@@ -0,0 +1,149 @@
+/*
+ * hand_detect.h
+ *
+ * The handdetect library's entry points -- a skin mask (or frames and a skin
+ * histogram) in, Hands out.  No bullets, no windows: what to do with the hands is up
+ * to the caller, fingershooter fires bullets from them (see open_hands.h).
+ *
+ * 	HandFinder          one mask at a time, with what the live loop needs -- debug
+ * 	                    overlay, latency budget, and its own detector, pool for the
+ * 	                    contours and motion gate, so any number of them can run side by
+ * 	                    side (one per camera, one per thread)
+ * 	find_hands          the same through the HandFinder the app set with
+ * 	                    set_hand_finder, or a serial default one
+ * 	HandDetectBatch     K masks or frames per call, the frames spread over a pool,
+ * 	                    each worker with its own detector and buffers kept from call
+ * 	                    to call, so the setup is paid once rather than per frame
+ *
+ * Both take the detector's knobs as a RuntimeHandConfig, so a set --tune picked can be
+ * used as is.  Either way a frame gets the same hands, in the same order.
+ * Implementation in hand_detect.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef HAND_DETECT_H_
+#define HAND_DETECT_H_
+
+#include "cv.h"
+#include <vector>
+
+#include "hand_detector.h"
+#include "cv_handles.h"
+#include "debug_overlay.h"
+#include "latency_budget.h"
+#include "motion_gate.h"
+#include "task_pool.h"
+#include "skin_lut.h"
+
+class HandFinder {
+public:
+	// cfg -- the detector's knobs
+	// num_workers -- [1] candidate contours (hull, defects, fingertips) are analysed in
+	// 		parallel on a pool of this many, the calling thread included, 1 for serially,
+	// 		0 for one per core
+	// motion -- [false] keep a motion gate: update() it (see motion()) with each frame,
+	// 		and contours in blocks that didn't change reuse last frame's analysis
+	// init, init_arg -- [NULL] as TaskPool's, run on each of the pool's own threads
+	HandFinder(const RuntimeHandConfig& cfg = RuntimeHandConfig(), int num_workers = 1,
+			bool motion = false, TaskPool::ThreadInit init = NULL, void *init_arg = NULL);
+	~HandFinder();
+
+	// owns its pool and gate
+	HandFinder(const HandFinder&) = delete;
+	HandFinder& operator=(const HandFinder&) = delete;
+
+	// as find_hands below
+	int find(IplImage* mask, std::vector<Hand>& hands, float perimScale = 4,
+			DebugOverlay* overlay = NULL, bool mask_cleaned = false,
+			LatencyBudget* budget = NULL);
+
+	// [NULL] the pool, eg for a TilePipeline to share, NULL when serial
+	TaskPool* pool() const { return contour_pool; }
+	// [NULL] the motion gate, for the caller to update() with each frame
+	MotionGate* motion() const { return gate; }
+	const RuntimeHandConfig& config() const { return detector.cfg; }
+
+private:
+	HandDetector<RuntimeHandConfig> detector;
+	TaskPool *contour_pool;
+	MotionGate *gate;
+	// half size mask for coarse mode
+	Image coarse;
+};
+
+// finder -- [NULL] the HandFinder find_hands goes through, not owned -- NULL for a
+// serial one with the default knobs, made on first use
+void set_hand_finder(HandFinder *finder);
+
+/** finds the open hands in a mask, with the HandFinder set by set_hand_finder
+ * param: mask - backprojection style mask, thresholded and opened / closed in place
+ * 			unless mask_cleaned, then scribbled on by the contour search
+ * param: hands - output, cleared first, in contour scan order
+ * param: perimScale - [4] contours with len < image-perimeter len / perimScale will
+ * 			be ignored
+ * param: overlay - [NULL] if not null, cleared and debug imagery recorded into it
+ * param: mask_cleaned - [false] if true, mask goes straight to the contour search
+ * param: budget - [NULL] if not null, the contour search stops when the frame's time
+ * 			is up and runs on a half size mask when the budget says to go coarse
+ * returns the number of hands
+ */
+int find_hands(
+		IplImage* mask,
+		std::vector<Hand>& hands,
+		float perimScale = 4,
+		DebugOverlay* overlay = NULL,
+		bool mask_cleaned = false,
+		LatencyBudget* budget = NULL);
+
+class HandDetectBatch {
+public:
+	// num_workers -- including the calling thread, 0 for one per core
+	// perim_scale -- as find_hands' perimScale
+	// cfg -- the detector's knobs, every worker's
+	HandDetectBatch(int num_workers = 0, float perim_scale = 4,
+			const RuntimeHandConfig& cfg = RuntimeHandConfig());
+	~HandDetectBatch();
+
+	// masks -- k raw backprojections, cleaned in place (unless cleaned is set) and
+	// scribbled on by the contour search
+	// hands -- output, k of them, hands[i] is masks[i]'s
+	void detect(IplImage *const *masks, int k, std::vector<Hand> *hands,
+			bool cleaned = false);
+
+	// frames -- k 8 bit BGR frames, backprojected against hist (a 1D hue histogram, as
+	// calibrate makes, expanded into a HueLut once per call) into each worker's own
+	// buffers, the frames aren't touched
+	// hands -- output, k of them, hands[i] is frames[i]'s
+	void detect_frames(const IplImage *const *frames, int k, const Histogram& hist,
+			std::vector<Hand> *hands);
+
+	int size() const { return pool.size(); }
+	// candidates with a hand's defects but not its shape, over the last call
+	long misshapen() const;
+
+private:
+	struct Worker {
+		Worker(const RuntimeHandConfig& cfg) : detector(cfg), misshapen(0) {}
+
+		HandDetector<RuntimeHandConfig> detector;
+		Image hue, mask;
+		long misshapen;
+	};
+
+	static void detect_task(void *arg, int task, int worker);
+
+	TaskPool pool;
+	float perim_scale;
+	std::vector<Worker*> workers;
+
+	// the call under way
+	IplImage *const *masks;
+	const IplImage *const *frames;
+	// detect_frames' histogram, only read by the workers
+	HueLut hue_lut;
+	std::vector<Hand> *hands;
+	bool cleaned;
+};
+
+#endif /* HAND_DETECT_H_ */
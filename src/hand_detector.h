@@ -0,0 +1,714 @@
+/*
+ * hand_detector.h
+ *
+ * HandDetector<Config> -- the contour / convexity defect search from find_hands_and_shoot,
+ * with the tunables pulled out into a Config class.  DefaultHandConfig has them as
+ * compile time constants so the comparisons against them fold to immediates (the loops
+ * still run to the contour's and defects' runtime counts), RuntimeHandConfig has the
+ * same names as plain members so they can be tweaked while tuning.  Both go through
+ * the same code since cfg.threshold reads the same way whether threshold is a static
+ * const or a member.
+ *
+ * The hull and defects are found on the contour simplified with Douglas-Peucker
+ * (cvApproxPoly), the tolerance a fraction of the candidate's size so it means the same
+ * at any resolution -- a big hand at 1080p is thousands of contour points, simplified
+ * it's a few dozen.  The polygon's vertices are contour points, so tips are exact; a
+ * defect close enough to the depth threshold to be decided by the simplification gets
+ * its depth point back from the full contour.  With shape_tolerance_pct set, a
+ * candidate with the right number of deep defects must also be shaped like a hand (Hu
+ * moments of the polygon against reference hands, see hand_shape.h) or it's dropped
+ * before anything fires from it.
+ *
+ * Contours are collected serially (the scanner can't be split), then each candidate's
+ * hull / defect analysis can run on a TaskPool with per worker storage.  Results are
+ * merged back in scan order so the hands come out the same either way.  With a
+ * MotionGate set, candidates in still parts of the frame keep last frame's answer.
+ *
+ * Header only since it's a template.
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef HAND_DETECTOR_H_
+#define HAND_DETECTOR_H_
+
+#include "cv.h"
+
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+
+#include "debug_overlay.h"
+#include "latency_budget.h"
+#include "task_pool.h"
+#include "motion_gate.h"
+#include "cv_handles.h"
+#include "hand_shape.h"
+#include "pixel_kernels.h"
+#include "trace.h"
+
+// most deep defects a config can accept as a hand
+#define HAND_MAX_DEFECTS 8
+// each defect contributes at most its start and end point
+#define HAND_MAX_TIPS (2 * HAND_MAX_DEFECTS)
+
+// an open hand found in a mask
+struct Hand {
+	CvRect bbox;
+	CvPoint center;
+	// fingertips, near duplicates already merged
+	int num_tips;
+	CvPoint tips[HAND_MAX_TIPS];
+	// the deep enough convexity defects, ie the gaps between fingers
+	int num_defects;
+	CvPoint depth_points[HAND_MAX_DEFECTS];
+	float depths[HAND_MAX_DEFECTS];
+};
+
+// hand found in a mask downscaled by factor, back to full size coordinates
+inline void scale_hand(Hand& hand, int factor) {
+	hand.bbox = cvRect(hand.bbox.x * factor, hand.bbox.y * factor,
+			hand.bbox.width * factor, hand.bbox.height * factor);
+	hand.center = cvPoint(hand.center.x * factor, hand.center.y * factor);
+	for(int i=0; i<hand.num_tips; i++) {
+		hand.tips[i] = cvPoint(hand.tips[i].x * factor, hand.tips[i].y * factor);
+	}
+	for(int i=0; i<hand.num_defects; i++) {
+		hand.depth_points[i] = cvPoint(hand.depth_points[i].x * factor,
+				hand.depth_points[i].y * factor);
+		hand.depths[i] *= factor;
+	}
+}
+
+// the values find_hands_and_shoot has always used
+struct DefaultHandConfig {
+	// backprojection values above this are skin
+	static const int threshold = 15;
+	// iterations of open and of close on the mask
+	static const int close_itr = 1;
+	// square morphology kernel side
+	static const int kernel_size = 3;
+	// a hand has min_fingers to max_fingers deep defects (inclusive)
+	static const int min_fingers = 4;
+	static const int max_fingers = 6;
+	// defect is deep enough if depth > depth_pct% of the bbox's smaller side
+	static const int depth_pct = 25;
+	// end point is the same fingertip as another if closer than proximity_pct%
+	// of the first defect's depth
+	static const int proximity_pct = 30;
+	// contours narrower than mask->width / too_small_div are ignored
+	static const int too_small_div = 10;
+	// contour simplified to within approx_permille / 1000 of the bbox's smaller side
+	// before the hull and defects, 0 uses every contour point
+	static const int approx_permille = 10;
+	// defects the simplification could have put on the wrong side of the depth
+	// threshold are measured again on the full contour
+	static const bool refine_depth = true;
+	// a hand's polygon is within shape_tolerance_pct% of a reference hand's Hu
+	// moments (see hand_shape.h), 0 accepts any shape with the right defects -- off
+	// until it's been measured on recorded camera hands, the references and the
+	// OPEN_HAND_TOLERANCE_PCT it was tuned to are synthetic
+	static const int shape_tolerance_pct = 0;
+};
+
+// same knobs, settable at run time -- starts out at the defaults
+struct RuntimeHandConfig {
+	int threshold;
+	int close_itr;
+	int kernel_size;
+	int min_fingers;
+	int max_fingers;
+	int depth_pct;
+	int proximity_pct;
+	int too_small_div;
+	int approx_permille;
+	bool refine_depth;
+	int shape_tolerance_pct;
+
+	RuntimeHandConfig()
+	: threshold(DefaultHandConfig::threshold),
+	  close_itr(DefaultHandConfig::close_itr),
+	  kernel_size(DefaultHandConfig::kernel_size),
+	  min_fingers(DefaultHandConfig::min_fingers),
+	  max_fingers(DefaultHandConfig::max_fingers),
+	  depth_pct(DefaultHandConfig::depth_pct),
+	  proximity_pct(DefaultHandConfig::proximity_pct),
+	  too_small_div(DefaultHandConfig::too_small_div),
+	  approx_permille(DefaultHandConfig::approx_permille),
+	  refine_depth(DefaultHandConfig::refine_depth),
+	  shape_tolerance_pct(DefaultHandConfig::shape_tolerance_pct)
+	  {}
+};
+
+template <class Config>
+class HandDetector {
+public:
+	Config cfg;
+
+	HandDetector(const Config& _cfg = Config())
+	: cfg(_cfg), kernel(NULL), kernel_side(0),
+	  perim_size(cvSize(0, 0)), perim_scale(0), perim_threshold(0),
+	  budget(NULL), pool(NULL), was_capped(false), capped_flag(0),
+	  motion(NULL), motion_scale(1), num_reused(0), num_misshapen(0)
+	{}
+
+	// owns its structuring element and per worker scratch, so never copied
+	HandDetector(const HandDetector&) = delete;
+	HandDetector& operator=(const HandDetector&) = delete;
+
+	~HandDetector() {
+		if(kernel) {
+			cvReleaseStructuringElement(&kernel);
+		}
+		for(size_t i=0; i<scratch.size(); i++) {
+			delete scratch[i];
+		}
+	}
+
+	// threshold and open/close the raw mask in place
+	// the default 3x3 kernel goes through the SIMD kernels (pixel_kernels.h), same result
+	void clean(IplImage *mask) {
+		TRACE_SCOPE("morphology");
+		threshold_binary( mask, mask, cfg.threshold );
+		if(cfg.kernel_size == 3) {
+			open_close_3x3( mask, cfg.close_itr, morph_tmp.ensure( cvGetSize(mask), 8, 1 ) );
+			return;
+		}
+		IplConvKernel *k = morph_kernel();
+		cvMorphologyEx( mask, mask, 0, k, CV_MOP_OPEN, cfg.close_itr );
+		cvMorphologyEx( mask, mask, 0, k, CV_MOP_CLOSE, cfg.close_itr );
+	}
+
+	// find open hands in an already cleaned binary mask
+	// mask is scribbled on by the contour scanner
+	// hands -- output, appended to, in contour scan order
+	// perimScale -- contours with len < image-perimeter len / perimScale are ignored
+	// overlay -- [NULL] if not null, debug imagery is recorded into it
+	// returns number of hands found
+	int find(IplImage *mask, std::vector<Hand>& hands, float perimScale,
+			DebugOverlay *overlay = NULL);
+
+	// [NULL] if set, find() stops analysing contours when the budget runs out or
+	// budget->max_contours() have been analysed
+	void set_budget(const LatencyBudget *_budget) { budget = _budget; }
+	// true if the last find() left contours unexamined because of the budget
+	bool capped() const { return was_capped; }
+
+	// [NULL] if set, the candidate contours are analysed in parallel on the pool
+	// (not owned), each worker with its own storage -- results are the same as serial
+	void set_pool(TaskPool *_pool) { pool = _pool; }
+
+	// [NULL] if set, candidates whose bounding box is the same as last frame's and
+	// touches no changed block reuse last frame's analysis instead of being redone
+	// scale -- mask coordinates * scale = frame coordinates (for downscaled masks)
+	void set_motion(const MotionGate *_motion, int scale = 1) {
+		if(scale != motion_scale) {
+			// last frame's boxes are in other coordinates
+			prev_boxes.clear();
+			prev_results.clear();
+		}
+		motion = _motion;
+		motion_scale = scale;
+	}
+	// candidates the last find() took from the previous frame
+	int reused() const { return num_reused; }
+	// candidates the last find() dropped for not being hand shaped
+	int misshapen() const { return num_misshapen; }
+
+	// clean + find
+	int detect(IplImage *mask, std::vector<Hand>& hands, float perimScale,
+			DebugOverlay *overlay = NULL) {
+		clean(mask);
+		return find(mask, hands, perimScale, overlay);
+	}
+
+private:
+	// contour that passed the cheap size checks
+	struct Candidate {
+		CvSeq *c;
+		CvRect bb;
+		int min_width_across;
+		// debug colors come from here so they don't depend on which thread runs
+		unsigned color_seed;
+	};
+	// what analysing a candidate came up with
+	struct Result {
+		// false if the budget ran out first, is_hand is then only a placeholder
+		bool analysed;
+		bool is_hand;
+		Hand hand;
+	};
+	// per worker buffers
+	struct Scratch {
+		// defects
+		MemStorage storage;
+		// hull indices
+		std::vector<int> hull_idx;
+		// contour points, filled in for debug recording and depth refinement
+		std::vector<CvPoint> contour_pts;
+		std::vector<CvPoint> hull_pts;
+		// simplified contour points, and the contour index of each
+		std::vector<CvPoint> poly_pts;
+		std::vector<int> poly_idx;
+	};
+
+	static void analyse_task(void *arg, int task, int worker) {
+		HandDetector *self = (HandDetector *)arg;
+		self->analyse(self->todo[task], *self->scratch_for(worker));
+	}
+
+	// index of last frame's result for an unchanged candidate, -1 if it needs analysing
+	// (including when last frame never got round to it)
+	int previous_result(const Candidate& cand) const {
+		if(!motion || motion->region_changed(cand.bb, motion_scale)) {
+			return -1;
+		}
+		for(size_t j=0; j<prev_boxes.size(); j++) {
+			const CvRect& r = prev_boxes[j];
+			if(r.x == cand.bb.x && r.y == cand.bb.y &&
+					r.width == cand.bb.width && r.height == cand.bb.height) {
+				return prev_results[j].analysed ? (int)j : -1;
+			}
+		}
+		return -1;
+	}
+
+	// hull, defects, deep enough defects, fingertips for candidates[i] into results[i]
+	void analyse(int i, Scratch& s);
+
+	Scratch* scratch_for(int worker) {
+		if(!scratch[worker]) {
+			scratch[worker] = new Scratch();
+		}
+		return scratch[worker];
+	}
+
+	// NULL means cvMorphologyEx's default 3x3 rect
+	IplConvKernel* morph_kernel() {
+		if(cfg.kernel_size == 3) {
+			return NULL;
+		}
+		if(kernel_side != cfg.kernel_size) {
+			if(kernel) {
+				cvReleaseStructuringElement(&kernel);
+			}
+			kernel_side = cfg.kernel_size;
+			kernel = cvCreateStructuringElementEx(kernel_side, kernel_side,
+					kernel_side/2, kernel_side/2, CV_SHAPE_RECT);
+		}
+		return kernel;
+	}
+
+	// perimeter threshold only changes with the mask size or perimScale
+	double min_perimeter(IplImage *mask, float perimScale) {
+		if(mask->width != perim_size.width || mask->height != perim_size.height ||
+				perimScale != perim_scale) {
+			perim_size = cvGetSize(mask);
+			perim_scale = perimScale;
+			perim_threshold = (mask->height + mask->width)/perimScale;
+		}
+		return perim_threshold;
+	}
+
+	// s.poly_pts from poly, unless read is already set
+	static void read_poly(CvSeq *poly, Scratch& s, bool& read) {
+		if(!read) {
+			s.poly_pts.resize(poly->total);
+			cvCvtSeqToArray(poly, &s.poly_pts[0]);
+			read = true;
+		}
+	}
+
+	// fills hand's tips from the start and end points of its defects
+	void find_tips(Hand& hand, CvConvexityDefect **defects, int n);
+
+	// s.poly_idx from s.contour_pts and s.poly_pts, false if a vertex isn't on the contour
+	static bool map_poly_to_contour(Scratch& s);
+	// d's depth point and depth from the contour points between its start and end
+	static void refine_defect(CvConvexityDefect *d, CvSeq *poly, Scratch& s);
+
+	// contours
+	MemStorage storage;
+	// open_close_3x3's scratch
+	Image morph_tmp;
+	IplConvKernel *kernel;
+	int kernel_side;
+	CvSize perim_size;
+	float perim_scale;
+	double perim_threshold;
+	const LatencyBudget *budget;
+	TaskPool *pool;
+	bool was_capped;
+	// set by any worker that ran out of budget
+	int capped_flag;
+
+	// this frame's work, indexed by candidate
+	std::vector<Candidate> candidates;
+	std::vector<Result> results;
+	std::vector<DebugOverlay> overlays;
+	bool recording;
+	// candidates that actually get analysed this frame
+	std::vector<int> todo;
+	// indexed by worker
+	std::vector<Scratch*> scratch;
+
+	const MotionGate *motion;
+	int motion_scale;
+	int num_reused;
+	// added to by the workers
+	int num_misshapen;
+	// last frame's candidates, for the motion gate
+	std::vector<CvRect> prev_boxes;
+	std::vector<Result> prev_results;
+};
+
+template <class Config>
+int HandDetector<Config>::find(IplImage *mask, std::vector<Hand>& hands,
+		float perimScale, DebugOverlay *overlay) {
+	storage.clear();
+	candidates.clear();
+	was_capped = false;
+	capped_flag = 0;
+
+	double q = min_perimeter(mask, perimScale);
+	int too_small = mask->width / cfg.too_small_div;
+	int max_contours = budget ? budget->max_contours() : -1;
+
+	// collect the candidates first, the scan itself can't be split up
+	int64 scan_start = g_trace_on ? cvGetTickCount() : 0;
+	CvContourScanner scanner = cvStartFindContours(
+			mask,
+			storage,
+			sizeof(CvContour),
+			CV_RETR_EXTERNAL,
+			CV_CHAIN_APPROX_SIMPLE
+	);
+	CvSeq* c;
+	while( (c = cvFindNextContour( scanner )) != NULL ) {
+		// Get rid of contour if its perimeter is too small:
+		//
+		if( cvContourPerimeter( c ) < q ) {
+			continue;
+		}
+		Candidate cand;
+		cand.c = c;
+		cand.bb = cvBoundingRect(c);
+		// width to measure defects, etc against
+		cand.min_width_across = std::min(cand.bb.width, cand.bb.height);
+		if(cand.min_width_across < too_small) {
+			continue;
+		}
+		// out of time -- whatever is left goes unexamined this frame
+		if(budget && ((max_contours >= 0 && (int)candidates.size() >= max_contours) ||
+				budget->over())) {
+			was_capped = true;
+			break;
+		}
+		cand.color_seed = overlay ? (unsigned)rand() : 0;
+		candidates.push_back(cand);
+	}
+	cvEndFindContours(&scanner);
+	if(scan_start) {
+		trace_span("contour scan", scan_start, cvGetTickCount());
+	}
+
+	int n = (int)candidates.size();
+	results.resize(n);
+	recording = overlay != NULL;
+	if(recording) {
+		if((int)overlays.size() < n) {
+			overlays.resize(n);
+		}
+		for(int i=0; i<n; i++) {
+			overlays[i].clear();
+			overlays[i].set_scale(overlay->scale_factor());
+		}
+	}
+	int num_workers = pool ? pool->size() : 1;
+	if((int)scratch.size() < num_workers) {
+		scratch.resize(num_workers, (Scratch *)NULL);
+	}
+	for(size_t i=0; i<scratch.size(); i++) {
+		if(scratch[i]) {
+			scratch[i]->storage.clear();
+		}
+	}
+
+	// unchanged candidates take last frame's answer, the rest get analysed
+	todo.clear();
+	num_reused = 0;
+	num_misshapen = 0;
+	for(int i=0; i<n; i++) {
+		int j = previous_result(candidates[i]);
+		if(j < 0) {
+			todo.push_back(i);
+			continue;
+		}
+		results[i] = prev_results[j];
+		num_reused++;
+		if(recording) {
+			CvRect bb = candidates[i].bb;
+			overlays[i].rect(cvPoint(bb.x, bb.y), cvPoint(bb.x + bb.width, bb.y + bb.height),
+					CV_RGB(128, 128, 128), 1);
+		}
+	}
+
+	if(pool && todo.size() > 1) {
+		pool->run(analyse_task, this, (int)todo.size());
+	} else {
+		for(size_t i=0; i<todo.size(); i++) {
+			analyse(todo[i], *scratch_for(0));
+		}
+	}
+
+	// merge in scan order so hands and debug imagery don't depend on thread timing
+	int found = 0;
+	for(int i=0; i<n; i++) {
+		if(overlay) {
+			overlay->append(overlays[i]);
+		}
+		if(results[i].is_hand) {
+			hands.push_back(results[i].hand);
+			found++;
+		}
+	}
+	if(capped_flag) {
+		was_capped = true;
+	}
+	if(motion) {
+		prev_boxes.resize(n);
+		for(int i=0; i<n; i++) {
+			prev_boxes[i] = candidates[i].bb;
+		}
+		prev_results.assign(results.begin(), results.begin() + n);
+	}
+	return found;
+}
+
+template <class Config>
+void HandDetector<Config>::analyse(int idx, Scratch& s) {
+	TRACE_SCOPE_ARG("hull + defects", idx);
+	const Candidate& cand = candidates[idx];
+	Result& result = results[idx];
+	result.analysed = false;
+	result.is_hand = false;
+	CvSeq *c = cand.c;
+	CvRect bb = cand.bb;
+	DebugOverlay *overlay = recording ? &overlays[idx] : NULL;
+	CvRNG rng = cvRNG(cand.color_seed);
+	int linesz = 2;
+	CvScalar color;
+
+	if(budget && budget->over()) {
+		__sync_fetch_and_or(&capped_flag, 1);
+		return;
+	}
+	// from here on the answer is this frame's, good for reuse while nothing moves
+	result.analysed = true;
+
+	// hull and defects on the simplified contour
+	double approx_tolerance = cfg.approx_permille * cand.min_width_across / 1000.;
+	CvSeq *poly = c;
+	if(approx_tolerance > 0) {
+		poly = cvApproxPoly(c, sizeof(CvContour), s.storage, CV_POLY_APPROX_DP,
+				approx_tolerance, 0);
+		// nothing left to find defects in
+		if(poly->total < 4) {
+			poly = c;
+		}
+	}
+	if(overlay || (poly != c && cfg.refine_depth)) {
+		s.contour_pts.resize(c->total);
+		cvCvtSeqToArray(c, &s.contour_pts[0]);
+	}
+	// polygon points are read once, by whichever step needs them first
+	bool poly_read = false;
+
+	// hull as indices into the polygon
+	// -- necessary for getting convexity defects
+	s.hull_idx.resize(poly->total);
+	CvMat hullmat = cvMat(1, poly->total, CV_32SC1, &s.hull_idx[0]);
+	cvConvexHull2(poly, &hullmat, CV_CLOCKWISE, 1);
+
+	if(overlay) {
+		color = CV_RGB( cvRandInt(&rng)&255, cvRandInt(&rng)&255, cvRandInt(&rng)&255 );
+		overlay->polygon(&s.contour_pts[0], c->total, color, linesz);
+		read_poly(poly, s, poly_read);
+		s.hull_pts.resize(hullmat.cols);
+		for(int i=0; i<hullmat.cols; i++) {
+			s.hull_pts[i] = s.poly_pts[s.hull_idx[i]];
+		}
+		overlay->polygon(&s.hull_pts[0], hullmat.cols, color, linesz);
+		overlay->rect(cvPoint(bb.x, bb.y),
+				cvPoint(bb.x + bb.width, bb.y + bb.height), color, linesz);
+		overlay->circle(cvPoint(bb.x + bb.width, bb.y + bb.height), 5,
+				color, linesz);
+	}
+
+	CvSeq *defects = cvConvexityDefects(poly, &hullmat, s.storage);
+	if(defects->total < cfg.min_fingers) {
+		return;
+	}
+	// the contour can only be up to approx_tolerance deeper than the polygon
+	bool refine = poly != c && cfg.refine_depth;
+	bool mapped = false;
+
+	float depth_threshold = cfg.depth_pct * cand.min_width_across / 100.f;
+	int max_fingers = cfg.max_fingers < HAND_MAX_DEFECTS ?
+			cfg.max_fingers : HAND_MAX_DEFECTS;
+	CvConvexityDefect *deep_enough[HAND_MAX_DEFECTS];
+	int num_deep = 0;
+	for(int i=0; i<defects->total; i++) {
+		CvConvexityDefect *d = (CvConvexityDefect *)cvGetSeqElem(defects, i);
+		if(refine && d->depth + approx_tolerance > depth_threshold) {
+			if(!mapped) {
+				read_poly(poly, s, poly_read);
+				mapped = true;
+				refine = map_poly_to_contour(s);
+			}
+			if(refine) {
+				refine_defect(d, poly, s);
+			}
+		}
+		// defects big enough to be fingers
+		if(d->depth <= depth_threshold) {
+			continue;
+		}
+		if(overlay) {
+			int radius = 5;
+			if(i==0) {
+				color = CV_RGB(0, 255, 0);
+				radius = 10;
+			} else {
+				color = CV_RGB( cvRandInt(&rng)&255, cvRandInt(&rng)&255,
+						cvRandInt(&rng)&255 );
+			}
+			overlay->circle(*(d->depth_point), radius, color, CV_FILLED);
+			overlay->line(*(d->start), *(d->depth_point), color, 1);
+			overlay->line(*(d->end), *(d->depth_point), color, 1);
+		}
+		// too many to be a hand, no need to keep looking
+		if(++num_deep > max_fingers) {
+			break;
+		}
+		deep_enough[num_deep-1] = d;
+	}
+
+	if(num_deep < cfg.min_fingers || num_deep > max_fingers) {
+		return;
+	}
+	// right number of gaps, is it shaped like a hand?
+	if(cfg.shape_tolerance_pct > 0) {
+		read_poly(poly, s, poly_read);
+		ShapeSignature sig;
+		if(!shape_signature(&s.poly_pts[0], poly->total, &sig) ||
+				open_hand_distance(sig) * 100 > cfg.shape_tolerance_pct) {
+			__sync_fetch_and_add(&num_misshapen, 1);
+			if(overlay) {
+				// crossed out
+				overlay->line(cvPoint(bb.x, bb.y), cvPoint(bb.x + bb.width, bb.y + bb.height),
+						CV_RGB(255, 0, 0), linesz);
+				overlay->line(cvPoint(bb.x + bb.width, bb.y), cvPoint(bb.x, bb.y + bb.height),
+						CV_RGB(255, 0, 0), linesz);
+			}
+			return;
+		}
+	}
+
+	// hopefully we have a hand
+	Hand& hand = result.hand;
+	hand.bbox = bb;
+	hand.center = cvPoint(bb.x + bb.width/2, bb.y + bb.height/2);
+	hand.num_defects = num_deep;
+	for(int i=0; i<num_deep; i++) {
+		hand.depth_points[i] = *(deep_enough[i]->depth_point);
+		hand.depths[i] = deep_enough[i]->depth;
+	}
+	find_tips(hand, deep_enough, num_deep);
+	result.is_hand = true;
+}
+
+template <class Config>
+bool HandDetector<Config>::map_poly_to_contour(Scratch& s) {
+	// the vertices are contour points in the same order, maybe starting further along
+	int nc = (int)s.contour_pts.size(), np = (int)s.poly_pts.size();
+	s.poly_idx.resize(np);
+	int j = 0, steps = 0;
+	for(int k=0; k<np; k++) {
+		CvPoint p = s.poly_pts[k];
+		while(s.contour_pts[j].x != p.x || s.contour_pts[j].y != p.y) {
+			j = j + 1 < nc ? j + 1 : 0;
+			// once round to find the first vertex, once more for the rest
+			if(++steps > 2 * nc) {
+				return false;
+			}
+		}
+		s.poly_idx[k] = j;
+	}
+	return true;
+}
+
+template <class Config>
+void HandDetector<Config>::refine_defect(CvConvexityDefect *d, CvSeq *poly, Scratch& s) {
+	int np = poly->total, nc = (int)s.contour_pts.size();
+	int si = cvSeqElemIdx(poly, d->start);
+	int ei = cvSeqElemIdx(poly, d->end);
+	int di = cvSeqElemIdx(poly, d->depth_point);
+	// the defect is the stretch from start to end that has its depth point on it
+	int from = s.poly_idx[si], to = s.poly_idx[ei];
+	if((di - si + np) % np > (ei - si + np) % np) {
+		std::swap(from, to);
+	}
+	double dx = d->end->x - d->start->x, dy = d->end->y - d->start->y;
+	double len = std::sqrt(dx * dx + dy * dy);
+	if(len == 0) {
+		return;
+	}
+	// same measure as cvConvexityDefects, distance from the start-end line
+	int best = s.poly_idx[di];
+	double best_depth = d->depth;
+	for(int k=from; k!=to; k = k + 1 < nc ? k + 1 : 0) {
+		const CvPoint& p = s.contour_pts[k];
+		double depth = std::fabs(dy * (p.x - d->start->x) - dx * (p.y - d->start->y)) / len;
+		if(depth > best_depth) {
+			best_depth = depth;
+			best = k;
+		}
+	}
+	d->depth_point = &s.contour_pts[best];
+	d->depth = (float)best_depth;
+}
+
+template <class Config>
+void HandDetector<Config>::find_tips(Hand& hand, CvConvexityDefect **defects, int n) {
+	// consider that the start and end point of the convexity defect are hopefully the
+	// finger tips which we want to count only one time
+
+	// closer than this and it's the same finger tip
+	float proximity_threshold = defects[0]->depth * cfg.proximity_pct / 100.f;
+	float prox_sq = proximity_threshold * proximity_threshold;
+
+	int num_tips = 0;
+	for(int i=0; i<n; i++) {
+		hand.tips[num_tips++] = *(defects[i]->start);
+	}
+	for(int i=0; i<n; i++) {
+		CvPoint ftip = *(defects[i]->end);
+		bool found_close_pt = false;
+		for(int j=0; j<num_tips; j++) {
+			int dx = ftip.x - hand.tips[j].x;
+			int dy = ftip.y - hand.tips[j].y;
+			if(dx*dx + dy*dy < prox_sq) {
+				found_close_pt = true;
+				break;
+			}
+		}
+		if(!found_close_pt) {
+			hand.tips[num_tips++] = ftip;
+		}
+	}
+	hand.num_tips = num_tips;
+}
+
+#endif /* HAND_DETECTOR_H_ */
@@ -0,0 +1,96 @@
+/*
+ * hand_events.h
+ *
+ * The shared memory layout hands are published in, so other processes (game logic,
+ * analytics) get them without scraping the video.  Fixed size, fixed width fields, no
+ * pointers and no OpenCV, so a reader needs only this file and hand_events_reader.h.
+ *
+ * 	HandEventsHeader            one, at offset 0
+ * 	slot 0 .. slots-1           each slot_bytes, 64 byte aligned
+ * 		HandEventFrame          one frame's hands
+ * 		mask                    [mask_bytes] the frame's raw backprojection, row
+ * 		                        by row mask_width wide, if the publisher sends it
+ *
+ * One publisher, any number of readers, and nobody waits on anybody.  Frame n goes
+ * in slot n % slots.  The publisher sets the slot's seq to 2n+1 while it writes and
+ * to 2n+2 when it's done, then bumps head to n+1.  A reader after frame n checks the
+ * slot's seq is 2n+2 before and after copying -- anything else and the frame was
+ * overwritten under it (the reader fell more than slots frames behind) and it moves on.
+ * The publisher never knows how many readers there are.
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef HAND_EVENTS_H_
+#define HAND_EVENTS_H_
+
+#include <stdint.h>
+#include <time.h>
+
+#define HAND_EVENTS_MAGIC 0x444e4148u	// "HAND"
+#define HAND_EVENTS_VERSION 1
+#define HAND_EVENTS_ALIGN 64
+
+#define HE_MAX_HANDS 8
+#define HE_MAX_TIPS 16
+#define HE_MAX_DEFECTS 8
+
+struct HandEventHand {
+	// x, y, width, height
+	int32_t bbox[4];
+	int32_t center[2];
+	int32_t num_tips;
+	int32_t num_defects;
+	int32_t tips[HE_MAX_TIPS][2];
+	int32_t depth_points[HE_MAX_DEFECTS][2];
+	float depths[HE_MAX_DEFECTS];
+};
+
+struct HandEventFrame {
+	// 2n+1 while frame n is being written, 2n+2 once it's whole
+	volatile uint64_t seq;
+	// frame number since the publisher started
+	uint64_t frame;
+	// CLOCK_MONOTONIC ns, when the frame was captured and when it was published
+	uint64_t capture_ns;
+	uint64_t publish_ns;
+	int32_t num_hands;
+	// nonzero if the mask after this struct is filled in
+	int32_t has_mask;
+	struct HandEventHand hands[HE_MAX_HANDS];
+};
+
+struct HandEventsHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t slots;
+	uint32_t slot_bytes;
+	uint32_t mask_width;
+	uint32_t mask_height;
+	// 0 if the publisher sends no masks
+	uint32_t mask_bytes;
+	uint32_t publisher_pid;
+	// frames published, the newest is head - 1
+	volatile uint64_t head;
+};
+
+// offset of slot i from the start of the mapping
+static inline uint64_t he_slot_offset(const struct HandEventsHeader *h, uint64_t i) {
+	uint64_t first = (sizeof(struct HandEventsHeader) + HAND_EVENTS_ALIGN - 1) /
+			HAND_EVENTS_ALIGN * HAND_EVENTS_ALIGN;
+	return first + i * h->slot_bytes;
+}
+
+// bytes for the whole mapping
+static inline uint64_t he_total_bytes(const struct HandEventsHeader *h) {
+	return he_slot_offset(h, h->slots);
+}
+
+// the clock the timestamps are in
+static inline uint64_t he_now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+#endif /* HAND_EVENTS_H_ */
@@ -0,0 +1,126 @@
+/*
+ * hand_events_reader.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "hand_events_reader.h"
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static HandEventFrame* slot_of(const HandEventsReader *r, uint64_t n) {
+	const HandEventsHeader *h = r->header;
+	return (HandEventFrame *)((char *)r->map + he_slot_offset(h, n % h->slots));
+}
+
+bool he_open(HandEventsReader *r, const char *name) {
+	memset(r, 0, sizeof(*r));
+	r->fd = shm_open(name, O_RDONLY, 0);
+	if(r->fd < 0) {
+		return false;
+	}
+	struct stat st;
+	HandEventsHeader h;
+	if(fstat(r->fd, &st) != 0 || (size_t)st.st_size < sizeof(h) ||
+			pread(r->fd, &h, sizeof(h), 0) != (ssize_t)sizeof(h) ||
+			h.magic != HAND_EVENTS_MAGIC || h.version != HAND_EVENTS_VERSION ||
+			(uint64_t)st.st_size < he_total_bytes(&h)) {
+		close(r->fd);
+		return false;
+	}
+	r->bytes = he_total_bytes(&h);
+	r->map = mmap(NULL, r->bytes, PROT_READ, MAP_SHARED, r->fd, 0);
+	if(r->map == MAP_FAILED) {
+		close(r->fd);
+		r->map = NULL;
+		return false;
+	}
+	r->header = (const HandEventsHeader *)r->map;
+	r->next = r->header->head;
+	return true;
+}
+
+void he_close(HandEventsReader *r) {
+	if(r->map) {
+		munmap(r->map, r->bytes);
+		close(r->fd);
+	}
+	r->map = NULL;
+	r->header = NULL;
+}
+
+uint64_t he_published(const HandEventsReader *r) {
+	return r->header->head;
+}
+
+const HandEventFrame* he_peek(const HandEventsReader *r, uint64_t n) {
+	const HandEventFrame *f = slot_of(r, n);
+	uint64_t seq = f->seq;
+	__sync_synchronize();
+	return seq == 2 * n + 2 ? f : NULL;
+}
+
+const unsigned char* he_peek_mask(const HandEventsReader *r, uint64_t n) {
+	const HandEventFrame *f = he_peek(r, n);
+	if(!f || !f->has_mask || !r->header->mask_bytes) {
+		return NULL;
+	}
+	return (const unsigned char *)f + (r->header->slot_bytes - r->header->mask_bytes);
+}
+
+bool he_still_valid(const HandEventsReader *r, uint64_t n) {
+	__sync_synchronize();
+	return slot_of(r, n)->seq == 2 * n + 2;
+}
+
+// frame n into frame and mask, false if it was overwritten before or while copying
+static bool copy_frame(const HandEventsReader *r, uint64_t n, HandEventFrame *frame,
+		unsigned char *mask) {
+	const HandEventFrame *f = he_peek(r, n);
+	if(!f) {
+		return false;
+	}
+	memcpy(frame, (const void *)f, sizeof(*frame));
+	// straight from the slot, it may be overwritten by now and he_peek_mask would say so
+	if(mask && frame->has_mask && r->header->mask_bytes) {
+		memcpy(mask, (const char *)f + (r->header->slot_bytes - r->header->mask_bytes),
+				r->header->mask_bytes);
+	}
+	return he_still_valid(r, n);
+}
+
+int he_next(HandEventsReader *r, HandEventFrame *frame, unsigned char *mask) {
+	while(1) {
+		uint64_t head = r->header->head;
+		__sync_synchronize();
+		if(r->next >= head) {
+			return 0;
+		}
+		// fell behind the ring -- skip to the oldest frame still there
+		uint64_t oldest = head > r->header->slots ? head - r->header->slots : 0;
+		if(r->next < oldest) {
+			r->lost += oldest - r->next;
+			r->next = oldest;
+		}
+		uint64_t n = r->next++;
+		if(copy_frame(r, n, frame, mask)) {
+			return 1;
+		}
+		// overwritten while copying, so the publisher has moved on -- try again
+		r->lost++;
+	}
+}
+
+int he_latest(HandEventsReader *r, HandEventFrame *frame, unsigned char *mask) {
+	uint64_t head = r->header->head;
+	__sync_synchronize();
+	if(head > r->next + 1) {
+		r->lost += head - 1 - r->next;
+		r->next = head - 1;
+	}
+	return he_next(r, frame, mask);
+}
@@ -0,0 +1,65 @@
+/*
+ * hand_events_reader.h
+ *
+ * Reading the hands fingershooter --publish puts in shared memory, for other
+ * processes.  Needs only hand_events.h and hand_events_reader.cpp, no OpenCV:
+ *
+ * 	HandEventsReader r;
+ * 	if(he_open(&r, "/fingershooter")) {
+ * 		HandEventFrame f;
+ * 		while(running) {
+ * 			if(he_next(&r, &f, NULL) > 0) {
+ * 				... f.hands[0 .. f.num_hands-1]
+ * 			}
+ * 		}
+ * 		he_close(&r);
+ * 	}
+ *
+ * Reading never blocks the publisher or other readers.  A reader that falls more than
+ * the ring's length behind skips to the oldest frame still there and counts what it
+ * missed.
+ * Implementation in hand_events_reader.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef HAND_EVENTS_READER_H_
+#define HAND_EVENTS_READER_H_
+
+#include <stddef.h>
+#include "hand_events.h"
+
+struct HandEventsReader {
+	int fd;
+	void *map;
+	size_t bytes;
+	const struct HandEventsHeader *header;
+	// next frame he_next returns
+	uint64_t next;
+	// frames overwritten before they were read
+	uint64_t lost;
+};
+
+// maps the channel name (as given to --publish) read only, false if there's none
+// starts after the frames already published
+bool he_open(HandEventsReader *r, const char *name);
+void he_close(HandEventsReader *r);
+
+// frames published so far
+uint64_t he_published(const HandEventsReader *r);
+
+// the next frame not yet read into frame, and its mask into mask if not NULL and the
+// frame has one (header->mask_bytes)
+// returns 1 if a frame was read, 0 if there's nothing new
+int he_next(HandEventsReader *r, HandEventFrame *frame, unsigned char *mask);
+
+// the newest frame, skipping any in between (they count as lost), as he_next
+int he_latest(HandEventsReader *r, HandEventFrame *frame, unsigned char *mask);
+
+// zero copy: frame n in place, NULL if it isn't there any more -- whatever is read
+// from it only counts if he_still_valid(r, n) afterwards
+const HandEventFrame* he_peek(const HandEventsReader *r, uint64_t n);
+const unsigned char* he_peek_mask(const HandEventsReader *r, uint64_t n);
+bool he_still_valid(const HandEventsReader *r, uint64_t n);
+
+#endif /* HAND_EVENTS_READER_H_ */
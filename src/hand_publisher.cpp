@@ -0,0 +1,172 @@
+/*
+ * hand_publisher.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "hand_publisher.h"
+#include "trace.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+//******* unix/linux only for shared memory
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+using namespace std;
+
+bool parse_publisher_settings(const char *spec, PublisherSettings *s) {
+	const char *colon = strchr(spec, ':');
+	s->name = colon ? string(spec, colon - spec) : string(spec);
+	if(s->name.size() < 2 || s->name[0] != '/' || s->name.find('/', 1) != string::npos) {
+		return false;
+	}
+	while(colon) {
+		const char *part = colon + 1;
+		colon = strchr(part, ':');
+		size_t len = colon ? (size_t)(colon - part) : strlen(part);
+		if(len == 4 && strncmp(part, "mask", 4) == 0) {
+			s->masks = true;
+		} else if(len > 6 && strncmp(part, "slots=", 6) == 0) {
+			s->slots = atoi(part + 6);
+			if(s->slots < 2) {
+				return false;
+			}
+		} else {
+			return false;
+		}
+	}
+	return true;
+}
+
+HandPublisher::HandPublisher()
+: map(NULL), bytes(0), header(NULL), hands_left_out(0), publish_ms(0)
+{}
+
+HandPublisher::~HandPublisher() {
+	if(map) {
+		munmap(map, bytes);
+		shm_unlink(name.c_str());
+	}
+}
+
+bool HandPublisher::open(const PublisherSettings& settings, CvSize mask_size) {
+	name = settings.name;
+	HandEventsHeader h;
+	memset(&h, 0, sizeof(h));
+	h.magic = HAND_EVENTS_MAGIC;
+	h.version = HAND_EVENTS_VERSION;
+	h.slots = settings.slots;
+	if(settings.masks) {
+		h.mask_width = mask_size.width;
+		h.mask_height = mask_size.height;
+		h.mask_bytes = mask_size.width * mask_size.height;
+	}
+	// the mask starts on its own cache line, and each slot on the next
+	size_t frame_bytes = (sizeof(HandEventFrame) + HAND_EVENTS_ALIGN - 1) /
+			HAND_EVENTS_ALIGN * HAND_EVENTS_ALIGN;
+	h.slot_bytes = (frame_bytes + h.mask_bytes + HAND_EVENTS_ALIGN - 1) /
+			HAND_EVENTS_ALIGN * HAND_EVENTS_ALIGN;
+	// the mask sits at the end of the slot, where readers look for it
+	h.mask_bytes = h.mask_bytes ? h.slot_bytes - frame_bytes : 0;
+	h.publisher_pid = getpid();
+	bytes = he_total_bytes(&h);
+
+	// a reader still mapping an old segment keeps it, we start a fresh one
+	shm_unlink(name.c_str());
+	int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+	if(fd < 0) {
+		fprintf(stderr, "publish: can't create shared memory %s\n", name.c_str());
+		return false;
+	}
+	void *m = ftruncate(fd, bytes) == 0 ?
+			mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+	close(fd);
+	if(m == MAP_FAILED) {
+		fprintf(stderr, "publish: can't map shared memory %s\n", name.c_str());
+		shm_unlink(name.c_str());
+		return false;
+	}
+	map = m;
+	header = (HandEventsHeader *)m;
+	// slots start zeroed, ie seq 0, which no frame has
+	memcpy(header, &h, sizeof(h));
+	__sync_synchronize();
+	printf("publish: hands in shared memory %s, %d slots of %u bytes%s\n", name.c_str(),
+			settings.slots, h.slot_bytes, settings.masks ? ", with masks" : "");
+	return true;
+}
+
+HandEventFrame* HandPublisher::slot(uint64_t n) {
+	return (HandEventFrame *)((char *)map + he_slot_offset(header, n % header->slots));
+}
+
+void HandPublisher::publish(const vector<Hand>& hands, uint64_t capture_ns,
+		const IplImage *mask) {
+	if(!map) {
+		return;
+	}
+	int64 start = cvGetTickCount();
+	uint64_t n = header->head;
+	HandEventFrame *f = slot(n);
+	// readers seeing this drop whatever they were copying from the slot
+	f->seq = 2 * n + 1;
+	__sync_synchronize();
+
+	f->frame = n;
+	f->capture_ns = capture_ns;
+	int num = min((int)hands.size(), HE_MAX_HANDS);
+	hands_left_out += (long)hands.size() - num;
+	f->num_hands = num;
+	for(int i=0; i<num; i++) {
+		const Hand& hand = hands[i];
+		HandEventHand& e = f->hands[i];
+		e.bbox[0] = hand.bbox.x;
+		e.bbox[1] = hand.bbox.y;
+		e.bbox[2] = hand.bbox.width;
+		e.bbox[3] = hand.bbox.height;
+		e.center[0] = hand.center.x;
+		e.center[1] = hand.center.y;
+		e.num_tips = min(hand.num_tips, HE_MAX_TIPS);
+		for(int t=0; t<e.num_tips; t++) {
+			e.tips[t][0] = hand.tips[t].x;
+			e.tips[t][1] = hand.tips[t].y;
+		}
+		e.num_defects = min(hand.num_defects, HE_MAX_DEFECTS);
+		for(int d=0; d<e.num_defects; d++) {
+			e.depth_points[d][0] = hand.depth_points[d].x;
+			e.depth_points[d][1] = hand.depth_points[d].y;
+			e.depths[d] = hand.depths[d];
+		}
+	}
+	f->has_mask = 0;
+	if(mask && header->mask_bytes && mask->width == (int)header->mask_width &&
+			mask->height == (int)header->mask_height) {
+		uchar *dst = (uchar *)f + (header->slot_bytes - header->mask_bytes);
+		for(int y=0; y<mask->height; y++) {
+			memcpy(dst + y * mask->width, mask->imageData + y * mask->widthStep, mask->width);
+		}
+		f->has_mask = 1;
+	}
+	f->publish_ns = he_now_ns();
+
+	__sync_synchronize();
+	f->seq = 2 * n + 2;
+	__sync_synchronize();
+	header->head = n + 1;
+	publish_ms += ticks_to_ms(cvGetTickCount() - start);
+}
+
+void HandPublisher::print_stats() const {
+	if(!map) {
+		return;
+	}
+	uint64_t n = header->head;
+	printf("HandPublisher: %llu frames to %s, %.3f ms each, %ld hands past %d per frame "
+			"left out\n", (unsigned long long)n, name.c_str(), n ? publish_ms / n : 0.,
+			hands_left_out, HE_MAX_HANDS);
+}
@@ -0,0 +1,72 @@
+/*
+ * hand_publisher.h
+ *
+ * Publishes each frame's hands -- bbox, center, fingertips, defect depth points and
+ * depths, capture and publish times -- into a POSIX shared memory ring for other
+ * processes, layout in hand_events.h, reading in hand_events_reader.h.  Optionally the
+ * frame's raw backprojection goes along in the same slot.
+ *
+ * 	fingershooter --publish /fingershooter[:mask][:slots=N]
+ *
+ * Publishing is a copy into the next slot and two stores, it never waits for readers.
+ * The segment is removed when the publisher goes away.
+ * Implementation in hand_publisher.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef HAND_PUBLISHER_H_
+#define HAND_PUBLISHER_H_
+
+#include "cv.h"
+#include <vector>
+#include <string>
+
+#include "hand_detector.h"
+#include "hand_events.h"
+
+struct PublisherSettings {
+	PublisherSettings() : name("/fingershooter"), masks(false), slots(64) {}
+
+	// shm_open name, starting with /
+	std::string name;
+	// send the backprojection with each frame
+	bool masks;
+	// frames in the ring
+	int slots;
+};
+
+// "name[:mask][:slots=N]", false if it doesn't parse
+bool parse_publisher_settings(const char *spec, PublisherSettings *s);
+
+class HandPublisher {
+public:
+	HandPublisher();
+	// unmaps and removes the segment
+	~HandPublisher();
+
+	// creates the segment, mask_size -- the backprojection's size if masks are sent
+	// false (and a message) if it can't be made
+	bool open(const PublisherSettings& settings, CvSize mask_size);
+
+	// hands -- the frame's, more than HE_MAX_HANDS are left out
+	// capture_ns -- he_now_ns() when the frame was captured
+	// mask -- [NULL] 8 bit 1 channel mask_size, sent if masks are on
+	void publish(const std::vector<Hand>& hands, uint64_t capture_ns,
+			const IplImage *mask = NULL);
+
+	uint64_t published() const { return header ? header->head : 0; }
+	void print_stats() const;
+
+private:
+	HandEventFrame* slot(uint64_t n);
+
+	std::string name;
+	void *map;
+	size_t bytes;
+	HandEventsHeader *header;
+	long hands_left_out;
+	double publish_ms;
+};
+
+#endif /* HAND_PUBLISHER_H_ */
@@ -0,0 +1,168 @@
+/*
+ * hand_shape.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "hand_shape.h"
+
+#include <cmath>
+#include <algorithm>
+
+using namespace std;
+
+PolygonMoments::PolygonMoments()
+: first(cvPoint(0, 0)), prev(cvPoint(0, 0)), n(0)
+{
+	for(int i=0; i<10; i++) {
+		sums[i] = 0;
+	}
+}
+
+// Green's theorem terms for the edge (x0, y0) -> (x1, y1), as cvMoments does for contours
+static void add_edge(double s[10], double x0, double y0, double x1, double y1) {
+	double dxy = x0 * y1 - x1 * y0;
+	double xx = x0 * x0, x1x1 = x1 * x1, yy = y0 * y0, y1y1 = y1 * y1;
+	s[0] += dxy;
+	s[1] += dxy * (x0 + x1);
+	s[2] += dxy * (y0 + y1);
+	s[3] += dxy * (xx + x0 * x1 + x1x1);
+	s[4] += dxy * (x0 * (2 * y0 + y1) + x1 * (y0 + 2 * y1));
+	s[5] += dxy * (yy + y0 * y1 + y1y1);
+	s[6] += dxy * (x0 + x1) * (xx + x1x1);
+	s[7] += dxy * (xx * (3 * y0 + y1) + 2 * x0 * x1 * (y0 + y1) + x1x1 * (y0 + 3 * y1));
+	s[8] += dxy * (yy * (3 * x0 + x1) + 2 * y0 * y1 * (x0 + x1) + y1y1 * (x0 + 3 * x1));
+	s[9] += dxy * (y0 + y1) * (yy + y1y1);
+}
+
+void PolygonMoments::add(CvPoint p) {
+	if(n == 0) {
+		first = p;
+	} else {
+		add_edge(sums, prev.x - first.x, prev.y - first.y, p.x - first.x, p.y - first.y);
+	}
+	prev = p;
+	n++;
+}
+
+void PolygonMoments::add(const CvPoint *pts, int count) {
+	for(int i=0; i<count; i++) {
+		add(pts[i]);
+	}
+}
+
+void PolygonMoments::moments(double m[10]) const {
+	double s[10];
+	for(int i=0; i<10; i++) {
+		s[i] = sums[i];
+	}
+	// closing edge back to the first vertex, which is the origin
+	if(n > 1) {
+		add_edge(s, prev.x - first.x, prev.y - first.y, 0, 0);
+	}
+	static const double scale[10] = { 2, 6, 6, 12, 24, 12, 20, 60, 60, 20 };
+	// clockwise polygons come out negative
+	double sign = s[0] < 0 ? -1 : 1;
+	for(int i=0; i<10; i++) {
+		m[i] = sign * s[i] / scale[i];
+	}
+}
+
+double PolygonMoments::area() const {
+	double m[10];
+	moments(m);
+	return m[0];
+}
+
+bool PolygonMoments::hu(double out[7]) const {
+	double m[10];
+	moments(m);
+	double m00 = m[0], m10 = m[1], m01 = m[2], m20 = m[3], m11 = m[4], m02 = m[5];
+	double m30 = m[6], m21 = m[7], m12 = m[8], m03 = m[9];
+	if(m00 <= 0) {
+		return false;
+	}
+	// central moments
+	double cx = m10 / m00, cy = m01 / m00;
+	double mu20 = m20 - cx * m10;
+	double mu11 = m11 - cx * m01;
+	double mu02 = m02 - cy * m01;
+	double mu30 = m30 - cx * (3 * mu20 + cx * m10);
+	double mu21 = m21 - cx * (2 * mu11 + cx * m01) - cy * mu20;
+	double mu12 = m12 - cy * (2 * mu11 + cy * m10) - cx * mu02;
+	double mu03 = m03 - cy * (3 * mu02 + cy * m01);
+
+	// normalized, for scale
+	double inv2 = 1. / (m00 * m00), inv3 = inv2 / sqrt(m00);
+	double n20 = mu20 * inv2, n11 = mu11 * inv2, n02 = mu02 * inv2;
+	double n30 = mu30 * inv3, n21 = mu21 * inv3, n12 = mu12 * inv3, n03 = mu03 * inv3;
+
+	double t0 = n30 + n12, t1 = n21 + n03;
+	double q0 = t0 * t0, q1 = t1 * t1;
+	double d = n20 - n02;
+	double a = n30 - 3 * n12, b = 3 * n21 - n03;
+	out[0] = n20 + n02;
+	out[1] = d * d + 4 * n11 * n11;
+	out[2] = a * a + b * b;
+	out[3] = q0 + q1;
+	out[4] = a * t0 * (q0 - 3 * q1) + b * t1 * (3 * q0 - q1);
+	out[5] = d * (q0 - q1) + 4 * n11 * t0 * t1;
+	out[6] = b * t0 * (q0 - 3 * q1) - a * t1 * (3 * q0 - q1);
+	return true;
+}
+
+bool shape_signature(const CvPoint *pts, int n, ShapeSignature *sig) {
+	PolygonMoments pm;
+	pm.add(pts, n);
+	double h[7];
+	if(n < 3 || !pm.hu(h)) {
+		return false;
+	}
+	for(int i=0; i<4; i++) {
+		// exactly 0 only for perfectly symmetric shapes, which aren't hands anyway
+		double mag = max(fabs(h[i]), 1e-30);
+		sig->hu[i] = (h[i] < 0 ? -1 : 1) * log10(mag);
+	}
+	return true;
+}
+
+double shape_distance(const ShapeSignature& a, const ShapeSignature& ref) {
+	double worst = 0;
+	for(int i=0; i<4; i++) {
+		worst = max(worst, fabs(a.hu[i] - ref.hu[i]) / max(fabs(ref.hu[i]), 1e-6));
+	}
+	return worst;
+}
+
+// the reference hands -- draw_synth_hand's open hands (synth_scene.h), 4 and 5 fingers
+// at scale 200 with 0 to .8 of the scale in forearm showing below the palm, found with
+// cvFindContours and simplified as the detector does (approx_permille 10), measured
+// once and kept here so the detector doesn't need the scene generator
+// bench_hand_shape renders them again and reports how far they've drifted
+static const ShapeSignature reference_hands[] = {
+	{ { -0.5613, -2.2445, -2.4486, -2.8329 } },	// 4 fingers, forearm 0
+	{ { -0.5556, -1.8550, -2.4878, -2.9774 } },	// 4 fingers, forearm .2
+	{ { -0.5144, -1.4567, -2.4842, -3.3727 } },	// 4 fingers, forearm .4
+	{ { -0.4602, -1.1918, -2.4306, -4.0173 } },	// 4 fingers, forearm .6
+	{ { -0.4044, -0.9935, -2.3727, -4.1117 } },	// 4 fingers, forearm .8
+	{ { -0.5549, -4.0935, -2.4747, -2.9824 } },	// 5 fingers, forearm 0
+	{ { -0.5553, -2.5318, -2.2880, -3.1449 } },	// 5 fingers, forearm .2
+	{ { -0.5246, -1.7577, -2.1336, -3.7704 } },	// 5 fingers, forearm .4
+	{ { -0.4733, -1.3693, -2.0325, -5.2946 } },	// 5 fingers, forearm .6
+	{ { -0.4176, -1.1120, -1.9648, -3.5687 } },	// 5 fingers, forearm .8
+};
+
+const vector<ShapeSignature>& open_hand_references() {
+	static const vector<ShapeSignature> refs(reference_hands, reference_hands +
+			sizeof(reference_hands) / sizeof(reference_hands[0]));
+	return refs;
+}
+
+double open_hand_distance(const ShapeSignature& sig) {
+	const vector<ShapeSignature>& refs = open_hand_references();
+	double best = 1e9;
+	for(size_t i=0; i<refs.size(); i++) {
+		best = min(best, shape_distance(sig, refs[i]));
+	}
+	return best;
+}
@@ -0,0 +1,77 @@
+/*
+ * hand_shape.h
+ *
+ * Shape check for contours that have the right number of deep defects to be a hand.
+ * The defect count alone lets through spiky skin coloured blobs; this compares the
+ * contour's Hu moments with those of a few reference open hands (4 and 5 fingers,
+ * with more or less forearm showing).  Hu moments don't change with position, scale
+ * or rotation, so a handful of references covers any hand pose in the plane.  The
+ * references are synthetic hands (synth_scene.h) measured once and kept as numbers,
+ * and so far only checked against synthetic scenes, so the detector leaves the check
+ * off by default (HandDetector's shape_tolerance_pct).
+ *
+ * The moments come straight from the polygon's vertices by Green's theorem, one edge
+ * at a time -- no mask is rasterized, so the cost is the vertex count, which for the
+ * detector's simplified contours is a few dozen.
+ * Implementation in hand_shape.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef HAND_SHAPE_H_
+#define HAND_SHAPE_H_
+
+#include "cv.h"
+#include <vector>
+
+// spatial moments of a closed polygon up to order 3, added to edge by edge
+class PolygonMoments {
+public:
+	PolygonMoments();
+
+	// edge from the previous vertex to p, the polygon closes from the last vertex back
+	// to the first when hu() is called
+	void add(CvPoint p);
+	// all of pts, a closed polygon
+	void add(const CvPoint *pts, int n);
+
+	// area, 0 for a degenerate polygon
+	double area() const;
+	// the seven Hu invariants, false if the polygon has no area
+	bool hu(double out[7]) const;
+
+private:
+	// sums over the edges before the constant factors, in the order
+	// 00 10 01 20 11 02 30 21 12 03
+	double sums[10];
+	// coordinates are taken relative to the first vertex, for precision
+	CvPoint first, prev;
+	int n;
+
+	// the closed polygon's moments, same order as sums
+	void moments(double m[10]) const;
+};
+
+// log scaled Hu moments, the ones compared
+struct ShapeSignature {
+	// sign(h) * log10(|h|), h1 to h4 -- the higher ones are too noisy to use
+	double hu[4];
+};
+
+// false if the polygon is degenerate
+bool shape_signature(const CvPoint *pts, int n, ShapeSignature *sig);
+
+// largest relative difference of a's invariants from ref's
+double shape_distance(const ShapeSignature& a, const ShapeSignature& ref);
+
+// the reference hands' signatures, see hand_shape.cpp
+const std::vector<ShapeSignature>& open_hand_references();
+
+// distance (as a percentage) that kept the synthetic hands and dropped the synthetic
+// decoys in bench_hand_shape, for callers turning the check on
+const int OPEN_HAND_TOLERANCE_PCT = 25;
+
+// distance from sig to the nearest reference hand
+double open_hand_distance(const ShapeSignature& sig);
+
+#endif /* HAND_SHAPE_H_ */
@@ -0,0 +1,53 @@
+/*
+ * hue_kernel.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "hue_kernel.h"
+#include "pixel_kernels.h"
+
+int hue_hdiv_table[256];
+
+static struct HdivTableInit {
+	HdivTableInit() {
+		hue_hdiv_table[0] = 0;
+		for(int i=1; i<256; i++) {
+			hue_hdiv_table[i] = cvRound((180 << HSV_SHIFT) / (6. * i));
+		}
+	}
+} hdiv_table_init;
+
+// numerator of the hue for one pixel, scaled so hue = h * 30 / diff
+static inline int hue_numerator(int b, int g, int r, int v, int diff) {
+	if(v == r) {
+		return g - b;
+	} else if(v == g) {
+		return b - r + 2 * diff;
+	}
+	return r - g + 4 * diff;
+}
+
+void bgr_to_hue_row_scalar(const uchar *bgr, uchar *hue, int n) {
+	for(int x=0; x < n; x++, bgr += 3) {
+		int b = bgr[0], g = bgr[1], r = bgr[2];
+		int v = b > g ? b : g;
+		v = v > r ? v : r;
+		int vmin = b < g ? b : g;
+		vmin = vmin < r ? vmin : r;
+		int diff = v - vmin;
+		hue[x] = hue_from(hue_numerator(b, g, r, v, diff), diff);
+	}
+}
+
+void bgr_to_hue_row(const uchar *bgr, uchar *hue, int n) {
+	pixel_kernels().hue_row(bgr, hue, n);
+}
+
+void bgr_to_hue(const IplImage *bgr, IplImage *hue) {
+	const PixelKernels& k = pixel_kernels();
+	for(int y=0; y<bgr->height; y++) {
+		k.hue_row((const uchar *)(bgr->imageData + y * bgr->widthStep),
+				(uchar *)(hue->imageData + y * hue->widthStep), bgr->width);
+	}
+}
@@ -0,0 +1,40 @@
+/*
+ * hue_kernel.h
+ *
+ * Hue only BGR to HSV, for the paths that throw S and V away.  Integer only: max,
+ * min and the branch free select of the hue numerator are done 16 or more pixels at a
+ * time by the SIMD variants (pixel_kernels.h, picked at startup), and the division by
+ * max - min is a multiply by a 12 bit fixed point reciprocal from a table -- the same
+ * table and rounding OpenCV's 8 bit BGR2HSV uses, so the output is byte for byte its
+ * H channel (0-180), checked over all 2^24 colours by test_hue_kernel() in
+ * benchmarks.cpp.
+ * Implementation in hue_kernel.cpp (scalar), pixel_kernels_<isa>.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef HUE_KERNEL_H_
+#define HUE_KERNEL_H_
+
+#include "cv.h"
+
+// hue of n interleaved bgr pixels, with the kernel for simd_level()
+void bgr_to_hue_row(const uchar *bgr, uchar *hue, int n);
+
+// bgr -- 8 bit 3 channel, hue -- 8 bit 1 channel, same size
+// replaces cvCvtColor(bgr, hsv, CV_BGR2HSV) + cvSplit(hsv, hue, 0, 0, 0)
+void bgr_to_hue(const IplImage *bgr, IplImage *hue);
+
+// OpenCV's 8 bit BGR2HSV fixed point, shared with the kernel variants
+#define HSV_SHIFT 12
+
+// round((180 << HSV_SHIFT) / (6 * diff)), 0 for diff 0
+extern int hue_hdiv_table[256];
+
+// hue from its numerator h (hue = h * 30 / diff, before wrapping) and diff = max - min
+static inline uchar hue_from(int h, int diff) {
+	h = (h * hue_hdiv_table[diff] + (1 << (HSV_SHIFT - 1))) >> HSV_SHIFT;
+	return (uchar)(h < 0 ? h + 180 : h);
+}
+
+#endif /* HUE_KERNEL_H_ */
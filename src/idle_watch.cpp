@@ -0,0 +1,147 @@
+/*
+ * idle_watch.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "idle_watch.h"
+#include "benchmarks.h"
+#include "hand_detector.h"
+
+#include <cstdio>
+#include <algorithm>
+#include <time.h>
+
+using namespace std;
+
+static const char *state_names[] = { "active", "watch" };
+
+// how fast the watch's skin level follows slow changes, eg the light, per watch frame
+#define BASELINE_RATE .05
+
+static double process_cpu_secs() {
+	timespec ts;
+	if(clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) != 0) {
+		return 0;
+	}
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+IdleWatch::IdleWatch(double idle_secs, double watch_fps, int scale, double wake_pct)
+: idle_secs(idle_secs), watch_fps(watch_fps), scale(max(scale, 1)),
+  wake_fraction(wake_pct / 100.), state(ACTIVE), last_hands_ticks(cvGetTickCount()),
+  baseline(0), have_baseline(false), watch_frame_ticks(0),
+  last_wall_ticks(last_hands_ticks), last_cpu_secs(process_cpu_secs())
+{
+	for(int i=0; i<NUM_STATES; i++) {
+		wall_secs[i] = 0;
+		cpu_secs[i] = 0;
+		frames[i] = 0;
+		entered[i] = 0;
+	}
+	entered[ACTIVE] = 1;
+}
+
+void IdleWatch::account() {
+	int64 now = cvGetTickCount();
+	double cpu = process_cpu_secs();
+	wall_secs[state] += ticks_to_ms(now - last_wall_ticks) / 1000.;
+	cpu_secs[state] += cpu - last_cpu_secs;
+	last_wall_ticks = now;
+	last_cpu_secs = cpu;
+}
+
+void IdleWatch::enter(State s) {
+	account();
+	state = s;
+	entered[s]++;
+	if(s == WATCH) {
+		// the first watch frame sets the level to wake over
+		have_baseline = false;
+	} else {
+		last_hands_ticks = cvGetTickCount();
+	}
+}
+
+double IdleWatch::skin_fraction(const IplImage *bgr) {
+	CvSize size = cvSize(max(bgr->width / scale, 1), max(bgr->height / scale, 1));
+	small.ensure(size, IPL_DEPTH_8U, 3);
+	small_mask.ensure(size, IPL_DEPTH_8U, 1);
+	// nearest neighbour only reads the pixels it keeps
+	cvResize(bgr, small, CV_INTER_NN);
+	segmenter.run(small, small_mask);
+	long skin = 0;
+	for(int y=0; y<size.height; y++) {
+		const uchar *row = (const uchar *)(small_mask->imageData + y * small_mask->widthStep);
+		for(int x=0; x<size.width; x++) {
+			skin += row[x] > DefaultHandConfig::threshold;
+		}
+	}
+	return (double)skin / (size.width * size.height);
+}
+
+bool IdleWatch::check(const IplImage *bgr) {
+	if(state != WATCH) {
+		return true;
+	}
+	frames[WATCH]++;
+	watch_frame_ticks = cvGetTickCount();
+	double skin = skin_fraction(bgr);
+	if(!have_baseline) {
+		baseline = skin;
+		have_baseline = true;
+		account();
+		return false;
+	}
+	if(skin > baseline + wake_fraction) {
+		enter(ACTIVE);
+		return true;
+	}
+	// only follows drops quickly, a hand creeping in slowly still wakes it eventually
+	baseline += (skin < baseline ? 4 : 1) * BASELINE_RATE * (skin - baseline);
+	account();
+	return false;
+}
+
+void IdleWatch::frame_done(bool had_hands) {
+	if(state != ACTIVE) {
+		return;
+	}
+	frames[ACTIVE]++;
+	int64 now = cvGetTickCount();
+	if(had_hands) {
+		last_hands_ticks = now;
+	} else if(ticks_to_ms(now - last_hands_ticks) / 1000. >= idle_secs) {
+		enter(WATCH);
+		return;
+	}
+	account();
+}
+
+int IdleWatch::wait_ms() const {
+	double period = 1000. / max(watch_fps, .1);
+	double left = period - ticks_to_ms(cvGetTickCount() - watch_frame_ticks);
+	return max((int)left, 1);
+}
+
+void IdleWatch::print_stats() const {
+	// the time since the last frame goes to the current state too
+	double wall[NUM_STATES], cpu[NUM_STATES];
+	for(int i=0; i<NUM_STATES; i++) {
+		wall[i] = wall_secs[i];
+		cpu[i] = cpu_secs[i];
+	}
+	wall[state] += ticks_to_ms(cvGetTickCount() - last_wall_ticks) / 1000.;
+	cpu[state] += process_cpu_secs() - last_cpu_secs;
+
+	printf("IdleWatch: after %.0f s without hands, %.1f fps at 1/%d size, wakes at +%.2f%% skin\n",
+			idle_secs, watch_fps, scale, wake_fraction * 100);
+	for(int i=0; i<NUM_STATES; i++) {
+		printf("  %-7s entered %4ld times, %7ld frames, %8.1f s wall, %8.2f s cpu",
+				state_names[i], entered[i], frames[i], wall[i], cpu[i]);
+		if(wall[i] > 0) {
+			printf(", %6.2f cpu s per minute", cpu[i] * 60 / wall[i]);
+		}
+		printf("\n");
+	}
+}
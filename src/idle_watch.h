@@ -0,0 +1,90 @@
+/*
+ * idle_watch.h
+ *
+ * Power saving for always on displays.  With nobody in front of the camera the full
+ * pipeline is a core's worth of work for nothing, so after idle_secs without a hand
+ * the loop drops to a watch state:
+ *
+ * 	ACTIVE  every frame through the whole pipeline, at the camera's rate
+ * 	WATCH   watch_fps frames a second, each shrunk by scale and backprojected, and
+ * 	        only its skin pixels counted -- no morphology, no contours
+ *
+ * A watch frame with noticeably more skin than when the watch started (someone walked
+ * in) wakes the loop, and that same frame goes through the full pipeline, so waking
+ * costs no frames.  CPU time is kept per state and reported per minute in each.
+ * Implementation in idle_watch.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef IDLE_WATCH_H_
+#define IDLE_WATCH_H_
+
+#include "cv.h"
+
+#include "cv_handles.h"
+#include "skin_lut.h"
+#include "strip_segmenter.h"
+
+class IdleWatch {
+public:
+	enum State { ACTIVE, WATCH, NUM_STATES };
+
+	// idle_secs -- without hands this long, go to watch
+	// watch_fps -- frames looked at per second while watching
+	// scale -- watch frames are shrunk by this in each direction
+	// wake_pct -- skin pixels, % of the frame, over the watch's starting level that wake
+	IdleWatch(double idle_secs = 10, double watch_fps = 4, int scale = 4,
+			double wake_pct = .5);
+
+	// what the watch backprojects with, as StripSegmenter (not owned)
+	void set_hist(const CvHistogram *hist) { segmenter.set_hist(hist); }
+	void set_lut(const HueSatLut *lut) { segmenter.set_lut(lut); }
+
+	bool watching() const { return state == WATCH; }
+
+	// while watching, the cheap look at bgr -- true if it woke up, and bgr should
+	// get the full pipeline this frame
+	bool check(const IplImage *bgr);
+
+	// after a fully processed frame, whether it had hands
+	void frame_done(bool had_hands);
+
+	// how long to wait for a key after a watch frame to keep to watch_fps
+	int wait_ms() const;
+
+	// frames, wall and cpu time in each state, cpu seconds per minute
+	void print_stats() const;
+
+private:
+	void enter(State s);
+	// wall and cpu time since the last call go to the current state
+	void account();
+	// fraction of the watch mask's pixels that are skin
+	double skin_fraction(const IplImage *bgr);
+
+	double idle_secs;
+	double watch_fps;
+	int scale;
+	double wake_fraction;
+
+	State state;
+	int64 last_hands_ticks;
+	// skin fraction when the watch started, slowly following the light
+	double baseline;
+	bool have_baseline;
+	int64 watch_frame_ticks;
+
+	StripSegmenter segmenter;
+	Image small, small_mask;
+
+	// accounting
+	int64 last_wall_ticks;
+	double last_cpu_secs;
+	double wall_secs[NUM_STATES];
+	double cpu_secs[NUM_STATES];
+	long frames[NUM_STATES];
+	long entered[NUM_STATES];
+};
+
+#endif /* IDLE_WATCH_H_ */
@@ -0,0 +1,95 @@
+/*
+ * latency_budget.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "latency_budget.h"
+#include "trace.h"
+
+#include <cstdio>
+
+// step back up a level after this many frames under RELAX_RATIO of the budget
+#define RELAX_FRAMES 15
+#define RELAX_RATIO .6
+
+static const char *level_names[] = { "full", "cap contours", "coarse", "reuse" };
+
+LatencyBudget::LatencyBudget(double _budget_ms, int _contour_cap)
+: budget_ms(_budget_ms), contour_cap(_contour_cap), capture_ticks(0),
+  planned_level(FULL), frame_level(FULL), good_streak(0),
+  frames(0), dropped(0), degraded(0), capped_frames(0), over_budget(0),
+  max_latency_ms(0)
+{
+	for(int i=0; i<NUM_BUCKETS; i++) {
+		buckets[i] = 0;
+	}
+}
+
+void LatencyBudget::start_frame(int64 _capture_ticks) {
+	capture_ticks = _capture_ticks;
+	frame_level = planned_level;
+	// stale before we even start -- don't spend anything on it
+	if(over()) {
+		frame_level = REUSE;
+	}
+}
+
+void LatencyBudget::end_frame() {
+	double latency = elapsed_ms();
+	frames++;
+	if(frame_level == REUSE) {
+		dropped++;
+	} else if(frame_level != FULL) {
+		degraded++;
+	}
+	if(latency > max_latency_ms) {
+		max_latency_ms = latency;
+	}
+	int b = (int)(latency / (budget_ms / 4));
+	buckets[b < NUM_BUCKETS ? b : NUM_BUCKETS - 1]++;
+
+	if(latency > budget_ms) {
+		over_budget++;
+		good_streak = 0;
+		if(planned_level < REUSE) {
+			planned_level = Level(planned_level + 1);
+		}
+	} else if(latency < budget_ms * RELAX_RATIO) {
+		if(++good_streak >= RELAX_FRAMES && planned_level > FULL) {
+			planned_level = Level(planned_level - 1);
+			good_streak = 0;
+		}
+	} else {
+		good_streak = 0;
+	}
+}
+
+void LatencyBudget::reset() {
+	planned_level = FULL;
+	good_streak = 0;
+}
+
+double LatencyBudget::elapsed_ms() const {
+	return ticks_to_ms(cvGetTickCount() - capture_ticks);
+}
+
+double LatencyBudget::remaining_ms() const {
+	return budget_ms - elapsed_ms();
+}
+
+void LatencyBudget::print_stats() const {
+	printf("LatencyBudget: %.1f ms budget, %ld frames, max latency %.1f ms\n",
+			budget_ms, frames, max_latency_ms);
+	printf("  over budget %ld, dropped (reused hands) %ld, degraded %ld, "
+			"contours capped %ld, now at \"%s\"\n",
+			over_budget, dropped, degraded, capped_frames, level_names[planned_level]);
+	for(int i=0; i<NUM_BUCKETS; i++) {
+		if(i < NUM_BUCKETS - 1) {
+			printf("  %6.1f - %6.1f ms: %ld\n", i * budget_ms / 4, (i+1) * budget_ms / 4,
+					buckets[i]);
+		} else {
+			printf("  %6.1f+        ms: %ld\n", i * budget_ms / 4, buckets[i]);
+		}
+	}
+}
@@ -0,0 +1,85 @@
+/*
+ * latency_budget.h
+ *
+ * Per frame deadline for the low latency mode.  Each frame's budget starts when the
+ * frame was captured -- so time it sat in the driver's queue and the wait for it count
+ * -- and the stages check what's left as they go.  When frames run
+ * over, the next ones degrade step by step:
+ *
+ * 	FULL          everything
+ * 	CAP_CONTOURS  stop analysing contours once the budget is spent / past a cap
+ * 	COARSE        contour search on a half resolution mask
+ * 	REUSE         skip detection, shoot from the last frame's hands
+ *
+ * and step back up after a run of frames comfortably under budget.  A frame that is
+ * already over budget by the time we get to it is dropped (REUSE) no matter what, so
+ * lag can't pile up behind a slow frame.  Frames the loop deliberately sits out (the
+ * idle watch) are left out altogether and reset() it on the way back.
+ * Implementation in latency_budget.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef LATENCY_BUDGET_H_
+#define LATENCY_BUDGET_H_
+
+#include "cv.h"
+
+class LatencyBudget {
+public:
+	enum Level { FULL, CAP_CONTOURS, COARSE, REUSE };
+
+	// budget_ms -- capture to display deadline for each frame
+	// contour_cap -- most contours analysed per frame at CAP_CONTOURS and below
+	LatencyBudget(double budget_ms, int contour_cap = 8);
+
+	// call as soon as the frame is in hand, before any work on it
+	// capture_ticks -- when it was captured, in cvGetTickCount ticks: the driver's
+	// buffer timestamp, or failing that from before the (blocking) read
+	// decides the level for this frame
+	void start_frame(int64 capture_ticks);
+	// call after the frame is shown / written, picks the next frame's level
+	void end_frame();
+	// back to FULL with no streak, for after a pause the budget didn't run through
+	// (eg the idle watch, whose frames are never start_frame()d)
+	void reset();
+
+	double elapsed_ms() const;
+	double remaining_ms() const;
+	bool over() const { return remaining_ms() <= 0; }
+
+	Level level() const { return frame_level; }
+	// contours the detector may analyse this frame, -1 for no cap
+	int max_contours() const { return frame_level >= CAP_CONTOURS ? contour_cap : -1; }
+	// mask downscale factor for the contour search
+	int downscale() const { return frame_level >= COARSE ? 2 : 1; }
+
+	// the detector ran out of budget or hit the cap and left contours unexamined
+	void note_contours_capped() { capped_frames++; }
+
+	// counts and latency histogram since construction
+	void print_stats() const;
+
+	double budget_ms;
+
+private:
+	int contour_cap;
+	int64 capture_ticks;
+	// level the next frame starts at, and the one this frame got
+	Level planned_level;
+	Level frame_level;
+	// frames in a row well under budget
+	int good_streak;
+
+	long frames;
+	long dropped;
+	long degraded;
+	long capped_frames;
+	long over_budget;
+	double max_latency_ms;
+	// latency in multiples of budget/4, last bucket is everything past 2x budget
+	enum { NUM_BUCKETS = 9 };
+	long buckets[NUM_BUCKETS];
+};
+
+#endif /* LATENCY_BUDGET_H_ */
@@ -0,0 +1,515 @@
+/*
+ * mjpeg_server.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "mjpeg_server.h"
+#include "benchmarks.h"
+#include "highgui.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+
+//******* unix/linux only for sockets
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "time.h"
+
+using namespace std;
+
+struct JpegFrame {
+	int refs;
+	long seq;
+	CvMat *data;
+};
+
+static JpegFrame* acquire(JpegFrame *f) {
+	__sync_fetch_and_add(&f->refs, 1);
+	return f;
+}
+
+static void release(JpegFrame *f) {
+	if(__sync_sub_and_fetch(&f->refs, 1) == 0) {
+		cvReleaseMat(&f->data);
+		delete f;
+	}
+}
+
+static const char *stream_names[NUM_STREAMS] = { "image", "backproject", "debug" };
+
+// a connection that stops taking data for this long is given up on
+static const int SOCKET_TIMEOUT_SECS = 5;
+// a single frame request waits this long for one
+static const int SINGLE_WAIT_SECS = 5;
+// what the kernel queues for a client, a couple of frames -- a slow client then waits
+// in send and skips to the newest frame, rather than being fed ever older ones
+static const int CLIENT_SEND_BUFFER = 128 * 1024;
+
+bool parse_server_settings(const char *spec, ServerSettings *s) {
+	const char *colon = strchr(spec, ':');
+	const char *port = spec;
+	// a dot means the first part is the address
+	if(colon && memchr(spec, '.', colon - spec)) {
+		s->address = string(spec, colon - spec);
+		port = colon + 1;
+	}
+	char *end;
+	s->port = strtol(port, &end, 10);
+	if(end == port || s->port < 0 || s->port > 65535) {
+		return false;
+	}
+	while(*end == ':') {
+		const char *part = end + 1;
+		if(strncmp(part, "quality=", 8) == 0) {
+			s->quality = strtol(part + 8, &end, 10);
+			if(end == part + 8 || s->quality < 0 || s->quality > 100) {
+				return false;
+			}
+		} else {
+			return false;
+		}
+	}
+	return *end == 0;
+}
+
+// all of data, false if the client has gone or stopped taking it
+static bool send_all(int fd, const void *data, size_t bytes) {
+	const char *p = (const char *)data;
+	while(bytes > 0) {
+		ssize_t n = send(fd, p, bytes, MSG_NOSIGNAL);
+		if(n < 0 && errno == EINTR) {
+			continue;
+		}
+		if(n <= 0) {
+			return false;
+		}
+		p += n;
+		bytes -= n;
+	}
+	return true;
+}
+
+static bool send_str(int fd, const char *s) {
+	return send_all(fd, s, strlen(s));
+}
+
+MjpegServer::Stream::Stream()
+: pending(false), latest(NULL), seq(0), clients(0), offered(0), skipped(0), encoded(0),
+  jpeg_bytes(0), encode_ms(0)
+{}
+
+MjpegServer::MjpegServer()
+: started(false), stopping(false), listen_fd(-1), bound_port(0), clients_served(0),
+  clients_refused(0), frames_sent(0), frames_dropped(0)
+{
+	pthread_mutex_init(&lock, NULL);
+	pthread_cond_init(&staged, NULL);
+	pthread_cond_init(&encoded, NULL);
+	pthread_cond_init(&left, NULL);
+}
+
+MjpegServer::~MjpegServer() {
+	if(started) {
+		pthread_mutex_lock(&lock);
+		stopping = true;
+		pthread_cond_broadcast(&staged);
+		pthread_cond_broadcast(&encoded);
+		// clients blocked in send / recv come out now
+		for(size_t i=0; i<client_fds.size(); i++) {
+			shutdown(client_fds[i], SHUT_RDWR);
+		}
+		pthread_mutex_unlock(&lock);
+		shutdown(listen_fd, SHUT_RDWR);
+		pthread_join(acceptor, NULL);
+		pthread_join(encoder, NULL);
+		close(listen_fd);
+		pthread_mutex_lock(&lock);
+		while(!client_fds.empty()) {
+			pthread_cond_wait(&left, &lock);
+		}
+		pthread_mutex_unlock(&lock);
+		for(int s=0; s<NUM_STREAMS; s++) {
+			if(streams[s].latest) {
+				release(streams[s].latest);
+			}
+		}
+	}
+	pthread_mutex_destroy(&lock);
+	pthread_cond_destroy(&staged);
+	pthread_cond_destroy(&encoded);
+	pthread_cond_destroy(&left);
+}
+
+bool MjpegServer::start(const ServerSettings& _settings) {
+	settings = _settings;
+	sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(settings.port);
+	if(inet_pton(AF_INET, settings.address.c_str(), &addr.sin_addr) != 1) {
+		fprintf(stderr, "serve: bad address %s\n", settings.address.c_str());
+		return false;
+	}
+	listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+	int on = 1;
+	setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+	socklen_t len = sizeof(addr);
+	if(listen_fd < 0 || bind(listen_fd, (sockaddr *)&addr, sizeof(addr)) != 0 ||
+			listen(listen_fd, 8) != 0 ||
+			getsockname(listen_fd, (sockaddr *)&addr, &len) != 0) {
+		fprintf(stderr, "serve: can't listen on %s:%d (%s)\n", settings.address.c_str(),
+				settings.port, strerror(errno));
+		if(listen_fd >= 0) {
+			close(listen_fd);
+		}
+		return false;
+	}
+	bound_port = ntohs(addr.sin_port);
+
+	if(pthread_create(&encoder, NULL, encode_main, this) != 0) {
+		fprintf(stderr, "serve: can't start the encoder thread\n");
+		close(listen_fd);
+		return false;
+	}
+	if(pthread_create(&acceptor, NULL, accept_main, this) != 0) {
+		fprintf(stderr, "serve: can't start the accept thread\n");
+		pthread_mutex_lock(&lock);
+		stopping = true;
+		pthread_cond_broadcast(&staged);
+		pthread_mutex_unlock(&lock);
+		pthread_join(encoder, NULL);
+		close(listen_fd);
+		return false;
+	}
+	started = true;
+	printf("serve: http://%s:%d/ -- /image /backproject /debug, .jpg for one frame\n",
+			settings.address.c_str(), bound_port);
+	return true;
+}
+
+bool MjpegServer::wants(StreamId stream) {
+	if(!started) {
+		return false;
+	}
+	pthread_mutex_lock(&lock);
+	bool watched = streams[stream].clients > 0;
+	pthread_mutex_unlock(&lock);
+	return watched;
+}
+
+void MjpegServer::offer(StreamId stream, const IplImage *frame) {
+	if(!started || !frame) {
+		return;
+	}
+	Stream& s = streams[stream];
+	pthread_mutex_lock(&lock);
+	bool watched = s.clients > 0;
+	bool busy = s.pending;
+	if(watched) {
+		s.offered++;
+		s.skipped += busy;
+	}
+	pthread_mutex_unlock(&lock);
+	if(!watched || busy) {
+		return;
+	}
+	// not pending, so staging is ours until we say otherwise
+	cvCopy(frame, s.staging.ensure(cvGetSize(frame), frame->depth, frame->nChannels));
+	pthread_mutex_lock(&lock);
+	s.pending = true;
+	pthread_cond_signal(&staged);
+	pthread_mutex_unlock(&lock);
+}
+
+void* MjpegServer::encode_main(void *arg) {
+	((MjpegServer *)arg)->encode_loop();
+	return NULL;
+}
+
+void MjpegServer::encode_loop() {
+	int params[] = { CV_IMWRITE_JPEG_QUALITY, settings.quality, 0 };
+	// round robin, so a busy stream can't keep the others waiting
+	int last = NUM_STREAMS - 1;
+	pthread_mutex_lock(&lock);
+	while(!stopping) {
+		int next = -1;
+		for(int i=1; i<=NUM_STREAMS && next < 0; i++) {
+			if(streams[(last + i) % NUM_STREAMS].pending) {
+				next = (last + i) % NUM_STREAMS;
+			}
+		}
+		if(next < 0) {
+			pthread_cond_wait(&staged, &lock);
+			continue;
+		}
+		Stream& s = streams[next];
+		last = next;
+		pthread_mutex_unlock(&lock);
+
+		int64 start = cvGetTickCount();
+		CvMat *data = cvEncodeImage(".jpg", s.staging, params);
+		double ms = ticks_to_ms(cvGetTickCount() - start);
+
+		pthread_mutex_lock(&lock);
+		s.pending = false;
+		if(!data) {
+			continue;
+		}
+		JpegFrame *f = new JpegFrame;
+		// the stream's own reference
+		f->refs = 1;
+		f->seq = ++s.seq;
+		f->data = data;
+		if(s.latest) {
+			release(s.latest);
+		}
+		s.latest = f;
+		s.encoded++;
+		s.jpeg_bytes += data->rows * data->cols;
+		s.encode_ms += ms;
+		pthread_cond_broadcast(&encoded);
+	}
+	pthread_mutex_unlock(&lock);
+}
+
+struct ClientArg {
+	MjpegServer *server;
+	int fd;
+};
+
+void* MjpegServer::accept_main(void *arg) {
+	((MjpegServer *)arg)->accept_loop();
+	return NULL;
+}
+
+void MjpegServer::accept_loop() {
+	while(1) {
+		int fd = accept(listen_fd, NULL, NULL);
+		pthread_mutex_lock(&lock);
+		bool stop = stopping;
+		pthread_mutex_unlock(&lock);
+		if(stop) {
+			if(fd >= 0) {
+				close(fd);
+			}
+			return;
+		}
+		if(fd < 0) {
+			// out of descriptors or the like, don't spin on it
+			if(errno != EINTR && errno != ECONNABORTED) {
+				timespec pause = { 0, 100 * 1000000 };
+				nanosleep(&pause, NULL);
+			}
+			continue;
+		}
+		timeval timeout = { SOCKET_TIMEOUT_SECS, 0 };
+		setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+		setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+		int buffer = CLIENT_SEND_BUFFER;
+		setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &buffer, sizeof(buffer));
+
+		pthread_mutex_lock(&lock);
+		bool full = (int)client_fds.size() >= settings.max_clients;
+		if(full) {
+			clients_refused++;
+		} else {
+			client_fds.push_back(fd);
+		}
+		pthread_mutex_unlock(&lock);
+		if(full) {
+			send_str(fd, "HTTP/1.0 503 Service Unavailable\r\nConnection: close\r\n\r\n");
+			close(fd);
+			continue;
+		}
+		ClientArg *arg = new ClientArg;
+		arg->server = this;
+		arg->fd = fd;
+		pthread_t client;
+		if(pthread_create(&client, NULL, client_main, arg) != 0) {
+			delete arg;
+			pthread_mutex_lock(&lock);
+			client_fds.pop_back();
+			clients_refused++;
+			pthread_mutex_unlock(&lock);
+			close(fd);
+			continue;
+		}
+		pthread_detach(client);
+	}
+}
+
+void* MjpegServer::client_main(void *p) {
+	ClientArg *arg = (ClientArg *)p;
+	MjpegServer *server = arg->server;
+	int fd = arg->fd;
+	delete arg;
+	server->serve(fd);
+
+	pthread_mutex_lock(&server->lock);
+	vector<int>& fds = server->client_fds;
+	for(size_t i=0; i<fds.size(); i++) {
+		if(fds[i] == fd) {
+			fds.erase(fds.begin() + i);
+			break;
+		}
+	}
+	close(fd);
+	pthread_cond_signal(&server->left);
+	pthread_mutex_unlock(&server->lock);
+	return NULL;
+}
+
+void MjpegServer::serve(int fd) {
+	// just the request line matters, headers are read and ignored
+	char request[2048];
+	int got = 0;
+	while(got < (int)sizeof(request) - 1) {
+		ssize_t n = recv(fd, request + got, sizeof(request) - 1 - got, 0);
+		if(n < 0 && errno == EINTR) {
+			continue;
+		}
+		if(n <= 0) {
+			return;
+		}
+		got += n;
+		request[got] = 0;
+		if(strstr(request, "\r\n\r\n") || strstr(request, "\n\n")) {
+			break;
+		}
+	}
+	request[got] = 0;
+	char path[256];
+	if(sscanf(request, "GET %255s", path) != 1) {
+		send_str(fd, "HTTP/1.0 400 Bad Request\r\nConnection: close\r\n\r\n");
+		return;
+	}
+	char *query = strchr(path, '?');
+	if(query) {
+		*query = 0;
+	}
+	pthread_mutex_lock(&lock);
+	clients_served++;
+	pthread_mutex_unlock(&lock);
+
+	if(strcmp(path, "/") == 0) {
+		send_str(fd, "HTTP/1.0 200 OK\r\nContent-Type: text/html\r\nConnection: close\r\n\r\n"
+				"<html><body><h3>fingershooter</h3>\n");
+		char line[256];
+		for(int s=0; s<NUM_STREAMS; s++) {
+			sprintf(line, "<p><a href=\"/%s\">%s</a> (<a href=\"/%s.jpg\">one frame</a>)</p>\n",
+					stream_names[s], stream_names[s], stream_names[s]);
+			send_str(fd, line);
+		}
+		send_str(fd, "</body></html>\n");
+		return;
+	}
+	for(int s=0; s<NUM_STREAMS; s++) {
+		const char *name = stream_names[s];
+		size_t len = strlen(name);
+		if(path[0] == '/' && strncmp(path + 1, name, len) == 0) {
+			if(path[len + 1] == 0) {
+				serve_stream(fd, (StreamId)s, false);
+				return;
+			}
+			if(strcmp(path + len + 1, ".jpg") == 0) {
+				serve_stream(fd, (StreamId)s, true);
+				return;
+			}
+		}
+	}
+	send_str(fd, "HTTP/1.0 404 Not Found\r\nContent-Type: text/plain\r\nConnection: close\r\n\r\n"
+			"no such stream, try /image /backproject /debug\n");
+}
+
+void MjpegServer::serve_stream(int fd, StreamId stream, bool single) {
+	if(!single && !send_str(fd, "HTTP/1.0 200 OK\r\n"
+			"Content-Type: multipart/x-mixed-replace; boundary=frame\r\n"
+			"Cache-Control: no-cache, no-store\r\nPragma: no-cache\r\n"
+			"Connection: close\r\n\r\n")) {
+		return;
+	}
+	Stream& s = streams[stream];
+	timespec deadline;
+	clock_gettime(CLOCK_REALTIME, &deadline);
+	deadline.tv_sec += SINGLE_WAIT_SECS;
+
+	pthread_mutex_lock(&lock);
+	s.clients++;
+	// whatever is encoded already may be old, start with the next one
+	long seen = s.seq;
+	bool first = true;
+	bool sent = false;
+	while(!stopping) {
+		if(s.seq == seen) {
+			if(single) {
+				if(pthread_cond_timedwait(&encoded, &lock, &deadline) == ETIMEDOUT) {
+					break;
+				}
+			} else {
+				pthread_cond_wait(&encoded, &lock);
+			}
+			continue;
+		}
+		JpegFrame *f = acquire(s.latest);
+		// the ones encoded while this client was still sending the last
+		if(!first) {
+			frames_dropped += f->seq - seen - 1;
+		}
+		first = false;
+		seen = f->seq;
+		pthread_mutex_unlock(&lock);
+
+		int bytes = f->data->rows * f->data->cols;
+		char header[256];
+		if(single) {
+			sprintf(header, "HTTP/1.0 200 OK\r\nContent-Type: image/jpeg\r\n"
+					"Content-Length: %d\r\nConnection: close\r\n\r\n", bytes);
+		} else {
+			sprintf(header, "--frame\r\nContent-Type: image/jpeg\r\n"
+					"Content-Length: %d\r\n\r\n", bytes);
+		}
+		bool ok = send_str(fd, header) && send_all(fd, f->data->data.ptr, bytes) &&
+				(single || send_str(fd, "\r\n"));
+		release(f);
+
+		pthread_mutex_lock(&lock);
+		frames_sent += ok;
+		sent = true;
+		if(!ok || single) {
+			break;
+		}
+	}
+	s.clients--;
+	pthread_mutex_unlock(&lock);
+	// a single frame that never came
+	if(single && !sent) {
+		send_str(fd, "HTTP/1.0 503 Service Unavailable\r\nContent-Type: text/plain\r\n"
+				"Connection: close\r\n\r\nno frames on this stream\n");
+	}
+}
+
+void MjpegServer::print_stats() {
+	if(!started) {
+		return;
+	}
+	pthread_mutex_lock(&lock);
+	printf("MjpegServer: %ld clients (%ld turned away), %ld frames sent, %ld not sent to "
+			"slow clients\n", clients_served, clients_refused, frames_sent, frames_dropped);
+	for(int i=0; i<NUM_STREAMS; i++) {
+		Stream& s = streams[i];
+		if(s.offered == 0) {
+			continue;
+		}
+		long each = s.encoded ? s.encoded : 1;
+		printf("  %-12s %6ld frames watched, %6ld encoded (%.2f ms, %ld KB each), "
+				"%ld skipped with the encoder busy\n", stream_names[i], s.offered, s.encoded,
+				s.encode_ms / each, s.jpeg_bytes / each / 1024, s.skipped);
+	}
+	pthread_mutex_unlock(&lock);
+}
@@ -0,0 +1,127 @@
+/*
+ * mjpeg_server.h
+ *
+ * The Image, Backproject and DebugImage windows as MJPEG over http, for watching a box
+ * without a desktop session on it:
+ *
+ * 	fingershooter --serve [address:]port[:quality=Q]
+ *
+ * 	/              list of the streams
+ * 	/image         the frame with the bullets, as the Image window
+ * 	/backproject   the raw backprojection
+ * 	/debug         the debug overlay (rendered while anyone watches it)
+ * 	/<stream>.jpg  a single frame
+ *
+ * 	curl -s http://127.0.0.1:8080/image.jpg -o frame.jpg
+ * 	curl -s http://127.0.0.1:8080/image --max-time 5 | grep -ac image/jpeg
+ *
+ * Only localhost unless another address is given (0.0.0.0 for all).
+ *
+ * The loop only ever copies a frame into a stream's staging buffer, and only while
+ * somebody watches it and the encoder has finished the last one -- otherwise the frame
+ * is skipped.  One encoder thread turns staged frames into JPEGs, each once however
+ * many clients there are, and each client's thread sends the newest one, shared and
+ * reference counted.  A slow client never holds anything up, it just gets fewer frames.
+ * Implementation in mjpeg_server.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef MJPEG_SERVER_H_
+#define MJPEG_SERVER_H_
+
+#include "cv.h"
+#include <vector>
+#include <string>
+
+//******* unix/linux only for the server threads
+#include <pthread.h>
+
+#include "cv_handles.h"
+
+enum StreamId { STREAM_IMAGE, STREAM_BACKPROJECT, STREAM_DEBUG, NUM_STREAMS };
+
+struct ServerSettings {
+	ServerSettings() : address("127.0.0.1"), port(8080), quality(80), max_clients(16) {}
+
+	std::string address;
+	// 0 for any free one, see MjpegServer::port()
+	int port;
+	// JPEG quality, 0-100
+	int quality;
+	// connections past this are closed straight away
+	int max_clients;
+};
+
+// "[address:]port[:quality=Q]", eg "8080", "0.0.0.0:8080:quality=60"
+bool parse_server_settings(const char *spec, ServerSettings *s);
+
+// one encoded frame, shared by every client sending it, in mjpeg_server.cpp
+struct JpegFrame;
+
+class MjpegServer {
+public:
+	MjpegServer();
+	// closes every connection and waits for the threads
+	~MjpegServer();
+
+	// listens and starts the threads, false (and a message) if it can't
+	bool start(const ServerSettings& settings);
+	bool running() const { return started; }
+	// the port listened on
+	int port() const { return bound_port; }
+
+	// whether anyone is watching -- eg whether the debug image needs rendering
+	bool wants(StreamId stream);
+	// the stream's newest frame, 8 bit 1 or 3 channel -- copied if anyone watches and
+	// the encoder is free, otherwise skipped
+	void offer(StreamId stream, const IplImage *frame);
+
+	void print_stats();
+
+private:
+	struct Stream {
+		Stream();
+
+		// staging is the encoder's while pending
+		Image staging;
+		bool pending;
+		// newest encoded frame, NULL until the first
+		JpegFrame *latest;
+		long seq;
+		int clients;
+		long offered, skipped, encoded;
+		long jpeg_bytes;
+		double encode_ms;
+	};
+
+	static void* accept_main(void *arg);
+	static void* encode_main(void *arg);
+	static void* client_main(void *arg);
+	void accept_loop();
+	void encode_loop();
+	void serve(int fd);
+	void serve_stream(int fd, StreamId stream, bool single);
+
+	ServerSettings settings;
+	bool started;
+	bool stopping;
+	int listen_fd;
+	int bound_port;
+	pthread_t acceptor, encoder;
+
+	// guards everything below, and the streams but for staging
+	pthread_mutex_t lock;
+	// a frame staged, or stopping
+	pthread_cond_t staged;
+	// a frame encoded, or stopping
+	pthread_cond_t encoded;
+	// a client gone
+	pthread_cond_t left;
+	Stream streams[NUM_STREAMS];
+	std::vector<int> client_fds;
+	long clients_served, clients_refused;
+	long frames_sent, frames_dropped;
+};
+
+#endif /* MJPEG_SERVER_H_ */
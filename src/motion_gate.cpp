@@ -0,0 +1,137 @@
+/*
+ * motion_gate.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "motion_gate.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+// sum of |a[i] - b[i]| over n bytes
+static unsigned sad_bytes(const uchar *a, const uchar *b, int n) {
+	unsigned sum = 0;
+	int i = 0;
+#ifdef __SSE2__
+	__m128i acc = _mm_setzero_si128();
+	for(; i <= n - 16; i += 16) {
+		__m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+		__m128i vb = _mm_loadu_si128((const __m128i *)(b + i));
+		acc = _mm_add_epi64(acc, _mm_sad_epu8(va, vb));
+	}
+	sum = _mm_cvtsi128_si32(acc) + _mm_cvtsi128_si32(_mm_srli_si128(acc, 8));
+#endif
+	for(; i < n; i++) {
+		sum += abs(a[i] - b[i]);
+	}
+	return sum;
+}
+
+MotionGate::MotionGate(int _block, int _step, int _threshold)
+: block(_block), step(_step), threshold(_threshold), cols(0), rows(0),
+  frame_size(cvSize(0, 0)), row_bytes(0), num_changed(0),
+  frames(0), still_frames(0), changed_blocks(0), contours_reused(0)
+{}
+
+int MotionGate::update(const IplImage *bgr, bool keep) {
+	frames++;
+	int sampled_rows = (bgr->height + step - 1) / step;
+	if(bgr->width != frame_size.width || bgr->height != frame_size.height) {
+		// new size, nothing to compare against
+		frame_size = cvGetSize(bgr);
+		cols = (bgr->width + block - 1) / block;
+		rows = (bgr->height + block - 1) / block;
+		row_bytes = bgr->width * bgr->nChannels;
+		prev.resize(sampled_rows * row_bytes);
+		for(int r=0; r<sampled_rows; r++) {
+			memcpy(&prev[r * row_bytes], bgr->imageData + r * step * bgr->widthStep, row_bytes);
+		}
+		block_sad.assign(cols * rows, 0);
+		block_changed.assign(cols * rows, 1);
+		num_changed = cols * rows;
+		if(!keep) {
+			// not a reference either, the next frame counts as new too
+			frame_size = cvSize(0, 0);
+		}
+		changed_blocks += num_changed;
+		return num_changed;
+	}
+
+	fill(block_sad.begin(), block_sad.end(), 0u);
+	int block_bytes = block * bgr->nChannels;
+	for(int r=0; r<sampled_rows; r++) {
+		int y = r * step;
+		const uchar *cur = (const uchar *)(bgr->imageData + y * bgr->widthStep);
+		const uchar *old = &prev[r * row_bytes];
+		unsigned *sad = &block_sad[(y / block) * cols];
+		for(int bx=0; bx<cols; bx++) {
+			int off = bx * block_bytes;
+			sad[bx] += sad_bytes(cur + off, old + off, min(block_bytes, row_bytes - off));
+		}
+	}
+
+	// bytes sampled in a full block
+	unsigned samples = ((block + step - 1) / step) * block_bytes;
+	num_changed = 0;
+	for(int i=0; i<cols*rows; i++) {
+		block_changed[i] = block_sad[i] > samples * threshold;
+		num_changed += block_changed[i];
+	}
+
+	// changed blocks get this frame as their reference, the rest keep theirs
+	if(keep && num_changed) {
+		for(int r=0; r<sampled_rows; r++) {
+			int y = r * step;
+			const uchar *cur = (const uchar *)(bgr->imageData + y * bgr->widthStep);
+			uchar *old = &prev[r * row_bytes];
+			const uchar *changed = &block_changed[(y / block) * cols];
+			for(int bx=0; bx<cols; bx++) {
+				if(changed[bx]) {
+					int off = bx * block_bytes;
+					memcpy(old + off, cur + off, min(block_bytes, row_bytes - off));
+				}
+			}
+		}
+	}
+	if(num_changed == 0) {
+		still_frames++;
+	}
+	changed_blocks += num_changed;
+	return num_changed;
+}
+
+bool MotionGate::region_changed(CvRect r, int scale) const {
+	if(cols == 0) {
+		return true;
+	}
+	int bx1 = max(0, r.x * scale / block);
+	int by1 = max(0, r.y * scale / block);
+	int bx2 = min(cols - 1, (r.x + r.width) * scale / block);
+	int by2 = min(rows - 1, (r.y + r.height) * scale / block);
+	for(int by=by1; by<=by2; by++) {
+		for(int bx=bx1; bx<=bx2; bx++) {
+			if(block_changed[by * cols + bx]) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+void MotionGate::print_stats() const {
+	if(frames == 0) {
+		return;
+	}
+	printf("MotionGate: %ld frames, %ld skipped as still, %.1f%% of blocks changed on "
+			"average, %ld contours reused\n", frames, still_frames,
+			100. * changed_blocks / frames / max(1, cols * rows), contours_reused);
+}
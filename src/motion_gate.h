@@ -0,0 +1,70 @@
+/*
+ * motion_gate.h
+ *
+ * Cheap block difference against a reference frame, so idle scenes don't pay for the
+ * whole pipeline.  Every step-th row of the frame is kept and compared with the same
+ * row of later frames, block by block, with SSE2 sum of absolute differences where
+ * available.  A block changed if its mean difference per sampled byte is over
+ * threshold.
+ *
+ * A block's reference is only replaced when it counts as changed (and the frame is
+ * kept, ie analysed), so it stays the frame the cached answers for that block came
+ * from -- slow drift under threshold per frame still adds up to a change.
+ *
+ * 	no block changed   -- skip detection, shoot from the last frame's hands
+ * 	some changed       -- detection runs, but contours whose box is unchanged and
+ * 							touches no changed block reuse last frame's analysis
+ *
+ * Implementation in motion_gate.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef MOTION_GATE_H_
+#define MOTION_GATE_H_
+
+#include "cv.h"
+#include <vector>
+
+class MotionGate {
+public:
+	// block -- block side in pixels, step -- compare every step-th row
+	// threshold -- mean abs difference per sampled byte for a block to count as changed
+	MotionGate(int block = 16, int step = 4, int threshold = 8);
+
+	// compares bgr with the reference
+	// keep -- [true] the changed blocks of bgr become their reference, false if the
+	// 		frame won't be analysed (eg dropped for the latency budget) so the blocks
+	// 		stay changed until one is
+	// the first frame, or a new frame size, counts as all changed
+	// returns the number of changed blocks
+	int update(const IplImage *bgr, bool keep = true);
+
+	int changed() const { return num_changed; }
+	// true if r (in frame coordinates / scale) overlaps a changed block
+	bool region_changed(CvRect r, int scale = 1) const;
+
+	// contours the detector didn't have to re-evaluate
+	void note_contours_reused(int n) { contours_reused += n; }
+
+	// frames skipped, blocks changed on average, contours reused since construction
+	void print_stats() const;
+
+private:
+	int block, step, threshold;
+	int cols, rows;
+	CvSize frame_size;
+	// the sampled rows of each block's reference frame, packed
+	std::vector<uchar> prev;
+	int row_bytes;
+	std::vector<unsigned> block_sad;
+	std::vector<uchar> block_changed;
+	int num_changed;
+
+	long frames;
+	long still_frames;
+	long changed_blocks;
+	long contours_reused;
+};
+
+#endif /* MOTION_GATE_H_ */
@@ -13,8 +13,13 @@
 
 #include "cv.h"
 #include "highgui.h"
+#include <string>
 
 #include "bullet.h"
+#include "debug_overlay.h"
+#include "hand_detector.h"
+#include "hand_detect.h"
+#include "latency_budget.h"
 
 // colors
 const CvScalar RED = CV_RGB(255, 0, 0);
@@ -23,37 +28,64 @@ const CvScalar BLUE = CV_RGB(0, 0, 255);
 const CvScalar WHITE = CV_RGB(255, 255, 255);
 const CvScalar BLACK = CV_RGB(0, 0, 0);
 
-/** client calls this func
+/** client calls this func -- find_hands (see hand_detect.h), then fire from each hand
  * param: mask - binary mask image for segmentation (eg a backprojected image)
  * param: bullets - output- new bullets to draw on image
  * param: perimScale - [4] contours with len < image-perimeter len / perimScale will
  * 			be ignored
- * param: debug - [false] if true, draw debug imagery to debug_image
- * param: debug_image - if debug is true, this should be a 3 channel image for debug output
+ * param: overlay - [NULL] if not null, debug imagery is recorded into it
+ * 			(render it into a 3 channel image to see it)
+ * param: mask_cleaned - [false] if true, mask is already thresholded and opened/closed
+ * 			(eg by TilePipeline) and goes straight to the contour search
+ * param: budget - [NULL] if not null, the frame's latency budget -- the contour search
+ * 			stops when time is up and goes coarse when the budget says so
+ * param: per_hand - [0] most bullets each hand fires this frame, 0 for one per fingertip
+ * 			(eg BulletBudget's limits().per_hand_frame)
+ * returns the fingertips that didn't fire because of per_hand
  */
-void find_hands_and_shoot(
+int find_hands_and_shoot(
 		IplImage* mask,
 		std::vector<Bullet*>& bullets,
 		float perimScale = 4,
-		bool debug = false,
-		IplImage* debug_image = NULL);
+		DebugOverlay* overlay = NULL,
+		bool mask_cleaned = false,
+		LatencyBudget* budget = NULL,
+		int per_hand = 0);
 
+// the detector, its pool and motion gate are the HandFinder set with set_hand_finder,
+// see hand_detect.h
 
+// fires again from the hands the last find_hands_and_shoot found
+// (for frames dropped to stay within a latency budget)
+// per_hand -- [0] as find_hands_and_shoot's, returns the fingertips it held back
+int shoot_last_hands(std::vector<Bullet*>& bullets, DebugOverlay* overlay = NULL,
+		int per_hand = 0);
+
+// the hands the last find_hands_and_shoot found, eg for the flight recorder
+const std::vector<Hand>& last_found_hands();
+
+
+// true if c is shaped like an open hand -- Hu moments within OPEN_HAND_TOLERANCE_PCT of
+// a reference hand, see hand_shape.h (the detector does this on its simplified contours
+// when its shape_tolerance_pct is set)
 bool is_open_hand(CvContour *c);
 
 // prints the point using printf
 void print_pt(CvPoint p);
-// allocates and returns c string rep of point
-char* pt_str(CvPoint p);
+// string rep of point
+std::string pt_str(CvPoint p);
 // distance between points
 float pt_dist(CvPoint pt1, CvPoint pt2);
 
 // client does not call this
 // called within find_hands_and_shoot
-// bullets, num_bullets -- output params
-// debug_image -- [NULL] if not null, debug stuff will be drawn to it (3 channel)
-void fire(std::vector<CvConvexityDefect*>& defects, CvPoint bbcenter,
-		std::vector<Bullet*>& bullets, IplImage *debug_image=NULL);
+// creates bullets shooting out from hand's center through each fingertip
+// bullets -- output param
+// overlay -- [NULL] if not null, debug stuff will be recorded into it
+// per_hand -- [0] most bullets to make, spread over the fingertips, 0 for one per tip
+// returns the fingertips held back by per_hand
+int fire(const Hand& hand, std::vector<Bullet*>& bullets, DebugOverlay *overlay=NULL,
+		int per_hand=0);
 
 
 
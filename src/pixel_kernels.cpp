@@ -0,0 +1,235 @@
+/*
+ * pixel_kernels.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "pixel_kernels.h"
+
+#include <cstring>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <pthread.h>
+
+using namespace std;
+
+void lut_row_scalar(const uchar *src, uchar *dst, int n, const uchar *table) {
+	int x = 0;
+	// 4 at a time so the loads and lookups overlap
+	for(; x <= n - 4; x += 4) {
+		uchar v0 = table[src[x]], v1 = table[src[x+1]];
+		uchar v2 = table[src[x+2]], v3 = table[src[x+3]];
+		dst[x] = v0;
+		dst[x+1] = v1;
+		dst[x+2] = v2;
+		dst[x+3] = v3;
+	}
+	for(; x < n; x++) {
+		dst[x] = table[src[x]];
+	}
+}
+
+void threshold_row_scalar(const uchar *src, uchar *dst, int n, int thresh) {
+	for(int x=0; x<n; x++) {
+		dst[x] = src[x] > thresh ? 255 : 0;
+	}
+}
+
+void min3_row_scalar(const uchar *a, const uchar *b, const uchar *c, uchar *dst, int n) {
+	for(int x=0; x<n; x++) {
+		dst[x] = min(a[x], min(b[x], c[x]));
+	}
+}
+
+void max3_row_scalar(const uchar *a, const uchar *b, const uchar *c, uchar *dst, int n) {
+	for(int x=0; x<n; x++) {
+		dst[x] = max(a[x], max(b[x], c[x]));
+	}
+}
+
+void hmin3_span_scalar(const uchar *src, uchar *dst, int from, int n) {
+	for(int x=from; x<n; x++) {
+		uchar v = src[x];
+		if(x > 0) {
+			v = min(v, src[x-1]);
+		}
+		if(x < n - 1) {
+			v = min(v, src[x+1]);
+		}
+		dst[x] = v;
+	}
+}
+
+void hmax3_span_scalar(const uchar *src, uchar *dst, int from, int n) {
+	for(int x=from; x<n; x++) {
+		uchar v = src[x];
+		if(x > 0) {
+			v = max(v, src[x-1]);
+		}
+		if(x < n - 1) {
+			v = max(v, src[x+1]);
+		}
+		dst[x] = v;
+	}
+}
+
+void hmin3_row_scalar(const uchar *src, uchar *dst, int n) {
+	hmin3_span_scalar(src, dst, 0, n);
+}
+
+void hmax3_row_scalar(const uchar *src, uchar *dst, int n) {
+	hmax3_span_scalar(src, dst, 0, n);
+}
+
+void fill_bgr_row_scalar(uchar *dst, int n, const uchar *bgr) {
+	for(int x=0; x<n; x++, dst += 3) {
+		dst[0] = bgr[0];
+		dst[1] = bgr[1];
+		dst[2] = bgr[2];
+	}
+}
+
+void fill_kernels_scalar(PixelKernels *k) {
+	k->hue_row = bgr_to_hue_row_scalar;
+	k->lut_row = lut_row_scalar;
+	k->threshold_row = threshold_row_scalar;
+	k->min3_row = min3_row_scalar;
+	k->max3_row = max3_row_scalar;
+	k->hmin3_row = hmin3_row_scalar;
+	k->hmax3_row = hmax3_row_scalar;
+	k->fill_bgr_row = fill_bgr_row_scalar;
+}
+
+// every supported level's table, filled once
+static PixelKernels kernel_tables[NUM_SIMD_LEVELS];
+static pthread_once_t kernel_tables_once = PTHREAD_ONCE_INIT;
+
+static void fill_kernel_tables() {
+	for(int i=0; i<NUM_SIMD_LEVELS; i++) {
+		SimdLevel level = (SimdLevel)i;
+		if(!simd_supported(level)) {
+			continue;
+		}
+		PixelKernels *k = &kernel_tables[i];
+		fill_kernels_scalar(k);
+		if(level == SIMD_NEON) {
+			fill_kernels_neon(k);
+			continue;
+		}
+		if(level >= SIMD_SSE2) {
+			fill_kernels_sse2(k);
+		}
+		if(level >= SIMD_AVX2) {
+			fill_kernels_avx2(k);
+		}
+		if(level >= SIMD_AVX512) {
+			fill_kernels_avx512(k);
+		}
+	}
+}
+
+const PixelKernels& pixel_kernels_for(SimdLevel level) {
+	pthread_once(&kernel_tables_once, fill_kernel_tables);
+	return kernel_tables[level];
+}
+
+const PixelKernels& pixel_kernels() {
+	return pixel_kernels_for(simd_level());
+}
+
+static inline const uchar* row_of(const IplImage *img, int y) {
+	return (const uchar *)(img->imageData + y * img->widthStep);
+}
+
+static inline uchar* row_of(IplImage *img, int y) {
+	return (uchar *)(img->imageData + y * img->widthStep);
+}
+
+void threshold_binary(const IplImage *src, IplImage *dst, int thresh) {
+	const PixelKernels& k = pixel_kernels();
+	for(int y=0; y<src->height; y++) {
+		// cvThreshold's shortcuts for thresholds outside the 8 bit range
+		if(thresh < 0) {
+			memset(row_of(dst, y), 255, src->width);
+		} else if(thresh >= 255) {
+			memset(row_of(dst, y), 0, src->width);
+		} else {
+			k.threshold_row(row_of(src, y), row_of(dst, y), src->width, thresh);
+		}
+	}
+}
+
+// one 3x3 erode, or dilate, from src into dst -- column of three then along the row,
+// rows above and below clipped like the replicated border
+static void morph_pass(const PixelKernels& k, const IplImage *src, IplImage *dst,
+		bool erode, uchar *row) {
+	int w = src->width, h = src->height;
+	for(int y=0; y<h; y++) {
+		const uchar *above = row_of(src, max(y - 1, 0));
+		const uchar *below = row_of(src, min(y + 1, h - 1));
+		if(erode) {
+			k.min3_row(above, row_of(src, y), below, row, w);
+			k.hmin3_row(row, row_of(dst, y), w);
+		} else {
+			k.max3_row(above, row_of(src, y), below, row, w);
+			k.hmax3_row(row, row_of(dst, y), w);
+		}
+	}
+}
+
+void open_close_3x3(IplImage *mask, int iterations, IplImage *tmp) {
+	if(iterations <= 0) {
+		return;
+	}
+	const PixelKernels& k = pixel_kernels();
+	vector<uchar> row(mask->width);
+	// open then close is erode x itr, dilate x 2 itr, erode x itr -- an even number
+	// of passes between mask and tmp, so it ends up back in mask
+	IplImage *from = mask, *to = tmp;
+	for(int pass=0; pass<4*iterations; pass++) {
+		bool erode = pass < iterations || pass >= 3*iterations;
+		morph_pass(k, from, to, erode, &row[0]);
+		swap(from, to);
+	}
+}
+
+void lut_image(const IplImage *src, IplImage *dst, const uchar *table) {
+	const PixelKernels& k = pixel_kernels();
+	for(int y=0; y<src->height; y++) {
+		k.lut_row(row_of(src, y), row_of(dst, y), src->width, table);
+	}
+}
+
+void fill_circle(IplImage *img, CvPoint center, int radius, CvScalar color) {
+	if(radius < 0) {
+		return;
+	}
+	uchar bgr[3];
+	for(int c=0; c<3; c++) {
+		int v = cvRound(color.val[c]);
+		bgr[c] = (uchar)(v < 0 ? 0 : v > 255 ? 255 : v);
+	}
+	const PixelKernels& k = pixel_kernels();
+	int y1 = max(center.y - radius, 0);
+	int y2 = min(center.y + radius, img->height - 1);
+	// dx^2 + dy^2 <= (radius + .5)^2, in integers
+	int r2 = radius * radius + radius;
+	for(int y=y1; y<=y2; y++) {
+		int dy = y - center.y;
+		int span2 = r2 - dy * dy;
+		int dx = (int)sqrt((double)span2);
+		// in case sqrt rounded either way
+		while(dx * dx > span2) {
+			dx--;
+		}
+		while((dx + 1) * (dx + 1) <= span2) {
+			dx++;
+		}
+		int x1 = max(center.x - dx, 0);
+		int x2 = min(center.x + dx, img->width - 1);
+		if(x1 <= x2) {
+			k.fill_bgr_row(row_of(img, y) + x1 * img->nChannels, x2 - x1 + 1, bgr);
+		}
+	}
+}
@@ -0,0 +1,94 @@
+/*
+ * pixel_kernels.h
+ *
+ * The per-pixel work of the segmentation and drawing -- hue conversion, backprojection
+ * through a table, threshold, 3x3 morphology and filled circles for the bullets -- as
+ * row kernels with a scalar, SSE2, AVX2, AVX-512 and NEON variant each, picked at
+ * startup by simd_dispatch.h.  A variant only has the kernels it speeds up, the rest
+ * come from the level below it:
+ *
+ * 	kernel          sse2   avx2   avx512       neon
+ * 	hue_row          x      x     x            x
+ * 	lut_row                       x (VBMI)     x
+ * 	threshold_row    x      x     x            x
+ * 	min3/max3_row    x      x     x            x
+ * 	hmin3/hmax3_row  x      x     x            x
+ * 	fill_bgr_row     x      x     x            x
+ *
+ * Every variant is byte for byte the scalar kernel (test_pixel_kernels() in
+ * benchmarks.cpp), and the image level functions below are byte for byte the OpenCV
+ * calls they replace, except fill_circle, whose edge pixels can differ from cvCircle's.
+ * Implementation in pixel_kernels.cpp, pixel_kernels_<isa>.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef PIXEL_KERNELS_H_
+#define PIXEL_KERNELS_H_
+
+#include "cv.h"
+#include "simd_dispatch.h"
+
+// one instruction set's row kernels, n pixels each, any alignment
+struct PixelKernels {
+	// hue [0,180] of interleaved bgr pixels, as bgr_to_hue_row (hue_kernel.h)
+	void (*hue_row)(const uchar *bgr, uchar *hue, int n);
+	// dst[i] = table[src[i]], table has 256 entries
+	void (*lut_row)(const uchar *src, uchar *dst, int n, const uchar *table);
+	// dst[i] = src[i] > thresh ? 255 : 0, thresh in [0,254]
+	void (*threshold_row)(const uchar *src, uchar *dst, int n, int thresh);
+	// dst[i] = min / max of a[i], b[i], c[i] -- the vertical half of a 3x3 erode / dilate
+	void (*min3_row)(const uchar *a, const uchar *b, const uchar *c, uchar *dst, int n);
+	void (*max3_row)(const uchar *a, const uchar *b, const uchar *c, uchar *dst, int n);
+	// dst[i] = min / max of src[i-1], src[i], src[i+1], the window clipped at the ends
+	// -- the horizontal half, dst must not overlap src
+	void (*hmin3_row)(const uchar *src, uchar *dst, int n);
+	void (*hmax3_row)(const uchar *src, uchar *dst, int n);
+	// n pixels of bgr into interleaved 3 channel dst
+	void (*fill_bgr_row)(uchar *dst, int n, const uchar *bgr);
+};
+
+// the kernels for simd_level()
+const PixelKernels& pixel_kernels();
+// the kernels for level, which must be supported -- for tests and benchmarks
+const PixelKernels& pixel_kernels_for(SimdLevel level);
+
+// src, dst -- 8 bit 1 channel, same size, may be the same image
+// same as cvThreshold(src, dst, thresh, 255, CV_THRESH_BINARY)
+void threshold_binary(const IplImage *src, IplImage *dst, int thresh);
+
+// mask -- 8 bit 1 channel, tmp -- scratch of the same size and type
+// same as cvMorphologyEx(mask, mask, 0, NULL, CV_MOP_OPEN, iterations) then the same
+// with CV_MOP_CLOSE, ie the default 3x3 rect with the border replicated
+void open_close_3x3(IplImage *mask, int iterations, IplImage *tmp);
+
+// src, dst -- 8 bit 1 channel, same size, dst[i] = table[src[i]]
+void lut_image(const IplImage *src, IplImage *dst, const uchar *table);
+
+// filled circle into an 8 bit 3 channel image, clipped to it -- the pixels whose
+// centre is within radius + 0.5 of center, rows filled a span at a time
+void fill_circle(IplImage *img, CvPoint center, int radius, CvScalar color);
+
+// the variants, each fills in the kernels it has and leaves the others
+// (simd_dispatch.cpp starts each level from the one below it)
+void fill_kernels_scalar(PixelKernels *k);
+void fill_kernels_sse2(PixelKernels *k);
+void fill_kernels_avx2(PixelKernels *k);
+// lut_row only if the cpu also has AVX512_VBMI, for the 256 entry byte lookup
+void fill_kernels_avx512(PixelKernels *k);
+void fill_kernels_neon(PixelKernels *k);
+
+// the scalar kernels, which the variants also use for their row tails
+void bgr_to_hue_row_scalar(const uchar *bgr, uchar *hue, int n);
+void lut_row_scalar(const uchar *src, uchar *dst, int n, const uchar *table);
+void threshold_row_scalar(const uchar *src, uchar *dst, int n, int thresh);
+void min3_row_scalar(const uchar *a, const uchar *b, const uchar *c, uchar *dst, int n);
+void max3_row_scalar(const uchar *a, const uchar *b, const uchar *c, uchar *dst, int n);
+void hmin3_row_scalar(const uchar *src, uchar *dst, int n);
+void hmax3_row_scalar(const uchar *src, uchar *dst, int n);
+// dst[from, n) of hmin3_row / hmax3_row on a row of n pixels
+void hmin3_span_scalar(const uchar *src, uchar *dst, int from, int n);
+void hmax3_span_scalar(const uchar *src, uchar *dst, int from, int n);
+void fill_bgr_row_scalar(uchar *dst, int n, const uchar *bgr);
+
+#endif /* PIXEL_KERNELS_H_ */
@@ -0,0 +1,184 @@
+/*
+ * pixel_kernels_avx2.cpp
+ *
+ * 32 pixels at a time, and the hue's reciprocal lookup as a gather.  Compiled for any
+ * x86 with a target attribute per function, only called once simd_dispatch has seen
+ * AVX2.  No lut_row -- a gather per 8 bytes is no faster than the scalar lookups.
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "pixel_kernels.h"
+#include "hue_kernel.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+#define AVX2_FN __attribute__((target("avx2")))
+
+// 16 interleaved bgr pixels into b, g, r planes, one pshufb per plane per register
+AVX2_FN static inline void deinterleave_bgr16(const uchar *p, __m128i &b, __m128i &g,
+		__m128i &r) {
+	__m128i s0 = _mm_loadu_si128((const __m128i *)p);
+	__m128i s1 = _mm_loadu_si128((const __m128i *)(p + 16));
+	__m128i s2 = _mm_loadu_si128((const __m128i *)(p + 32));
+	b = _mm_or_si128(_mm_or_si128(
+			_mm_shuffle_epi8(s0, _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+			_mm_shuffle_epi8(s1, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1))),
+			_mm_shuffle_epi8(s2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13)));
+	g = _mm_or_si128(_mm_or_si128(
+			_mm_shuffle_epi8(s0, _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+			_mm_shuffle_epi8(s1, _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1))),
+			_mm_shuffle_epi8(s2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14)));
+	r = _mm_or_si128(_mm_or_si128(
+			_mm_shuffle_epi8(s0, _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+			_mm_shuffle_epi8(s1, _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1))),
+			_mm_shuffle_epi8(s2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15)));
+}
+
+// hue of 8 pixels from their 32 bit numerators and diffs
+AVX2_FN static inline __m256i hue_from8(__m256i h, __m256i diff) {
+	__m256i recip = _mm256_i32gather_epi32(hue_hdiv_table, diff, 4);
+	h = _mm256_mullo_epi32(h, recip);
+	h = _mm256_srai_epi32(_mm256_add_epi32(h, _mm256_set1_epi32(1 << (HSV_SHIFT - 1))), HSV_SHIFT);
+	// negative hues wrap round by 180
+	__m256i wrap = _mm256_cmpgt_epi32(_mm256_setzero_si256(), h);
+	return _mm256_add_epi32(h, _mm256_and_si256(wrap, _mm256_set1_epi32(180)));
+}
+
+AVX2_FN static void hue_row_avx2(const uchar *bgr, uchar *hue, int n) {
+	int x = 0;
+	for(; x <= n - 16; x += 16, bgr += 48) {
+		__m128i b8, g8, r8;
+		deinterleave_bgr16(bgr, b8, g8, r8);
+		__m128i v8 = _mm_max_epu8(_mm_max_epu8(b8, g8), r8);
+		__m128i diff8 = _mm_sub_epi8(v8, _mm_min_epu8(_mm_min_epu8(b8, g8), r8));
+		__m128i vr8 = _mm_cmpeq_epi8(v8, r8);
+		__m128i vg8 = _mm_andnot_si128(vr8, _mm_cmpeq_epi8(v8, g8));
+
+		// the numerator select on all 16 widened to 16 bits, masks sign extended
+		__m256i b = _mm256_cvtepu8_epi16(b8), g = _mm256_cvtepu8_epi16(g8);
+		__m256i r = _mm256_cvtepu8_epi16(r8), diff = _mm256_cvtepu8_epi16(diff8);
+		__m256i vr = _mm256_cvtepi8_epi16(vr8), vg = _mm256_cvtepi8_epi16(vg8);
+		__m256i from_r = _mm256_sub_epi16(g, b);
+		__m256i from_g = _mm256_add_epi16(_mm256_sub_epi16(b, r), _mm256_slli_epi16(diff, 1));
+		__m256i from_b = _mm256_add_epi16(_mm256_sub_epi16(r, g), _mm256_slli_epi16(diff, 2));
+		__m256i h = _mm256_blendv_epi8(_mm256_blendv_epi8(from_b, from_g, vg), from_r, vr);
+
+		// 32 bits for the multiply, 8 lanes a half
+		__m256i lo = hue_from8(_mm256_cvtepi16_epi32(_mm256_castsi256_si128(h)),
+				_mm256_cvtepu8_epi32(diff8));
+		__m256i hi = hue_from8(_mm256_cvtepi16_epi32(_mm256_extracti128_si256(h, 1)),
+				_mm256_cvtepu8_epi32(_mm_srli_si128(diff8, 8)));
+		// packs work within 128 bit lanes, the permute puts the halves back in order
+		__m256i h16 = _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), 0xD8);
+		__m128i out = _mm_packus_epi16(_mm256_castsi256_si128(h16),
+				_mm256_extracti128_si256(h16, 1));
+		_mm_storeu_si128((__m128i *)(hue + x), out);
+	}
+	bgr_to_hue_row_scalar(bgr, hue + x, n - x);
+}
+
+AVX2_FN static void threshold_row_avx2(const uchar *src, uchar *dst, int n, int thresh) {
+	int x = 0;
+	__m256i t = _mm256_set1_epi8((char)thresh);
+	__m256i zero = _mm256_setzero_si256();
+	__m256i ones = _mm256_cmpeq_epi8(zero, zero);
+	for(; x <= n - 32; x += 32) {
+		// unsigned v > t is v - t saturating to non zero
+		__m256i v = _mm256_loadu_si256((const __m256i *)(src + x));
+		__m256i below = _mm256_cmpeq_epi8(_mm256_subs_epu8(v, t), zero);
+		_mm256_storeu_si256((__m256i *)(dst + x), _mm256_xor_si256(below, ones));
+	}
+	threshold_row_scalar(src + x, dst + x, n - x, thresh);
+}
+
+AVX2_FN static void min3_row_avx2(const uchar *a, const uchar *b, const uchar *c,
+		uchar *dst, int n) {
+	int x = 0;
+	for(; x <= n - 32; x += 32) {
+		__m256i v = _mm256_min_epu8(_mm256_loadu_si256((const __m256i *)(a + x)),
+				_mm256_loadu_si256((const __m256i *)(b + x)));
+		v = _mm256_min_epu8(v, _mm256_loadu_si256((const __m256i *)(c + x)));
+		_mm256_storeu_si256((__m256i *)(dst + x), v);
+	}
+	min3_row_scalar(a + x, b + x, c + x, dst + x, n - x);
+}
+
+AVX2_FN static void max3_row_avx2(const uchar *a, const uchar *b, const uchar *c,
+		uchar *dst, int n) {
+	int x = 0;
+	for(; x <= n - 32; x += 32) {
+		__m256i v = _mm256_max_epu8(_mm256_loadu_si256((const __m256i *)(a + x)),
+				_mm256_loadu_si256((const __m256i *)(b + x)));
+		v = _mm256_max_epu8(v, _mm256_loadu_si256((const __m256i *)(c + x)));
+		_mm256_storeu_si256((__m256i *)(dst + x), v);
+	}
+	max3_row_scalar(a + x, b + x, c + x, dst + x, n - x);
+}
+
+// the ends are scalar, the interior reads each pixel's neighbours with shifted loads
+AVX2_FN static void hmin3_row_avx2(const uchar *src, uchar *dst, int n) {
+	if(n < 34) {
+		hmin3_row_scalar(src, dst, n);
+		return;
+	}
+	dst[0] = src[0] < src[1] ? src[0] : src[1];
+	int x = 1;
+	for(; x <= n - 33; x += 32) {
+		__m256i v = _mm256_min_epu8(_mm256_loadu_si256((const __m256i *)(src + x - 1)),
+				_mm256_loadu_si256((const __m256i *)(src + x)));
+		v = _mm256_min_epu8(v, _mm256_loadu_si256((const __m256i *)(src + x + 1)));
+		_mm256_storeu_si256((__m256i *)(dst + x), v);
+	}
+	hmin3_span_scalar(src, dst, x, n);
+}
+
+AVX2_FN static void hmax3_row_avx2(const uchar *src, uchar *dst, int n) {
+	if(n < 34) {
+		hmax3_row_scalar(src, dst, n);
+		return;
+	}
+	dst[0] = src[0] > src[1] ? src[0] : src[1];
+	int x = 1;
+	for(; x <= n - 33; x += 32) {
+		__m256i v = _mm256_max_epu8(_mm256_loadu_si256((const __m256i *)(src + x - 1)),
+				_mm256_loadu_si256((const __m256i *)(src + x)));
+		v = _mm256_max_epu8(v, _mm256_loadu_si256((const __m256i *)(src + x + 1)));
+		_mm256_storeu_si256((__m256i *)(dst + x), v);
+	}
+	hmax3_span_scalar(src, dst, x, n);
+}
+
+// 32 pixels are 96 bytes, three registers of the repeating pattern
+AVX2_FN static void fill_bgr_row_avx2(uchar *dst, int n, const uchar *bgr) {
+	uchar pattern[96];
+	fill_bgr_row_scalar(pattern, 32, bgr);
+	__m256i p0 = _mm256_loadu_si256((const __m256i *)pattern);
+	__m256i p1 = _mm256_loadu_si256((const __m256i *)(pattern + 32));
+	__m256i p2 = _mm256_loadu_si256((const __m256i *)(pattern + 64));
+	int x = 0;
+	for(; x <= n - 32; x += 32, dst += 96) {
+		_mm256_storeu_si256((__m256i *)dst, p0);
+		_mm256_storeu_si256((__m256i *)(dst + 32), p1);
+		_mm256_storeu_si256((__m256i *)(dst + 64), p2);
+	}
+	fill_bgr_row_scalar(dst, n - x, bgr);
+}
+
+void fill_kernels_avx2(PixelKernels *k) {
+	k->hue_row = hue_row_avx2;
+	k->threshold_row = threshold_row_avx2;
+	k->min3_row = min3_row_avx2;
+	k->max3_row = max3_row_avx2;
+	k->hmin3_row = hmin3_row_avx2;
+	k->hmax3_row = hmax3_row_avx2;
+	k->fill_bgr_row = fill_bgr_row_avx2;
+}
+
+#else
+
+void fill_kernels_avx2(PixelKernels *) {}
+
+#endif
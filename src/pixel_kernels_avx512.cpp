@@ -0,0 +1,208 @@
+/*
+ * pixel_kernels_avx512.cpp
+ *
+ * 64 pixels at a time with AVX-512 F + BW + VL, the row tails through masked loads and
+ * stores rather than scalar loops.  lut_row needs VBMI as well: its two register
+ * byte permute looks up 128 table entries at once, two of them and a blend on the
+ * index's top bit cover all 256.  Compiled for any x86 with a target attribute per
+ * function, only called once simd_dispatch has seen the features.
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "pixel_kernels.h"
+#include "hue_kernel.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+// gcc 12 warns about the deliberately undefined registers inside its own avx512 headers
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+#define AVX512_FN __attribute__((target("avx2,avx512f,avx512bw,avx512vl")))
+#define AVX512_VBMI_FN __attribute__((target("avx2,avx512f,avx512bw,avx512vl,avx512vbmi")))
+
+// lanes [0, n) of a 64 byte register, n <= 64
+AVX512_FN static inline __mmask64 first_n(int n) {
+	return n >= 64 ? ~(__mmask64)0 : ((__mmask64)1 << n) - 1;
+}
+
+// 16 interleaved bgr pixels into b, g, r planes, one pshufb per plane per register
+AVX512_FN static inline void deinterleave_bgr16(const uchar *p, __m128i &b, __m128i &g,
+		__m128i &r) {
+	__m128i s0 = _mm_loadu_si128((const __m128i *)p);
+	__m128i s1 = _mm_loadu_si128((const __m128i *)(p + 16));
+	__m128i s2 = _mm_loadu_si128((const __m128i *)(p + 32));
+	b = _mm_or_si128(_mm_or_si128(
+			_mm_shuffle_epi8(s0, _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+			_mm_shuffle_epi8(s1, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1))),
+			_mm_shuffle_epi8(s2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13)));
+	g = _mm_or_si128(_mm_or_si128(
+			_mm_shuffle_epi8(s0, _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+			_mm_shuffle_epi8(s1, _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1))),
+			_mm_shuffle_epi8(s2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14)));
+	r = _mm_or_si128(_mm_or_si128(
+			_mm_shuffle_epi8(s0, _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+			_mm_shuffle_epi8(s1, _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1))),
+			_mm_shuffle_epi8(s2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15)));
+}
+
+// hue of 16 pixels from their 32 bit numerators and diffs, narrowed to bytes
+AVX512_FN static inline __m128i hue_from16(__m512i h, __m512i diff) {
+	__m512i recip = _mm512_i32gather_epi32(diff, hue_hdiv_table, 4);
+	h = _mm512_mullo_epi32(h, recip);
+	h = _mm512_srai_epi32(_mm512_add_epi32(h, _mm512_set1_epi32(1 << (HSV_SHIFT - 1))), HSV_SHIFT);
+	// negative hues wrap round by 180
+	__mmask16 wrap = _mm512_cmplt_epi32_mask(h, _mm512_setzero_si512());
+	h = _mm512_mask_add_epi32(h, wrap, h, _mm512_set1_epi32(180));
+	return _mm512_cvtepi32_epi8(h);
+}
+
+// 32 pixels at a time: planes of 32 bytes, numerators in 32 16 bit lanes, then two
+// gathers of 16
+AVX512_FN static void hue_row_avx512(const uchar *bgr, uchar *hue, int n) {
+	int x = 0;
+	for(; x <= n - 32; x += 32, bgr += 96) {
+		__m128i b0, g0, r0, b1, g1, r1;
+		deinterleave_bgr16(bgr, b0, g0, r0);
+		deinterleave_bgr16(bgr + 48, b1, g1, r1);
+		__m256i b8 = _mm256_inserti128_si256(_mm256_castsi128_si256(b0), b1, 1);
+		__m256i g8 = _mm256_inserti128_si256(_mm256_castsi128_si256(g0), g1, 1);
+		__m256i r8 = _mm256_inserti128_si256(_mm256_castsi128_si256(r0), r1, 1);
+		__m256i v8 = _mm256_max_epu8(_mm256_max_epu8(b8, g8), r8);
+		__m256i diff8 = _mm256_sub_epi8(v8, _mm256_min_epu8(_mm256_min_epu8(b8, g8), r8));
+		__mmask32 vr = _mm256_cmpeq_epi8_mask(v8, r8);
+		__mmask32 vg = _mm256_cmpeq_epi8_mask(v8, g8) & ~vr;
+
+		__m512i b = _mm512_cvtepu8_epi16(b8), g = _mm512_cvtepu8_epi16(g8);
+		__m512i r = _mm512_cvtepu8_epi16(r8), diff = _mm512_cvtepu8_epi16(diff8);
+		__m512i h = _mm512_add_epi16(_mm512_sub_epi16(r, g), _mm512_slli_epi16(diff, 2));
+		h = _mm512_mask_mov_epi16(h, vg,
+				_mm512_add_epi16(_mm512_sub_epi16(b, r), _mm512_slli_epi16(diff, 1)));
+		h = _mm512_mask_mov_epi16(h, vr, _mm512_sub_epi16(g, b));
+
+		__m128i lo = hue_from16(_mm512_cvtepi16_epi32(_mm512_castsi512_si256(h)),
+				_mm512_cvtepu8_epi32(_mm256_castsi256_si128(diff8)));
+		__m128i hi = hue_from16(_mm512_cvtepi16_epi32(_mm512_extracti64x4_epi64(h, 1)),
+				_mm512_cvtepu8_epi32(_mm256_extracti128_si256(diff8, 1)));
+		_mm_storeu_si128((__m128i *)(hue + x), lo);
+		_mm_storeu_si128((__m128i *)(hue + x + 16), hi);
+	}
+	bgr_to_hue_row_scalar(bgr, hue + x, n - x);
+}
+
+AVX512_VBMI_FN static void lut_row_avx512(const uchar *src, uchar *dst, int n,
+		const uchar *table) {
+	__m512i t0 = _mm512_loadu_si512(table);
+	__m512i t1 = _mm512_loadu_si512(table + 64);
+	__m512i t2 = _mm512_loadu_si512(table + 128);
+	__m512i t3 = _mm512_loadu_si512(table + 192);
+	for(int x=0; x<n; x+=64) {
+		__mmask64 m = first_n(n - x);
+		__m512i idx = _mm512_maskz_loadu_epi8(m, src + x);
+		// index bits 0-6 pick from the pair, bit 7 picks the pair
+		__m512i lo = _mm512_permutex2var_epi8(t0, idx, t1);
+		__m512i hi = _mm512_permutex2var_epi8(t2, idx, t3);
+		__m512i v = _mm512_mask_blend_epi8(_mm512_movepi8_mask(idx), lo, hi);
+		_mm512_mask_storeu_epi8(dst + x, m, v);
+	}
+}
+
+AVX512_FN static void threshold_row_avx512(const uchar *src, uchar *dst, int n, int thresh) {
+	__m512i t = _mm512_set1_epi8((char)thresh);
+	for(int x=0; x<n; x+=64) {
+		__mmask64 m = first_n(n - x);
+		__m512i v = _mm512_maskz_loadu_epi8(m, src + x);
+		_mm512_mask_storeu_epi8(dst + x, m, _mm512_movm_epi8(_mm512_cmpgt_epu8_mask(v, t)));
+	}
+}
+
+AVX512_FN static void min3_row_avx512(const uchar *a, const uchar *b, const uchar *c,
+		uchar *dst, int n) {
+	for(int x=0; x<n; x+=64) {
+		__mmask64 m = first_n(n - x);
+		__m512i v = _mm512_min_epu8(_mm512_maskz_loadu_epi8(m, a + x),
+				_mm512_maskz_loadu_epi8(m, b + x));
+		v = _mm512_min_epu8(v, _mm512_maskz_loadu_epi8(m, c + x));
+		_mm512_mask_storeu_epi8(dst + x, m, v);
+	}
+}
+
+AVX512_FN static void max3_row_avx512(const uchar *a, const uchar *b, const uchar *c,
+		uchar *dst, int n) {
+	for(int x=0; x<n; x+=64) {
+		__mmask64 m = first_n(n - x);
+		__m512i v = _mm512_max_epu8(_mm512_maskz_loadu_epi8(m, a + x),
+				_mm512_maskz_loadu_epi8(m, b + x));
+		v = _mm512_max_epu8(v, _mm512_maskz_loadu_epi8(m, c + x));
+		_mm512_mask_storeu_epi8(dst + x, m, v);
+	}
+}
+
+// the ends are scalar, the interior reads each pixel's neighbours with shifted loads
+AVX512_FN static void hmin3_row_avx512(const uchar *src, uchar *dst, int n) {
+	if(n < 66) {
+		hmin3_row_scalar(src, dst, n);
+		return;
+	}
+	dst[0] = src[0] < src[1] ? src[0] : src[1];
+	int x = 1;
+	for(; x <= n - 65; x += 64) {
+		__m512i v = _mm512_min_epu8(_mm512_loadu_si512(src + x - 1), _mm512_loadu_si512(src + x));
+		v = _mm512_min_epu8(v, _mm512_loadu_si512(src + x + 1));
+		_mm512_storeu_si512(dst + x, v);
+	}
+	hmin3_span_scalar(src, dst, x, n);
+}
+
+AVX512_FN static void hmax3_row_avx512(const uchar *src, uchar *dst, int n) {
+	if(n < 66) {
+		hmax3_row_scalar(src, dst, n);
+		return;
+	}
+	dst[0] = src[0] > src[1] ? src[0] : src[1];
+	int x = 1;
+	for(; x <= n - 65; x += 64) {
+		__m512i v = _mm512_max_epu8(_mm512_loadu_si512(src + x - 1), _mm512_loadu_si512(src + x));
+		v = _mm512_max_epu8(v, _mm512_loadu_si512(src + x + 1));
+		_mm512_storeu_si512(dst + x, v);
+	}
+	hmax3_span_scalar(src, dst, x, n);
+}
+
+// 64 pixels are 192 bytes, three registers of the repeating pattern
+AVX512_FN static void fill_bgr_row_avx512(uchar *dst, int n, const uchar *bgr) {
+	uchar pattern[192];
+	fill_bgr_row_scalar(pattern, 64, bgr);
+	__m512i p0 = _mm512_loadu_si512(pattern);
+	__m512i p1 = _mm512_loadu_si512(pattern + 64);
+	__m512i p2 = _mm512_loadu_si512(pattern + 128);
+	int x = 0;
+	for(; x <= n - 64; x += 64, dst += 192) {
+		_mm512_storeu_si512(dst, p0);
+		_mm512_storeu_si512(dst + 64, p1);
+		_mm512_storeu_si512(dst + 128, p2);
+	}
+	fill_bgr_row_scalar(dst, n - x, bgr);
+}
+
+void fill_kernels_avx512(PixelKernels *k) {
+	k->hue_row = hue_row_avx512;
+	k->threshold_row = threshold_row_avx512;
+	k->min3_row = min3_row_avx512;
+	k->max3_row = max3_row_avx512;
+	k->hmin3_row = hmin3_row_avx512;
+	k->hmax3_row = hmax3_row_avx512;
+	k->fill_bgr_row = fill_bgr_row_avx512;
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx512vbmi")) {
+		k->lut_row = lut_row_avx512;
+	}
+}
+
+#else
+
+void fill_kernels_avx512(PixelKernels *) {}
+
+#endif
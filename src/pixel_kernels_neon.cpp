@@ -0,0 +1,172 @@
+/*
+ * pixel_kernels_neon.cpp
+ *
+ * 16 pixels at a time with AArch64 NEON, which every armv8-a core has.  Interleaved
+ * bgr comes apart and goes back together with the structure loads and stores
+ * (vld3q / vst3q), and lut_row does the 256 entry table as four 64 byte lookups
+ * (vqtbl4q / vqtbx4q), an out of range index leaving the byte alone.  32 bit ARM
+ * builds have no NEON variant, they run the scalar kernels.
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "pixel_kernels.h"
+#include "hue_kernel.h"
+
+#if defined(__aarch64__)
+
+#include <arm_neon.h>
+
+// hue numerators for 8 pixels widened to 16 bits, masks are 0 / 0xff per lane
+static inline int16x8_t select_numerator(uint8x8_t b8, uint8x8_t g8, uint8x8_t r8,
+		uint8x8_t diff8, uint8x8_t vr8, uint8x8_t vg8) {
+	int16x8_t b = vreinterpretq_s16_u16(vmovl_u8(b8));
+	int16x8_t g = vreinterpretq_s16_u16(vmovl_u8(g8));
+	int16x8_t r = vreinterpretq_s16_u16(vmovl_u8(r8));
+	int16x8_t diff = vreinterpretq_s16_u16(vmovl_u8(diff8));
+	// sign extended so the masks stay all ones
+	uint16x8_t vr = vreinterpretq_u16_s16(vmovl_s8(vreinterpret_s8_u8(vr8)));
+	uint16x8_t vg = vreinterpretq_u16_s16(vmovl_s8(vreinterpret_s8_u8(vg8)));
+	int16x8_t from_r = vsubq_s16(g, b);
+	int16x8_t from_g = vaddq_s16(vsubq_s16(b, r), vshlq_n_s16(diff, 1));
+	int16x8_t from_b = vaddq_s16(vsubq_s16(r, g), vshlq_n_s16(diff, 2));
+	return vbslq_s16(vr, from_r, vbslq_s16(vg, from_g, from_b));
+}
+
+static void hue_row_neon(const uchar *bgr, uchar *hue, int n) {
+	int x = 0;
+	short h16[16];
+	uchar d8[16];
+	for(; x <= n - 16; x += 16, bgr += 48) {
+		uint8x16x3_t px = vld3q_u8(bgr);
+		uint8x16_t b = px.val[0], g = px.val[1], r = px.val[2];
+		uint8x16_t v = vmaxq_u8(vmaxq_u8(b, g), r);
+		uint8x16_t diff = vsubq_u8(v, vminq_u8(vminq_u8(b, g), r));
+		uint8x16_t vr = vceqq_u8(v, r);
+		uint8x16_t vg = vbicq_u8(vceqq_u8(v, g), vr);
+
+		vst1q_s16(h16, select_numerator(vget_low_u8(b), vget_low_u8(g), vget_low_u8(r),
+				vget_low_u8(diff), vget_low_u8(vr), vget_low_u8(vg)));
+		vst1q_s16(h16 + 8, select_numerator(vget_high_u8(b), vget_high_u8(g),
+				vget_high_u8(r), vget_high_u8(diff), vget_high_u8(vr), vget_high_u8(vg)));
+		vst1q_u8(d8, diff);
+
+		// no gather, the reciprocal lookup and multiply go lane by lane
+		for(int i=0; i<16; i++) {
+			hue[x + i] = hue_from(h16[i], d8[i]);
+		}
+	}
+	bgr_to_hue_row_scalar(bgr, hue + x, n - x);
+}
+
+static void lut_row_neon(const uchar *src, uchar *dst, int n, const uchar *table) {
+	uint8x16x4_t t[4];
+	for(int q=0; q<4; q++) {
+		for(int i=0; i<4; i++) {
+			t[q].val[i] = vld1q_u8(table + 64 * q + 16 * i);
+		}
+	}
+	uint8x16_t step = vdupq_n_u8(64);
+	int x = 0;
+	for(; x <= n - 16; x += 16) {
+		// each quarter of the table sees the index moved down 64 further, so only the
+		// quarter the index falls in has it in range
+		uint8x16_t idx = vld1q_u8(src + x);
+		uint8x16_t v = vqtbl4q_u8(t[0], idx);
+		idx = vsubq_u8(idx, step);
+		v = vqtbx4q_u8(v, t[1], idx);
+		idx = vsubq_u8(idx, step);
+		v = vqtbx4q_u8(v, t[2], idx);
+		idx = vsubq_u8(idx, step);
+		v = vqtbx4q_u8(v, t[3], idx);
+		vst1q_u8(dst + x, v);
+	}
+	lut_row_scalar(src + x, dst + x, n - x, table);
+}
+
+static void threshold_row_neon(const uchar *src, uchar *dst, int n, int thresh) {
+	uint8x16_t t = vdupq_n_u8((uchar)thresh);
+	int x = 0;
+	for(; x <= n - 16; x += 16) {
+		vst1q_u8(dst + x, vcgtq_u8(vld1q_u8(src + x), t));
+	}
+	threshold_row_scalar(src + x, dst + x, n - x, thresh);
+}
+
+static void min3_row_neon(const uchar *a, const uchar *b, const uchar *c,
+		uchar *dst, int n) {
+	int x = 0;
+	for(; x <= n - 16; x += 16) {
+		uint8x16_t v = vminq_u8(vminq_u8(vld1q_u8(a + x), vld1q_u8(b + x)), vld1q_u8(c + x));
+		vst1q_u8(dst + x, v);
+	}
+	min3_row_scalar(a + x, b + x, c + x, dst + x, n - x);
+}
+
+static void max3_row_neon(const uchar *a, const uchar *b, const uchar *c,
+		uchar *dst, int n) {
+	int x = 0;
+	for(; x <= n - 16; x += 16) {
+		uint8x16_t v = vmaxq_u8(vmaxq_u8(vld1q_u8(a + x), vld1q_u8(b + x)), vld1q_u8(c + x));
+		vst1q_u8(dst + x, v);
+	}
+	max3_row_scalar(a + x, b + x, c + x, dst + x, n - x);
+}
+
+// the ends are scalar, the interior reads each pixel's neighbours with shifted loads
+static void hmin3_row_neon(const uchar *src, uchar *dst, int n) {
+	if(n < 18) {
+		hmin3_row_scalar(src, dst, n);
+		return;
+	}
+	dst[0] = src[0] < src[1] ? src[0] : src[1];
+	int x = 1;
+	for(; x <= n - 17; x += 16) {
+		uint8x16_t v = vminq_u8(vld1q_u8(src + x - 1), vld1q_u8(src + x));
+		vst1q_u8(dst + x, vminq_u8(v, vld1q_u8(src + x + 1)));
+	}
+	hmin3_span_scalar(src, dst, x, n);
+}
+
+static void hmax3_row_neon(const uchar *src, uchar *dst, int n) {
+	if(n < 18) {
+		hmax3_row_scalar(src, dst, n);
+		return;
+	}
+	dst[0] = src[0] > src[1] ? src[0] : src[1];
+	int x = 1;
+	for(; x <= n - 17; x += 16) {
+		uint8x16_t v = vmaxq_u8(vld1q_u8(src + x - 1), vld1q_u8(src + x));
+		vst1q_u8(dst + x, vmaxq_u8(v, vld1q_u8(src + x + 1)));
+	}
+	hmax3_span_scalar(src, dst, x, n);
+}
+
+static void fill_bgr_row_neon(uchar *dst, int n, const uchar *bgr) {
+	uint8x16x3_t px;
+	px.val[0] = vdupq_n_u8(bgr[0]);
+	px.val[1] = vdupq_n_u8(bgr[1]);
+	px.val[2] = vdupq_n_u8(bgr[2]);
+	int x = 0;
+	for(; x <= n - 16; x += 16, dst += 48) {
+		vst3q_u8(dst, px);
+	}
+	fill_bgr_row_scalar(dst, n - x, bgr);
+}
+
+void fill_kernels_neon(PixelKernels *k) {
+	k->hue_row = hue_row_neon;
+	k->lut_row = lut_row_neon;
+	k->threshold_row = threshold_row_neon;
+	k->min3_row = min3_row_neon;
+	k->max3_row = max3_row_neon;
+	k->hmin3_row = hmin3_row_neon;
+	k->hmax3_row = hmax3_row_neon;
+	k->fill_bgr_row = fill_bgr_row_neon;
+}
+
+#else
+
+void fill_kernels_neon(PixelKernels *) {}
+
+#endif
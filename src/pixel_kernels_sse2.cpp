@@ -0,0 +1,186 @@
+/*
+ * pixel_kernels_sse2.cpp
+ *
+ * 16 pixels at a time.  Compiled for any x86 with a target attribute per function,
+ * only called once simd_dispatch has seen SSE2.
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "pixel_kernels.h"
+#include "hue_kernel.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <emmintrin.h>
+
+#define SSE2_FN __attribute__((target("sse2")))
+
+// 16 interleaved bgr pixels into b, g, r planes, unpacks only (no pshufb in SSE2)
+SSE2_FN static inline void deinterleave_bgr(const uchar *p, __m128i &b, __m128i &g,
+		__m128i &r) {
+	__m128i t00 = _mm_loadu_si128((const __m128i *)p);
+	__m128i t01 = _mm_loadu_si128((const __m128i *)(p + 16));
+	__m128i t02 = _mm_loadu_si128((const __m128i *)(p + 32));
+
+	__m128i t10 = _mm_unpacklo_epi8(t00, _mm_unpackhi_epi64(t01, t01));
+	__m128i t11 = _mm_unpacklo_epi8(_mm_unpackhi_epi64(t00, t00), t02);
+	__m128i t12 = _mm_unpacklo_epi8(t01, _mm_unpackhi_epi64(t02, t02));
+
+	__m128i t20 = _mm_unpacklo_epi8(t10, _mm_unpackhi_epi64(t11, t11));
+	__m128i t21 = _mm_unpacklo_epi8(_mm_unpackhi_epi64(t10, t10), t12);
+	__m128i t22 = _mm_unpacklo_epi8(t11, _mm_unpackhi_epi64(t12, t12));
+
+	__m128i t30 = _mm_unpacklo_epi8(t20, _mm_unpackhi_epi64(t21, t21));
+	__m128i t31 = _mm_unpacklo_epi8(_mm_unpackhi_epi64(t20, t20), t22);
+	__m128i t32 = _mm_unpacklo_epi8(t21, _mm_unpackhi_epi64(t22, t22));
+
+	b = _mm_unpacklo_epi8(t30, _mm_unpackhi_epi64(t31, t31));
+	g = _mm_unpacklo_epi8(_mm_unpackhi_epi64(t30, t30), t32);
+	r = _mm_unpacklo_epi8(t31, _mm_unpackhi_epi64(t32, t32));
+}
+
+// hue numerators for 8 pixels widened to 16 bits, masks are 0 / -1 per lane
+SSE2_FN static inline __m128i select_numerator(__m128i b, __m128i g, __m128i r,
+		__m128i diff, __m128i vr, __m128i vg) {
+	__m128i from_r = _mm_sub_epi16(g, b);
+	__m128i from_g = _mm_add_epi16(_mm_sub_epi16(b, r), _mm_slli_epi16(diff, 1));
+	__m128i from_b = _mm_add_epi16(_mm_sub_epi16(r, g), _mm_slli_epi16(diff, 2));
+	__m128i not_r = _mm_or_si128(_mm_and_si128(vg, from_g), _mm_andnot_si128(vg, from_b));
+	return _mm_or_si128(_mm_and_si128(vr, from_r), _mm_andnot_si128(vr, not_r));
+}
+
+SSE2_FN static void hue_row_sse2(const uchar *bgr, uchar *hue, int n) {
+	int x = 0;
+	__m128i zero = _mm_setzero_si128();
+	short h16[16];
+	uchar d8[16];
+	for(; x <= n - 16; x += 16, bgr += 48) {
+		__m128i b, g, r;
+		deinterleave_bgr(bgr, b, g, r);
+		__m128i v = _mm_max_epu8(_mm_max_epu8(b, g), r);
+		__m128i diff = _mm_sub_epi8(v, _mm_min_epu8(_mm_min_epu8(b, g), r));
+		__m128i vr = _mm_cmpeq_epi8(v, r);
+		__m128i vg = _mm_andnot_si128(vr, _mm_cmpeq_epi8(v, g));
+
+		// widened, masks unpack with themselves to stay 0 / -1
+		__m128i lo = select_numerator(_mm_unpacklo_epi8(b, zero), _mm_unpacklo_epi8(g, zero),
+				_mm_unpacklo_epi8(r, zero), _mm_unpacklo_epi8(diff, zero),
+				_mm_unpacklo_epi8(vr, vr), _mm_unpacklo_epi8(vg, vg));
+		__m128i hi = select_numerator(_mm_unpackhi_epi8(b, zero), _mm_unpackhi_epi8(g, zero),
+				_mm_unpackhi_epi8(r, zero), _mm_unpackhi_epi8(diff, zero),
+				_mm_unpackhi_epi8(vr, vr), _mm_unpackhi_epi8(vg, vg));
+		_mm_storeu_si128((__m128i *)h16, lo);
+		_mm_storeu_si128((__m128i *)(h16 + 8), hi);
+		_mm_storeu_si128((__m128i *)d8, diff);
+
+		// no gather in SSE2, the reciprocal lookup and multiply go lane by lane
+		for(int i=0; i<16; i++) {
+			hue[x + i] = hue_from(h16[i], d8[i]);
+		}
+	}
+	bgr_to_hue_row_scalar(bgr, hue + x, n - x);
+}
+
+SSE2_FN static void threshold_row_sse2(const uchar *src, uchar *dst, int n, int thresh) {
+	int x = 0;
+	__m128i t = _mm_set1_epi8((char)thresh);
+	__m128i zero = _mm_setzero_si128();
+	__m128i ones = _mm_cmpeq_epi8(zero, zero);
+	for(; x <= n - 16; x += 16) {
+		// unsigned v > t is v - t saturating to non zero
+		__m128i v = _mm_loadu_si128((const __m128i *)(src + x));
+		__m128i below = _mm_cmpeq_epi8(_mm_subs_epu8(v, t), zero);
+		_mm_storeu_si128((__m128i *)(dst + x), _mm_xor_si128(below, ones));
+	}
+	threshold_row_scalar(src + x, dst + x, n - x, thresh);
+}
+
+SSE2_FN static void min3_row_sse2(const uchar *a, const uchar *b, const uchar *c,
+		uchar *dst, int n) {
+	int x = 0;
+	for(; x <= n - 16; x += 16) {
+		__m128i v = _mm_min_epu8(_mm_loadu_si128((const __m128i *)(a + x)),
+				_mm_loadu_si128((const __m128i *)(b + x)));
+		v = _mm_min_epu8(v, _mm_loadu_si128((const __m128i *)(c + x)));
+		_mm_storeu_si128((__m128i *)(dst + x), v);
+	}
+	min3_row_scalar(a + x, b + x, c + x, dst + x, n - x);
+}
+
+SSE2_FN static void max3_row_sse2(const uchar *a, const uchar *b, const uchar *c,
+		uchar *dst, int n) {
+	int x = 0;
+	for(; x <= n - 16; x += 16) {
+		__m128i v = _mm_max_epu8(_mm_loadu_si128((const __m128i *)(a + x)),
+				_mm_loadu_si128((const __m128i *)(b + x)));
+		v = _mm_max_epu8(v, _mm_loadu_si128((const __m128i *)(c + x)));
+		_mm_storeu_si128((__m128i *)(dst + x), v);
+	}
+	max3_row_scalar(a + x, b + x, c + x, dst + x, n - x);
+}
+
+// the ends are scalar, the interior reads each pixel's neighbours with shifted loads
+SSE2_FN static void hmin3_row_sse2(const uchar *src, uchar *dst, int n) {
+	if(n < 18) {
+		hmin3_row_scalar(src, dst, n);
+		return;
+	}
+	dst[0] = src[0] < src[1] ? src[0] : src[1];
+	int x = 1;
+	for(; x <= n - 17; x += 16) {
+		__m128i v = _mm_min_epu8(_mm_loadu_si128((const __m128i *)(src + x - 1)),
+				_mm_loadu_si128((const __m128i *)(src + x)));
+		v = _mm_min_epu8(v, _mm_loadu_si128((const __m128i *)(src + x + 1)));
+		_mm_storeu_si128((__m128i *)(dst + x), v);
+	}
+	hmin3_span_scalar(src, dst, x, n);
+}
+
+SSE2_FN static void hmax3_row_sse2(const uchar *src, uchar *dst, int n) {
+	if(n < 18) {
+		hmax3_row_scalar(src, dst, n);
+		return;
+	}
+	dst[0] = src[0] > src[1] ? src[0] : src[1];
+	int x = 1;
+	for(; x <= n - 17; x += 16) {
+		__m128i v = _mm_max_epu8(_mm_loadu_si128((const __m128i *)(src + x - 1)),
+				_mm_loadu_si128((const __m128i *)(src + x)));
+		v = _mm_max_epu8(v, _mm_loadu_si128((const __m128i *)(src + x + 1)));
+		_mm_storeu_si128((__m128i *)(dst + x), v);
+	}
+	hmax3_span_scalar(src, dst, x, n);
+}
+
+// 16 pixels are 48 bytes, three registers of the repeating pattern
+SSE2_FN static void fill_bgr_row_sse2(uchar *dst, int n, const uchar *bgr) {
+	uchar pattern[48];
+	fill_bgr_row_scalar(pattern, 16, bgr);
+	__m128i p0 = _mm_loadu_si128((const __m128i *)pattern);
+	__m128i p1 = _mm_loadu_si128((const __m128i *)(pattern + 16));
+	__m128i p2 = _mm_loadu_si128((const __m128i *)(pattern + 32));
+	int x = 0;
+	for(; x <= n - 16; x += 16, dst += 48) {
+		_mm_storeu_si128((__m128i *)dst, p0);
+		_mm_storeu_si128((__m128i *)(dst + 16), p1);
+		_mm_storeu_si128((__m128i *)(dst + 32), p2);
+	}
+	fill_bgr_row_scalar(dst, n - x, bgr);
+}
+
+void fill_kernels_sse2(PixelKernels *k) {
+	k->hue_row = hue_row_sse2;
+	k->threshold_row = threshold_row_sse2;
+	k->min3_row = min3_row_sse2;
+	k->max3_row = max3_row_sse2;
+	k->hmin3_row = hmin3_row_sse2;
+	k->hmax3_row = hmax3_row_sse2;
+	k->fill_bgr_row = fill_bgr_row_sse2;
+}
+
+#else
+
+void fill_kernels_sse2(PixelKernels *) {}
+
+#endif
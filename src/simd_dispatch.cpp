@@ -0,0 +1,129 @@
+/*
+ * simd_dispatch.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "simd_dispatch.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <pthread.h>
+
+//******* linux only for hwcaps
+#if defined(__aarch64__) && defined(__linux__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+static const char *level_names[NUM_SIMD_LEVELS] = {
+	"scalar", "sse2", "avx2", "avx512", "neon"
+};
+
+const char* simd_level_name(SimdLevel level) {
+	return level >= 0 && level < NUM_SIMD_LEVELS ? level_names[level] : "?";
+}
+
+bool parse_simd_level(const char *name, SimdLevel *level) {
+	for(int i=0; i<NUM_SIMD_LEVELS; i++) {
+		if(strcmp(name, level_names[i]) == 0) {
+			*level = (SimdLevel)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool simd_supported(SimdLevel level) {
+	switch(level) {
+	case SIMD_SCALAR:
+		return true;
+#if defined(__x86_64__) || defined(__i386__)
+	// checks the OS saves the wider registers too, not just cpuid
+	case SIMD_SSE2:
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("sse2");
+	case SIMD_AVX2:
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2");
+	case SIMD_AVX512:
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+				__builtin_cpu_supports("avx512vl");
+#endif
+#if defined(__aarch64__)
+	case SIMD_NEON:
+#if defined(__linux__)
+		return (getauxval(AT_HWCAP) & HWCAP_ASIMD) != 0;
+#else
+		// part of armv8-a
+		return true;
+#endif
+#endif
+	default:
+		return false;
+	}
+}
+
+// where a level falls back to when the machine can't run it
+static SimdLevel level_below(SimdLevel level) {
+	switch(level) {
+	case SIMD_AVX512:
+		return SIMD_AVX2;
+	case SIMD_AVX2:
+		return SIMD_SSE2;
+	default:
+		return SIMD_SCALAR;
+	}
+}
+
+SimdLevel simd_best() {
+	SimdLevel best = SIMD_SCALAR;
+	for(int i=0; i<NUM_SIMD_LEVELS; i++) {
+		if(simd_supported((SimdLevel)i)) {
+			best = (SimdLevel)i;
+		}
+	}
+	return best;
+}
+
+static SimdLevel supported_at_or_below(SimdLevel level) {
+	while(!simd_supported(level)) {
+		level = level_below(level);
+	}
+	return level;
+}
+
+static SimdLevel active_level = SIMD_SCALAR;
+static pthread_once_t active_level_once = PTHREAD_ONCE_INIT;
+
+static void choose_level() {
+	active_level = simd_best();
+	const char *forced = getenv("FINGERSHOOTER_SIMD");
+	if(!forced || !*forced) {
+		return;
+	}
+	SimdLevel level;
+	if(!parse_simd_level(forced, &level)) {
+		fprintf(stderr, "FINGERSHOOTER_SIMD: no level %s (scalar, sse2, avx2, avx512, neon), "
+				"using %s\n", forced, simd_level_name(active_level));
+		return;
+	}
+	active_level = supported_at_or_below(level);
+	if(active_level != level) {
+		fprintf(stderr, "FINGERSHOOTER_SIMD: %s not supported here, using %s\n",
+				simd_level_name(level), simd_level_name(active_level));
+	}
+}
+
+SimdLevel simd_level() {
+	pthread_once(&active_level_once, choose_level);
+	return active_level;
+}
+
+SimdLevel set_simd_level(SimdLevel level) {
+	pthread_once(&active_level_once, choose_level);
+	active_level = supported_at_or_below(level);
+	return active_level;
+}
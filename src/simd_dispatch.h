@@ -0,0 +1,44 @@
+/*
+ * simd_dispatch.h
+ *
+ * Picks the instruction set the per-pixel kernels (pixel_kernels.h) run with, once, at
+ * first use: the best the CPU and OS support -- cpuid on x86 (SSE2, AVX2, AVX-512 with
+ * BW and VL), hwcaps on 64 bit ARM (NEON) -- so one binary runs everywhere at the
+ * speed each box allows.  Every x86 variant is compiled into every x86 build, and the
+ * NEON one into every aarch64 build, with per function target attributes rather than
+ * -m flags, so nothing outside the variant files assumes more than the baseline.
+ *
+ * 	FINGERSHOOTER_SIMD=scalar|sse2|avx2|avx512|neon
+ *
+ * in the environment forces a level, eg to A/B benchmark the same binary; a level the
+ * machine can't run falls back to the best one below it, with a warning.  The scalar
+ * kernels are the reference the others are tested against, see test_pixel_kernels()
+ * in benchmarks.cpp.
+ * Implementation in simd_dispatch.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SIMD_DISPATCH_H_
+#define SIMD_DISPATCH_H_
+
+// in fallback order, each x86 level implies the ones before it
+enum SimdLevel { SIMD_SCALAR, SIMD_SSE2, SIMD_AVX2, SIMD_AVX512, SIMD_NEON, NUM_SIMD_LEVELS };
+
+// "scalar", "sse2", ...
+const char* simd_level_name(SimdLevel level);
+// level from its name, false if there's no such name
+bool parse_simd_level(const char *name, SimdLevel *level);
+
+// true if this build has the level's kernels and this machine can run them
+bool simd_supported(SimdLevel level);
+// the best supported level
+SimdLevel simd_best();
+
+// the level pixel_kernels() runs with -- FINGERSHOOTER_SIMD's if set, else simd_best()
+SimdLevel simd_level();
+// switches pixel_kernels() to level (or the best supported below it) and returns
+// the level set -- for benchmarks and tests, not while other threads run kernels
+SimdLevel set_simd_level(SimdLevel level);
+
+#endif /* SIMD_DISPATCH_H_ */
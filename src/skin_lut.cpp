@@ -0,0 +1,210 @@
+/*
+ * skin_lut.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "skin_lut.h"
+#include "pixel_kernels.h"
+#include "hue_kernel.h"
+
+#include <cstring>
+#include <algorithm>
+
+using namespace std;
+
+Histogram create_hue_sat_hist_bins() {
+	int    hist_size[] = { HUESAT_H_BINS, HUESAT_S_BINS };
+	float  h_ranges[]  = { 0, 180 };          // hue is [0,180]
+	float  s_ranges[]  = { 0, 255 };
+	float* ranges[]    = { h_ranges, s_ranges };
+	return Histogram(cvCreateHist(2, hist_size, CV_HIST_ARRAY, ranges, 1));
+}
+
+Histogram create_hue_hist_bins() {
+	int hdims = HUE_BINS;
+	float hranges_arr[] = {0,180};
+	float* hranges = hranges_arr;
+	return Histogram( cvCreateHist( 1, &hdims, CV_HIST_ARRAY, &hranges, 1 ) );
+}
+
+Histogram calc_hue_hist(const IplImage *bgr, CvRect selection) {
+	Histogram hist = create_hue_hist_bins();
+	Image hue( cvGetSize(bgr), 8, 1 );
+	IplImage *hue_plane = hue;
+	bgr_to_hue( bgr, hue );
+	float max_val = 0.f;
+	cvSetImageROI( hue, selection );
+	cvCalcHist( &hue_plane, hist, 0 );
+	cvGetMinMaxHistValue( hist, 0, &max_val, 0, 0 );
+	cvConvertScale( hist->bins, hist->bins, max_val ? 255. / max_val : 0., 0 );
+	return hist;
+}
+
+// bin for each 8 bit value, -1 if out of range -- same rounding as cvCalcBackProject
+// uses for uniform histograms
+static void bin_lookup(int bins, float lo, float hi, int lookup[256]) {
+	double a = bins / ((double)hi - lo);
+	double b = -lo * a;
+	for(int v=0; v<256; v++) {
+		int idx = cvFloor(v * a + b);
+		lookup[v] = (unsigned)idx < (unsigned)bins ? idx : -1;
+	}
+}
+
+HueSatLut::HueSatLut() {
+	memset(table, 0, sizeof(table));
+}
+
+void HueSatLut::build(const CvHistogram *hist) {
+	int sizes[2];
+	cvGetDims(hist->bins, sizes);
+	int h_lookup[256], s_lookup[256];
+	bin_lookup(sizes[0], hist->thresh[0][0], hist->thresh[0][1], h_lookup);
+	bin_lookup(sizes[1], hist->thresh[1][0], hist->thresh[1][1], s_lookup);
+
+	// one row of bin values per sat value, then fan out over hue
+	for(int s=0; s<256; s++) {
+		uchar *row = table + (s << 8);
+		if(s_lookup[s] < 0) {
+			memset(row, 0, 256);
+			continue;
+		}
+		for(int h=0; h<256; h++) {
+			if(h_lookup[h] < 0) {
+				row[h] = 0;
+				continue;
+			}
+			int v = cvRound(cvQueryHistValue_2D(hist, h_lookup[h], s_lookup[s]));
+			row[h] = (uchar)(v < 0 ? 0 : v > 255 ? 255 : v);
+		}
+	}
+}
+
+void HueSatLut::backproject(const IplImage *hsv, IplImage *mask) const {
+	for(int y=0; y<hsv->height; y++) {
+		const uchar *src = (const uchar *)(hsv->imageData + y * hsv->widthStep);
+		uchar *dst = (uchar *)(mask->imageData + y * mask->widthStep);
+		int x = 0;
+		// 4 at a time so the loads and lookups overlap
+		for(; x <= hsv->width - 4; x += 4, src += 12) {
+			ushort i0, i1, i2, i3;
+			memcpy(&i0, src, 2);
+			memcpy(&i1, src + 3, 2);
+			memcpy(&i2, src + 6, 2);
+			memcpy(&i3, src + 9, 2);
+			dst[x] = table[i0];
+			dst[x+1] = table[i1];
+			dst[x+2] = table[i2];
+			dst[x+3] = table[i3];
+		}
+		for(; x < hsv->width; x++, src += 3) {
+			dst[x] = table[src[0] | (src[1] << 8)];
+		}
+	}
+}
+
+HueLut::HueLut() {
+	memset(table, 0, sizeof(table));
+}
+
+void HueLut::build(const CvHistogram *hist) {
+	memset(table, 0, sizeof(table));
+	int sizes[CV_MAX_DIM];
+	if(cvGetDims(hist->bins, sizes) != 1) {
+		return;
+	}
+	int h_lookup[256];
+	bin_lookup(sizes[0], hist->thresh[0][0], hist->thresh[0][1], h_lookup);
+	for(int h=0; h<256; h++) {
+		if(h_lookup[h] >= 0) {
+			int v = cvRound(cvQueryHistValue_1D(hist, h_lookup[h]));
+			table[h] = (uchar)(v < 0 ? 0 : v > 255 ? 255 : v);
+		}
+	}
+}
+
+void HueLut::backproject(const IplImage *hue, IplImage *mask) const {
+	lut_image(hue, mask, table);
+}
+
+// hue of a chroma pair on OpenCV's 8 bit scale [0,180], as BGR2HSV would give it for
+// any luma that doesn't clip -- r, g, b relative to luma, in 1/256ths
+static int chroma_hue(int d, int e) {
+	int r = 409 * e, g = -100 * d - 208 * e, b = 516 * d;
+	int vmax = max(r, max(g, b)), vmin = min(r, min(g, b));
+	int diff = vmax - vmin;
+	if(diff == 0) {
+		return 0;
+	}
+	double h;
+	if(vmax == r) {
+		h = (g - b) * 60. / diff;
+	} else if(vmax == g) {
+		h = (b - r) * 60. / diff + 120;
+	} else {
+		h = (r - g) * 60. / diff + 240;
+	}
+	if(h < 0) {
+		h += 360;
+	}
+	return cvRound(h / 2);
+}
+
+// saturation [0,255] of a chroma pair at mid luma
+static int chroma_sat(int d, int e) {
+	uchar bgr[3];
+	yuv_put_bgr(bgr, 298 * (128 - 16), d, e);
+	int vmax = max(bgr[0], max(bgr[1], bgr[2]));
+	int vmin = min(bgr[0], min(bgr[1], bgr[2]));
+	return vmax ? cvRound((vmax - vmin) * 255. / vmax) : 0;
+}
+
+UvSkinLut::UvSkinLut() {
+	memset(table, 0, sizeof(table));
+}
+
+void UvSkinLut::build(const CvHistogram *hist) {
+	int sizes[2];
+	int dims = cvGetDims(hist->bins, sizes);
+	int h_lookup[256], s_lookup[256];
+	bin_lookup(sizes[0], hist->thresh[0][0], hist->thresh[0][1], h_lookup);
+	if(dims == 2) {
+		bin_lookup(sizes[1], hist->thresh[1][0], hist->thresh[1][1], s_lookup);
+	}
+	for(int v=0; v<256; v++) {
+		for(int u=0; u<256; u++) {
+			int hb = h_lookup[chroma_hue(u - 128, v - 128)];
+			float val = 0;
+			if(dims == 1 && hb >= 0) {
+				val = cvQueryHistValue_1D(hist, hb);
+			} else if(dims == 2 && hb >= 0) {
+				int sb = s_lookup[chroma_sat(u - 128, v - 128)];
+				val = sb >= 0 ? cvQueryHistValue_2D(hist, hb, sb) : 0;
+			}
+			int iv = cvRound(val);
+			table[(v << 8) | u] = (uchar)(iv < 0 ? 0 : iv > 255 ? 255 : iv);
+		}
+	}
+}
+
+void UvSkinLut::backproject(const YuvFrame &frame, IplImage *mask) const {
+	int w = frame.width;
+	for(int y=0; y<frame.height; y++) {
+		uchar *dst = (uchar *)(mask->imageData + y * mask->widthStep);
+		if(frame.fmt == YUV_YUYV) {
+			const uchar *src = frame.data + y * w * 2;
+			for(int x=0; x<w-1; x+=2, src+=4) {
+				dst[x] = dst[x+1] = table[(src[3] << 8) | src[1]];
+			}
+		} else if(y & 1) {
+			// nv12 rows share chroma in pairs
+			memcpy(dst, mask->imageData + (y - 1) * mask->widthStep, w);
+		} else {
+			const uchar *src = frame.data + w * frame.height + (y / 2) * w;
+			for(int x=0; x<w-1; x+=2, src+=2) {
+				dst[x] = dst[x+1] = table[(src[1] << 8) | src[0]];
+			}
+		}
+	}
+}
@@ -0,0 +1,89 @@
+/*
+ * skin_lut.h
+ *
+ * Hue + saturation backprojection through a flat 64K table.  The 2D histogram is
+ * expanded once into table[s<<8 | h] so backprojecting is one 16 bit load and one
+ * byte lookup per pixel, straight from the interleaved HSV image -- no cvSplit into
+ * planes and no per pixel bin arithmetic.  Output matches cvCalcBackProject on the
+ * same histogram.  HueLut does the same for a hue only histogram with a 256 entry
+ * table, looked up through the SIMD kernels (pixel_kernels.h).
+ * Implementation in skin_lut.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SKIN_LUT_H_
+#define SKIN_LUT_H_
+
+#include "cv.h"
+#include "yuv_source.h"
+#include "cv_handles.h"
+
+// the 2D histogram layout calibration uses
+#define HUESAT_H_BINS 30
+#define HUESAT_S_BINS 32
+
+// the 1D layout calibration uses
+#define HUE_BINS 16
+
+// empty hue/sat histogram with HUESAT_H_BINS x HUESAT_S_BINS bins over hue [0,180]
+// and sat [0,255]
+Histogram create_hue_sat_hist_bins();
+
+// empty hue histogram with HUE_BINS bins over hue [0,180]
+Histogram create_hue_hist_bins();
+
+// HUE_BINS hue histogram of bgr's selection, scaled so the biggest bin is 255
+// just the numbers, nothing shown or saved -- for headless modes
+Histogram calc_hue_hist(const IplImage *bgr, CvRect selection);
+
+class HueSatLut {
+public:
+	HueSatLut();
+
+	// expands a uniform 2D hue/sat histogram (dims hue, sat) into the table
+	void build(const CvHistogram *hist);
+
+	// hsv -- 8 bit 3 channel HSV image, mask -- 8 bit 1 channel, same size
+	void backproject(const IplImage *hsv, IplImage *mask) const;
+
+	// indexed by sat<<8 | hue, ie the two bytes of an HSV pixel read little endian
+	uchar table[256 * 256];
+};
+
+class HueLut {
+public:
+	HueLut();
+
+	// expands a uniform 1D hue histogram into the table, anything else (eg a hue/sat
+	// histogram, HueSatLut's job) leaves it all 0
+	void build(const CvHistogram *hist);
+
+	// hue -- 8 bit 1 channel hue plane, mask -- 8 bit 1 channel, same size
+	// same as cvCalcBackProject(&hue, mask, hist)
+	void backproject(const IplImage *hue, IplImage *mask) const;
+
+	uchar table[256];
+};
+
+// Skin probability straight from camera chroma, no BGR or HSV on the way.  Hue only
+// depends on the chroma -- adding luma moves r, g and b together -- so each U,V pair
+// maps to one hue and the histogram is expanded once into table[v<<8 | u].
+// A hue histogram comes out the same as converting to HSV first, up to rounding.
+// Saturation does depend on luma, so for a hue/sat histogram it is taken at mid
+// luma, close enough for skin tones in a normally lit scene.
+class UvSkinLut {
+public:
+	UvSkinLut();
+
+	// hist -- uniform 1D hue or 2D hue/sat histogram, as calibration makes them
+	void build(const CvHistogram *hist);
+
+	// mask -- 8 bit 1 channel, frame size
+	// each chroma sample is looked up once and spread over the pixels sharing it
+	void backproject(const YuvFrame &frame, IplImage *mask) const;
+
+	uchar table[256 * 256];
+};
+
+#endif /* SKIN_LUT_H_ */
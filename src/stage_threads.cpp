@@ -0,0 +1,301 @@
+/*
+ * stage_threads.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "stage_threads.h"
+#include "trace.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <cerrno>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+using namespace std;
+
+// from linux/mempolicy.h, not always installed
+#ifndef MPOL_DEFAULT
+#define MPOL_DEFAULT 0
+#endif
+#ifndef MPOL_LOCAL
+#define MPOL_LOCAL 4
+#endif
+
+static const char *stage_names[] = { "capture", "vision", "bullets", "writer" };
+static const char *thread_names[] = { "main", "vision" };
+
+ThreadSettings::ThreadSettings()
+: fifo_priority(0), set_nice(false), nice(0), local_memory(false)
+{}
+
+// "2,4-6" appended to cores
+static bool parse_cores(const char *s, vector<int>& cores) {
+	while(*s) {
+		char *end;
+		long first = strtol(s, &end, 10);
+		// a cpu_set_t only has room for CPU_SETSIZE cores, CPU_SET past it writes past it
+		if(end == s || first < 0 || first >= CPU_SETSIZE) {
+			return false;
+		}
+		long last = first;
+		s = end;
+		if(*s == '-') {
+			last = strtol(s + 1, &end, 10);
+			if(end == s + 1 || last < first || last >= CPU_SETSIZE) {
+				return false;
+			}
+			s = end;
+		}
+		for(long c=first; c<=last; c++) {
+			cores.push_back((int)c);
+		}
+		if(*s == ',') {
+			s++;
+		} else if(*s) {
+			return false;
+		}
+	}
+	return !cores.empty();
+}
+
+bool parse_thread_settings(const char *spec, ThreadSettings *s) {
+	char buf[256];
+	if(strlen(spec) >= sizeof(buf)) {
+		return false;
+	}
+	strcpy(buf, spec);
+	char *save = NULL;
+	for(char *part=strtok_r(buf, ":", &save); part; part=strtok_r(NULL, ":", &save)) {
+		char *value = strchr(part, '=');
+		if(value) {
+			*value++ = 0;
+		}
+		if(strcmp(part, "cores") == 0 && value) {
+			s->cores.clear();
+			if(!parse_cores(value, s->cores)) {
+				return false;
+			}
+		} else if(strcmp(part, "fifo") == 0 && value) {
+			s->fifo_priority = atoi(value);
+			if(s->fifo_priority < 1 || s->fifo_priority > 99) {
+				return false;
+			}
+		} else if(strcmp(part, "nice") == 0 && value) {
+			s->set_nice = true;
+			s->nice = atoi(value);
+		} else if(strcmp(part, "localmem") == 0 && !value) {
+			s->local_memory = true;
+		} else {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool apply_thread_settings(const ThreadSettings& s) {
+	bool ok = true;
+	if(!s.cores.empty()) {
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		for(size_t i=0; i<s.cores.size(); i++) {
+			CPU_SET(s.cores[i], &set);
+		}
+		int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+		if(err) {
+			errno = err;
+			ok = false;
+		}
+	}
+	// only touch the policy if it's changing, going back to normal needs no rights
+	int policy;
+	sched_param param;
+	pthread_getschedparam(pthread_self(), &policy, &param);
+	int want = s.fifo_priority > 0 ? SCHED_FIFO : SCHED_OTHER;
+	if(policy != want || (want == SCHED_FIFO && param.sched_priority != s.fifo_priority)) {
+		param.sched_priority = s.fifo_priority;
+		int err = pthread_setschedparam(pthread_self(), want, &param);
+		if(err) {
+			errno = err;
+			ok = false;
+		}
+	}
+	// on linux nice is per thread when given the thread id
+	if(s.set_nice && setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), s.nice) != 0) {
+		ok = false;
+	}
+	int mode = s.local_memory ? MPOL_LOCAL : MPOL_DEFAULT;
+	if(syscall(SYS_set_mempolicy, mode, NULL, 0) != 0) {
+		ok = false;
+	}
+	return ok;
+}
+
+const double JitterHistogram::FINE_MS = .1;
+
+JitterHistogram::JitterHistogram()
+: fine(FINE_BUCKETS, 0), n(0), sum(0), sum_sq(0), max_ms(0)
+{}
+
+void JitterHistogram::add(double ms) {
+	int b = (int)(ms / FINE_MS);
+	fine[b < FINE_BUCKETS - 1 ? b : FINE_BUCKETS - 1]++;
+	n++;
+	sum += ms;
+	sum_sq += ms * ms;
+	if(ms > max_ms) {
+		max_ms = ms;
+	}
+}
+
+double JitterHistogram::percentile(double pct) const {
+	long want = (long)ceil(n * pct / 100.), seen = 0;
+	for(int b=0; b<FINE_BUCKETS - 1; b++) {
+		seen += fine[b];
+		if(seen >= want) {
+			return (b + 1) * FINE_MS;
+		}
+	}
+	return max_ms;
+}
+
+void JitterHistogram::print(const char *name) const {
+	if(n == 0) {
+		printf("  %-8s no frames\n", name);
+		return;
+	}
+	double mean = sum / n;
+	double sd = sqrt(max(0., sum_sq / n - mean * mean));
+	double p50 = percentile(50), p99 = percentile(99);
+	printf("  %-8s %6ld frames, mean %7.2f ms, sd %6.2f, median %6.1f, p99 %6.1f, "
+			"max %7.2f, p99 - median %6.1f ms\n", name, n, mean, sd, p50, p99, max_ms,
+			p99 - p50);
+	// fine buckets folded into powers of 2 from .25 ms, last is everything past 64
+	long folded[10] = { 0 };
+	for(int b=0; b<FINE_BUCKETS; b++) {
+		double lower = b * FINE_MS;
+		int k = 0;
+		for(double edge=.25; k<9 && lower >= edge - 1e-9; edge *= 2) {
+			k++;
+		}
+		folded[k] += fine[b];
+	}
+	printf("          ");
+	double lo = 0, hi = .25;
+	for(int k=0; k<10; k++, lo = hi, hi *= 2) {
+		if(folded[k] == 0) {
+			continue;
+		}
+		if(k < 9) {
+			printf(" [%g,%g) %ld", lo, hi, folded[k]);
+		} else {
+			printf(" [%g+ %ld", lo, folded[k]);
+		}
+	}
+	printf("\n");
+}
+
+StageControls::StageControls() {
+	for(int i=0; i<NUM_STAGE_THREADS; i++) {
+		set[i] = false;
+	}
+	for(int i=0; i<NUM_STAGES; i++) {
+		started[i] = 0;
+	}
+}
+
+bool StageControls::configure(const char *spec) {
+	const char *colon = strchr(spec, ':');
+	if(!colon) {
+		return false;
+	}
+	size_t len = colon - spec;
+	for(int i=0; i<NUM_STAGE_THREADS; i++) {
+		if(strncmp(spec, thread_names[i], len) == 0 && thread_names[i][len] == 0) {
+			ThreadSettings s;
+			if(!parse_thread_settings(colon + 1, &s)) {
+				return false;
+			}
+			threads[i] = s;
+			set[i] = true;
+			return true;
+		}
+	}
+	// capture, bullets and writer all run on the main thread
+	for(int i=0; i<NUM_STAGES; i++) {
+		if(i != STAGE_VISION && strncmp(spec, stage_names[i], len) == 0 &&
+				stage_names[i][len] == 0) {
+			fprintf(stderr, "stage %s runs on the main thread, configure it as main:...\n",
+					stage_names[i]);
+		}
+	}
+	return false;
+}
+
+int StageControls::pool_workers() const {
+	int cores = set[THREAD_VISION] ? (int)threads[THREAD_VISION].cores.size() : 0;
+	if(cores == 0) {
+		return 0;
+	}
+	return set[THREAD_MAIN] ? cores + 1 : cores;
+}
+
+bool StageControls::apply_main() {
+	ThreadSettings s;
+	if(set[THREAD_MAIN]) {
+		s = threads[THREAD_MAIN];
+	} else if(set[THREAD_VISION]) {
+		// the main thread is the pool's worker 0, on the first vision core
+		s = threads[THREAD_VISION];
+		if(!s.cores.empty()) {
+			s.cores.assign(1, s.cores[0]);
+		}
+	} else {
+		return true;
+	}
+	if(!apply_thread_settings(s)) {
+		fprintf(stderr, "stage main: settings not (all) applied: %s\n", strerror(errno));
+		return false;
+	}
+	return true;
+}
+
+void StageControls::init_pool_thread(void *arg, int worker) {
+	StageControls *self = (StageControls *)arg;
+	if(!self->set[THREAD_VISION]) {
+		return;
+	}
+	// each helper on a core of its own, so they don't migrate between frames
+	// -- the first core is the main thread's unless it has its own settings
+	ThreadSettings s = self->threads[THREAD_VISION];
+	if(!s.cores.empty()) {
+		int first = self->set[THREAD_MAIN] ? 1 : 0;
+		int core = s.cores[(worker - first) % s.cores.size()];
+		s.cores.assign(1, core);
+	}
+	if(!apply_thread_settings(s)) {
+		fprintf(stderr, "stage vision: worker %d settings not applied: %s\n", worker,
+				strerror(errno));
+	}
+}
+
+void StageControls::begin(PipelineStage s) {
+	started[s] = cvGetTickCount();
+}
+
+void StageControls::end(PipelineStage s) {
+	jitter[s].add(ticks_to_ms(cvGetTickCount() - started[s]));
+}
+
+void StageControls::print_stats() const {
+	printf("Stage times per frame:\n");
+	for(int i=0; i<NUM_STAGES; i++) {
+		jitter[i].print(stage_names[i]);
+	}
+}
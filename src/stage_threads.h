@@ -0,0 +1,117 @@
+/*
+ * stage_threads.h
+ *
+ * Where and how the pipeline's threads run, for boxes where other work shares the cores
+ * and the scheduler puts spikes in the frame times.  Each thread
+ *
+ * 	main      capture, display, bullets, the writer, and its share of the vision
+ * 	          work as the TaskPool's worker 0
+ * 	vision    the TaskPool's helper threads (segmentation tiles, contours)
+ *
+ * can be pinned to cores, run SCHED_FIFO or at a nice level, and have what it
+ * allocates placed on its own NUMA node, eg
+ *
+ * 	--stage vision:cores=2-5:fifo=10 --stage main:cores=1:fifo=5
+ *
+ * Settings go on once per thread and stay -- switching them stage by stage would move
+ * the main thread between cores mid frame, the very jitter this is for.  main's are
+ * applied before anything big is allocated, since a memory policy only places what is
+ * allocated after it.  Vision workers each get a core of the list to themselves; with
+ * no main settings the main thread is worker 0 on the first core, with them the
+ * helpers take the whole list.
+ *
+ * The stages (capture, vision, bullets, writer) are still timed apart, every stage's
+ * time per frame goes into a histogram, printed at exit, to see whether the settings
+ * took the spikes out.
+ * Implementation in stage_threads.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef STAGE_THREADS_H_
+#define STAGE_THREADS_H_
+
+#include "cv.h"
+#include <vector>
+
+enum PipelineStage { STAGE_CAPTURE, STAGE_VISION, STAGE_BULLETS, STAGE_WRITER, NUM_STAGES };
+
+// the threads that take settings
+enum StageThread { THREAD_MAIN, THREAD_VISION, NUM_STAGE_THREADS };
+
+struct ThreadSettings {
+	ThreadSettings();
+
+	// cores to run on, empty for any
+	std::vector<int> cores;
+	// SCHED_FIFO priority 1-99, 0 for the normal scheduler
+	int fifo_priority;
+	// nice level, only if set_nice
+	bool set_nice;
+	int nice;
+	// local memory policy -- what the thread allocates from now on comes from the node
+	// it's running on, rather than wherever the first touch happens to be
+	bool local_memory;
+};
+
+// "cores=2,4-6:fifo=10:nice=-5:localmem", any of the parts in any order
+// false if something doesn't parse
+bool parse_thread_settings(const char *spec, ThreadSettings *s);
+
+// applies s to the calling thread, false if any part failed (errno is left set)
+// eg fifo needs CAP_SYS_NICE or an rtprio limit, negative nice the same
+bool apply_thread_settings(const ThreadSettings& s);
+
+// distribution of a stage's time per frame
+class JitterHistogram {
+public:
+	JitterHistogram();
+	void add(double ms);
+	// count, mean, std dev, median, 99th percentile, max and a power of 2 histogram
+	void print(const char *name) const;
+	long count() const { return n; }
+	// upper edge of the bucket holding the pct'th percentile
+	double percentile(double pct) const;
+
+private:
+	// FINE_BUCKETS of FINE_MS each, the last one everything past
+	enum { FINE_BUCKETS = 1001 };
+	static const double FINE_MS;
+	std::vector<long> fine;
+	long n;
+	double sum, sum_sq, max_ms;
+};
+
+class StageControls {
+public:
+	StageControls();
+
+	// "thread:settings", eg "vision:cores=2-5:fifo=10", false if it doesn't parse
+	// (the old per stage names say to use main instead)
+	bool configure(const char *spec);
+	bool configured(StageThread t) const { return set[t]; }
+	const ThreadSettings& settings(StageThread t) const { return threads[t]; }
+	// workers for the TaskPool, including the main thread -- one per vision core, plus
+	// the main thread if it has settings of its own -- 0 (one per core) if no cores
+	int pool_workers() const;
+
+	// call on the main thread once, before the frame buffers are allocated
+	// false (with a warning) if the settings didn't all take
+	bool apply_main();
+	// TaskPool thread init hook, arg is the StageControls
+	static void init_pool_thread(void *arg, int worker);
+
+	// main thread entering / leaving a stage, for the times only
+	void begin(PipelineStage s);
+	void end(PipelineStage s);
+
+	void print_stats() const;
+
+private:
+	ThreadSettings threads[NUM_STAGE_THREADS];
+	bool set[NUM_STAGE_THREADS];
+	int64 started[NUM_STAGES];
+	JitterHistogram jitter[NUM_STAGES];
+};
+
+#endif /* STAGE_THREADS_H_ */
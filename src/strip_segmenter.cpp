@@ -0,0 +1,57 @@
+/*
+ * strip_segmenter.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "strip_segmenter.h"
+#include "hue_kernel.h"
+
+#include <algorithm>
+
+using namespace std;
+
+StripSegmenter::StripSegmenter(int _strip_rows)
+: strip_rows(_strip_rows), lut(NULL)
+{}
+
+void StripSegmenter::set_hist(const CvHistogram *hist) {
+	hue_lut.build(hist);
+}
+
+void StripSegmenter::set_lut(const HueSatLut *_lut) {
+	lut = _lut;
+}
+
+// header onto rows [y, y + n) of img, no copying
+static IplImage* rows_of(IplImage *hdr, const IplImage *img, int y, int n) {
+	cvInitImageHeader(hdr, cvSize(img->width, n), img->depth, img->nChannels);
+	cvSetData(hdr, img->imageData + y * img->widthStep, img->widthStep);
+	return hdr;
+}
+
+void StripSegmenter::run(const IplImage *bgr, IplImage *mask) {
+	CvSize strip = cvSize(bgr->width, strip_rows);
+	if(lut) {
+		hsv.ensure(strip, 8, 3);
+		hue.reset();
+	} else {
+		hue.ensure(strip, 8, 1);
+		hsv.reset();
+	}
+	for(int y=0; y<bgr->height; y+=strip_rows) {
+		int n = min(strip_rows, bgr->height - y);
+		IplImage src_hdr, mask_hdr, work_hdr;
+		IplImage *src = rows_of(&src_hdr, bgr, y, n);
+		IplImage *dst = rows_of(&mask_hdr, mask, y, n);
+		if(lut) {
+			IplImage *hsv_rows = rows_of(&work_hdr, hsv, 0, n);
+			cvCvtColor(src, hsv_rows, CV_BGR2HSV);
+			lut->backproject(hsv_rows, dst);
+		} else {
+			IplImage *hue_rows = rows_of(&work_hdr, hue, 0, n);
+			bgr_to_hue(src, hue_rows);
+			hue_lut.backproject(hue_rows, dst);
+		}
+	}
+}
@@ -0,0 +1,44 @@
+/*
+ * strip_segmenter.h
+ *
+ * Backprojection for the low memory profile.  The frame goes through the colour
+ * stages a few rows at a time, so the only working buffers are strip sized -- a hue
+ * strip for a hue histogram, an hsv strip for a hue/sat table -- and the only full
+ * frame buffer is the mask the contour search needs anyway.  Only the planes the
+ * histogram uses are ever computed.
+ * Implementation in strip_segmenter.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef STRIP_SEGMENTER_H_
+#define STRIP_SEGMENTER_H_
+
+#include "cv.h"
+
+#include "cv_handles.h"
+#include "skin_lut.h"
+
+class StripSegmenter {
+public:
+	// strip_rows -- rows converted at a time, small enough to stay in cache
+	StripSegmenter(int strip_rows = 16);
+
+	// backproject with a 1D hue histogram (expanded into a HueLut, not kept)
+	void set_hist(const CvHistogram *hist);
+	// or with a hue/sat table (not owned), takes precedence over the histogram
+	void set_lut(const HueSatLut *lut);
+
+	// bgr -- 8 bit 3 channel, mask -- 8 bit 1 channel, same size, gets the raw
+	// backprojection (not thresholded)
+	void run(const IplImage *bgr, IplImage *mask);
+
+private:
+	int strip_rows;
+	HueLut hue_lut;
+	const HueSatLut *lut;
+	// strip_rows tall, frame wide
+	Image hue, hsv;
+};
+
+#endif /* STRIP_SEGMENTER_H_ */
@@ -0,0 +1,263 @@
+/*
+ * synth_scene.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "synth_scene.h"
+#include "cv_handles.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+using namespace std;
+
+// finger directions before rotation, degrees, -90 is straight up -- thumb a bit lower
+static const double finger_angles[] = { -150, -115, -90, -65, -35 };
+// which fingers are drawn first when there are fewer than five, thumb last
+static const int finger_order[] = { 2, 3, 1, 4, 0 };
+
+SynthParams::SynthParams()
+: size(cvSize(640, 480)), num_hands(2), min_fingers(5), max_fingers(5),
+  min_scale(150), max_scale(250), max_angle(30), num_clutter(0), num_decoys(0),
+  mask_noise(0), bgr_noise(0), seed(1)
+{}
+
+// base and tip of the i'th drawn finger
+static void finger_line(CvPoint center, int scale, double angle, int i,
+		CvPoint *base, CvPoint *tip) {
+	int palm_r = int(scale * .22);
+	int finger_len = int(scale * .4);
+	double a = (finger_angles[finger_order[i]] + angle) * CV_PI / 180.;
+	*base = cvPoint(center.x + int(cos(a) * palm_r * .8),
+			center.y + int(sin(a) * palm_r * .8));
+	*tip = cvPoint(center.x + int(cos(a) * (palm_r + finger_len)),
+			center.y + int(sin(a) * (palm_r + finger_len)));
+}
+
+void draw_synth_hand(IplImage *img, CvPoint center, int scale, double angle,
+		int fingers, CvScalar color, CvPoint *tips) {
+	int finger_w = max(2, int(scale * .07));
+	cvCircle(img, center, int(scale * .22), color, CV_FILLED);
+	for(int i=0; i<fingers && i<5; i++) {
+		CvPoint base, tip;
+		finger_line(center, scale, angle, i, &base, &tip);
+		cvLine(img, base, tip, color, finger_w);
+		if(tips) {
+			tips[i] = tip;
+		}
+	}
+}
+
+// uniform in [lo, hi]
+static int rand_range(CvRNG *rng, int lo, int hi) {
+	return hi > lo ? lo + (int)(cvRandInt(rng) % (unsigned)(hi - lo + 1)) : lo;
+}
+
+static double dist(CvPoint a, CvPoint b) {
+	double dx = a.x - b.x, dy = a.y - b.y;
+	return sqrt(dx * dx + dy * dy);
+}
+
+// tries before giving up on placing a hand or blob
+#define PLACE_TRIES 100
+
+SynthScene::SynthScene(const SynthParams& params)
+: p(params)
+{
+	CvRNG rng = cvRNG(p.seed);
+	// skin tones of one hue, lighter or darker
+	double shade = .8 + .3 * cvRandReal(&rng);
+	skin = CV_RGB(224 * shade, 172 * shade, 140 * shade);
+
+	for(int k=0; k<p.num_hands; k++) {
+		for(int tries=0; tries<PLACE_TRIES; tries++) {
+			SynthHand h;
+			h.scale = rand_range(&rng, p.min_scale, p.max_scale);
+			h.radius = int(h.scale * .22) + int(h.scale * .4) + max(2, int(h.scale * .07));
+			if(2 * h.radius >= min(p.size.width, p.size.height)) {
+				continue;
+			}
+			h.center = cvPoint(rand_range(&rng, h.radius, p.size.width - h.radius),
+					rand_range(&rng, h.radius, p.size.height - h.radius));
+			bool overlaps = false;
+			for(size_t i=0; i<truth.size() && !overlaps; i++) {
+				overlaps = dist(h.center, truth[i].center) <= h.radius + truth[i].radius;
+			}
+			if(overlaps) {
+				continue;
+			}
+			h.num_fingers = min(5, max(0, rand_range(&rng, p.min_fingers, p.max_fingers)));
+			h.angle = (2 * cvRandReal(&rng) - 1) * p.max_angle;
+			for(int i=0; i<h.num_fingers; i++) {
+				CvPoint base;
+				finger_line(h.center, h.scale, h.angle, i, &base, &h.tips[i]);
+			}
+			truth.push_back(h);
+			break;
+		}
+	}
+	// clutter stays clear of the hands so each hand is still its own contour
+	int min_axis = max(3, p.min_scale / 12), max_axis = max(min_axis, p.min_scale / 4);
+	for(int k=0; k<p.num_clutter; k++) {
+		for(int tries=0; tries<PLACE_TRIES; tries++) {
+			Blob b;
+			b.axes = cvSize(rand_range(&rng, min_axis, max_axis),
+					rand_range(&rng, min_axis, max_axis));
+			b.center = cvPoint(rand_range(&rng, 0, p.size.width - 1),
+					rand_range(&rng, 0, p.size.height - 1));
+			b.angle = 180 * cvRandReal(&rng);
+			int r = max(b.axes.width, b.axes.height);
+			bool overlaps = false;
+			for(size_t i=0; i<truth.size() && !overlaps; i++) {
+				overlaps = dist(b.center, truth[i].center) <= truth[i].radius + r;
+			}
+			if(!overlaps) {
+				clutter.push_back(b);
+				break;
+			}
+		}
+	}
+	// decoys the size of a hand, also clear of the hands
+	for(int k=0; k<p.num_decoys; k++) {
+		for(int tries=0; tries<PLACE_TRIES; tries++) {
+			int r = rand_range(&rng, p.min_scale / 3, p.max_scale / 2);
+			CvPoint center = cvPoint(rand_range(&rng, r, p.size.width - r),
+					rand_range(&rng, r, p.size.height - r));
+			bool overlaps = false;
+			for(size_t i=0; i<truth.size() && !overlaps; i++) {
+				overlaps = dist(center, truth[i].center) <= truth[i].radius + r;
+			}
+			if(overlaps) {
+				continue;
+			}
+			// points and the notches between them, a little uneven
+			int points = rand_range(&rng, 5, 7);
+			vector<CvPoint> outline;
+			for(int i=0; i<2 * points; i++) {
+				double a = i * CV_PI / points + (cvRandReal(&rng) - .5) * .4;
+				double rr = r * (i % 2 == 0 ? .8 + .4 * cvRandReal(&rng) :
+						.3 + .2 * cvRandReal(&rng));
+				outline.push_back(cvPoint(center.x + int(cos(a) * rr),
+						center.y + int(sin(a) * rr)));
+			}
+			decoys.push_back(outline);
+			break;
+		}
+	}
+}
+
+void SynthScene::draw_fakes(IplImage *img, CvScalar color) const {
+	for(size_t i=0; i<clutter.size(); i++) {
+		const Blob& b = clutter[i];
+		cvEllipse(img, b.center, b.axes, b.angle, 0, 360, color, CV_FILLED);
+	}
+	for(size_t i=0; i<decoys.size(); i++) {
+		CvPoint *pts = (CvPoint *)&decoys[i][0];
+		int n = (int)decoys[i].size();
+		cvFillPoly(img, &pts, &n, 1, color);
+	}
+}
+
+void SynthScene::render(IplImage *mask, IplImage *bgr) const {
+	// noise has its own generator so rendering twice gives the same images
+	CvRNG rng = cvRNG(p.seed ^ 0x9e3779b9);
+	if(mask) {
+		cvZero(mask);
+		for(size_t i=0; i<truth.size(); i++) {
+			const SynthHand& h = truth[i];
+			draw_synth_hand(mask, h.center, h.scale, h.angle, h.num_fingers, cvScalarAll(255));
+		}
+		draw_fakes(mask, cvScalarAll(255));
+		int flips = int(p.mask_noise * p.size.width * p.size.height);
+		for(int i=0; i<flips; i++) {
+			int x = rand_range(&rng, 0, mask->width - 1);
+			int y = rand_range(&rng, 0, mask->height - 1);
+			uchar *px = (uchar *)(mask->imageData + y * mask->widthStep) + x;
+			*px ^= 255;
+		}
+	}
+	if(bgr) {
+		// blue to cyan background, well away from skin hues
+		cvRandArr(&rng, bgr, CV_RAND_UNI, cvScalar(120, 60, 0), cvScalar(256, 160, 90));
+		for(size_t i=0; i<truth.size(); i++) {
+			const SynthHand& h = truth[i];
+			draw_synth_hand(bgr, h.center, h.scale, h.angle, h.num_fingers, skin);
+		}
+		draw_fakes(bgr, skin);
+		if(p.bgr_noise > 0) {
+			// noise around 128, added with saturation
+			Image noise(cvGetSize(bgr), 8, 3);
+			cvRandArr(&rng, noise, CV_RAND_NORMAL, cvScalarAll(128), cvScalarAll(p.bgr_noise));
+			cvAddWeighted(bgr, 1, noise, 1, -128, bgr);
+		}
+	}
+}
+
+SynthScore::SynthScore()
+: false_hands(0), tips_matched(0), tips_false(0), tips_expected(0)
+{
+	memset(hands, 0, sizeof(hands));
+	memset(hands_found, 0, sizeof(hands_found));
+}
+
+void SynthScore::add(const SynthScore& o) {
+	for(int i=0; i<6; i++) {
+		hands[i] += o.hands[i];
+		hands_found[i] += o.hands_found[i];
+	}
+	false_hands += o.false_hands;
+	tips_matched += o.tips_matched;
+	tips_false += o.tips_false;
+	tips_expected += o.tips_expected;
+}
+
+SynthScore score_hands(const vector<SynthHand>& truth, const vector<Hand>& found,
+		double tolerance) {
+	SynthScore score;
+	vector<bool> matched(truth.size(), false);
+	for(size_t i=0; i<truth.size(); i++) {
+		score.hands[truth[i].num_fingers]++;
+	}
+	for(size_t f=0; f<found.size(); f++) {
+		const Hand& hand = found[f];
+		// the truth hand whose circle the found center is in
+		int t = -1;
+		for(size_t i=0; i<truth.size(); i++) {
+			if(dist(hand.center, truth[i].center) <= truth[i].radius) {
+				t = (int)i;
+				break;
+			}
+		}
+		if(t < 0 || matched[t]) {
+			score.false_hands++;
+			continue;
+		}
+		matched[t] = true;
+		const SynthHand& h = truth[t];
+		score.hands_found[h.num_fingers]++;
+		score.tips_expected += h.num_fingers;
+
+		// each truth tip can be claimed once
+		bool claimed[5] = { false, false, false, false, false };
+		for(int i=0; i<hand.num_tips; i++) {
+			int best = -1;
+			double best_d = tolerance * h.scale;
+			for(int j=0; j<h.num_fingers; j++) {
+				double d = dist(hand.tips[i], h.tips[j]);
+				if(!claimed[j] && d <= best_d) {
+					best = j;
+					best_d = d;
+				}
+			}
+			if(best >= 0) {
+				claimed[best] = true;
+				score.tips_matched++;
+			} else {
+				score.tips_false++;
+			}
+		}
+	}
+	return score;
+}
@@ -0,0 +1,121 @@
+/*
+ * synth_scene.h
+ *
+ * Procedural test scenes, so the detector can be loaded and checked without a camera
+ * or a folder of jpegs.  A scene is some number of hands -- palm plus 0-5 spread
+ * fingers, any scale and rotation -- plus skin coloured clutter blobs that aren't
+ * hands, spiky decoys with as many deep gaps as a hand, plus noise, at any resolution.
+ * Everything comes from a seed, so the same params always give the same scene.
+ *
+ * Scenes render as a backprojection style mask (skin 255, rest 0) and / or a BGR
+ * frame (skin tones on a bluish background), and keep the ground truth: where each
+ * hand is and where its fingertips are.  score_hands() matches what a detector found
+ * against that truth.
+ * Implementation in synth_scene.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef SYNTH_SCENE_H_
+#define SYNTH_SCENE_H_
+
+#include "cv.h"
+#include <vector>
+
+#include "hand_detector.h"
+
+// ground truth for one rendered hand
+struct SynthHand {
+	CvPoint center;
+	// roughly the hand's height in pixels, as draw_test_hand
+	int scale;
+	// 0 is fingers up, positive turns clockwise on screen
+	double angle;
+	int num_fingers;
+	CvPoint tips[5];
+	// circle everything drawn for the hand fits in
+	int radius;
+};
+
+struct SynthParams {
+	SynthParams();
+
+	CvSize size;
+	int num_hands;
+	// fingers per hand, picked uniformly in [min_fingers, max_fingers]
+	int min_fingers, max_fingers;
+	// hand scale in pixels, uniform in [min_scale, max_scale]
+	int min_scale, max_scale;
+	// max rotation either way in degrees
+	double max_angle;
+	// skin coloured ellipses that aren't hands
+	int num_clutter;
+	// skin coloured stars with 5 to 7 points -- the right number of deep defects for
+	// a hand, the wrong shape
+	int num_decoys;
+	// fraction of mask pixels flipped, and std dev of the noise added to bgr
+	double mask_noise;
+	double bgr_noise;
+	unsigned seed;
+};
+
+// draws one open hand into mask (1 channel, white) or a bgr image (color)
+// fingers -- how many of the five to draw, thumb last
+// tips -- [NULL] if not null, gets the fingertip of each finger drawn
+void draw_synth_hand(IplImage *img, CvPoint center, int scale, double angle,
+		int fingers, CvScalar color, CvPoint *tips = NULL);
+
+class SynthScene {
+public:
+	// places the hands and clutter -- hands that don't fit without overlapping are
+	// left out, so check hands().size()
+	SynthScene(const SynthParams& params);
+
+	// mask -- 8 bit 1 channel, bgr -- 8 bit 3 channel, params.size, either may be NULL
+	void render(IplImage *mask, IplImage *bgr) const;
+
+	const std::vector<SynthHand>& hands() const { return truth; }
+	const SynthParams& params() const { return p; }
+
+private:
+	struct Blob {
+		CvPoint center;
+		CvSize axes;
+		double angle;
+	};
+
+	SynthParams p;
+	std::vector<SynthHand> truth;
+	std::vector<Blob> clutter;
+	// star outlines
+	std::vector<std::vector<CvPoint> > decoys;
+
+	// draws clutter and decoys in color
+	void draw_fakes(IplImage *img, CvScalar color) const;
+	// skin tone the scene is drawn in
+	CvScalar skin;
+};
+
+// how found hands line up with the truth
+struct SynthScore {
+	SynthScore();
+	void add(const SynthScore& other);
+
+	// truth hands, and those a found hand's center landed on, by finger count
+	int hands[6];
+	int hands_found[6];
+	// found hands not on any truth hand (ie on clutter)
+	int false_hands;
+	// fingertips of found hands within tolerance of a truth tip, and those that weren't
+	int tips_matched;
+	int tips_false;
+	// truth tips on found hands
+	int tips_expected;
+};
+
+// tolerance -- how far a found tip may be from the truth tip, as a fraction of the
+// truth hand's scale
+SynthScore score_hands(const std::vector<SynthHand>& truth, const std::vector<Hand>& found,
+		double tolerance = .1);
+
+#endif /* SYNTH_SCENE_H_ */
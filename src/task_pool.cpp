@@ -0,0 +1,167 @@
+/*
+ * task_pool.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "task_pool.h"
+#include "trace.h"
+
+#include <unistd.h>
+
+using namespace std;
+
+// handed to each helper thread
+struct PoolThreadArg {
+	TaskPool *pool;
+	int worker;
+};
+
+TaskPool::TaskPool(int _num_workers, ThreadInit _init, void *_init_arg)
+: num_workers(_num_workers), init(_init), init_arg(_init_arg), generation(0), busy(0), quit(false),
+  func(NULL), arg(NULL), num_steals(0)
+{
+	if(num_workers <= 0) {
+		num_workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	}
+	if(num_workers < 1) {
+		num_workers = 1;
+	}
+	pthread_mutex_init(&lock, NULL);
+	pthread_cond_init(&start_cond, NULL);
+	pthread_cond_init(&done_cond, NULL);
+	for(int i=0; i<num_workers; i++) {
+		WorkerQueue *q = new WorkerQueue();
+		pthread_mutex_init(&q->lock, NULL);
+		queues.push_back(q);
+	}
+	// worker 0 is whoever calls run()
+	threads.resize(num_workers - 1);
+	for(int i=1; i<num_workers; i++) {
+		PoolThreadArg *a = new PoolThreadArg();
+		a->pool = this;
+		a->worker = i;
+		pthread_create(&threads[i-1], NULL, thread_main, a);
+	}
+}
+
+TaskPool::~TaskPool() {
+	pthread_mutex_lock(&lock);
+	quit = true;
+	pthread_cond_broadcast(&start_cond);
+	pthread_mutex_unlock(&lock);
+	for(size_t i=0; i<threads.size(); i++) {
+		pthread_join(threads[i], NULL);
+	}
+	for(size_t i=0; i<queues.size(); i++) {
+		pthread_mutex_destroy(&queues[i]->lock);
+		delete queues[i];
+	}
+	pthread_cond_destroy(&start_cond);
+	pthread_cond_destroy(&done_cond);
+	pthread_mutex_destroy(&lock);
+}
+
+void* TaskPool::thread_main(void *p) {
+	PoolThreadArg *a = (PoolThreadArg *)p;
+	TaskPool *pool = a->pool;
+	int worker = a->worker;
+	delete a;
+	if(pool->init) {
+		pool->init(pool->init_arg, worker);
+	}
+	trace_thread_name("pool worker", worker);
+
+	int seen = 0;
+	while(1) {
+		pthread_mutex_lock(&pool->lock);
+		while(pool->generation == seen && !pool->quit) {
+			pthread_cond_wait(&pool->start_cond, &pool->lock);
+		}
+		seen = pool->generation;
+		bool quit = pool->quit;
+		pthread_mutex_unlock(&pool->lock);
+		if(quit) {
+			break;
+		}
+
+		pool->work(worker);
+
+		pthread_mutex_lock(&pool->lock);
+		if(--pool->busy == 0) {
+			pthread_cond_signal(&pool->done_cond);
+		}
+		pthread_mutex_unlock(&pool->lock);
+	}
+	return NULL;
+}
+
+void TaskPool::run(TaskFunc _func, void *_arg, int num_tasks) {
+	if(num_tasks <= 0) {
+		return;
+	}
+	// nothing to share out, skip waking anybody
+	if(num_workers == 1 || num_tasks == 1) {
+		for(int i=0; i<num_tasks; i++) {
+			_func(_arg, i, 0);
+		}
+		return;
+	}
+
+	// round robin so neighbouring tasks start out on different workers
+	for(int i=0; i<num_tasks; i++) {
+		WorkerQueue *q = queues[i % num_workers];
+		pthread_mutex_lock(&q->lock);
+		q->tasks.push_back(i);
+		pthread_mutex_unlock(&q->lock);
+	}
+
+	pthread_mutex_lock(&lock);
+	func = _func;
+	arg = _arg;
+	busy = num_workers - 1;
+	generation++;
+	pthread_cond_broadcast(&start_cond);
+	pthread_mutex_unlock(&lock);
+
+	work(0);
+
+	// the calling thread out of tasks, waiting for the slowest worker
+	TRACE_SCOPE("pool wait");
+	pthread_mutex_lock(&lock);
+	while(busy > 0) {
+		pthread_cond_wait(&done_cond, &lock);
+	}
+	pthread_mutex_unlock(&lock);
+}
+
+void TaskPool::work(int worker) {
+	int task;
+	while(next_task(worker, task)) {
+		func(arg, task, worker);
+	}
+}
+
+// own deque from the front, then steal from the back of the others
+// no tasks get added during a run, so all empty means we're done
+bool TaskPool::next_task(int worker, int& task) {
+	for(int i=0; i<num_workers; i++) {
+		int victim = (worker + i) % num_workers;
+		WorkerQueue *q = queues[victim];
+		pthread_mutex_lock(&q->lock);
+		if(!q->tasks.empty()) {
+			if(victim == worker) {
+				task = q->tasks.front();
+				q->tasks.pop_front();
+			} else {
+				task = q->tasks.back();
+				q->tasks.pop_back();
+				__sync_fetch_and_add(&num_steals, 1);
+			}
+			pthread_mutex_unlock(&q->lock);
+			return true;
+		}
+		pthread_mutex_unlock(&q->lock);
+	}
+	return false;
+}
@@ -0,0 +1,74 @@
+/*
+ * task_pool.h
+ *
+ * Small fork/join thread pool.  run() deals tasks 0..n-1 round robin into one deque
+ * per worker, each worker pops its own deque from the front and when that runs dry
+ * steals from the back of the others, so uneven tasks (busy tiles, big contours)
+ * even out.  The calling thread works as worker 0 and run() returns when every task
+ * is done.
+ * Implementation in task_pool.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef TASK_POOL_H_
+#define TASK_POOL_H_
+
+#include <vector>
+#include <deque>
+
+//******* unix/linux only for threads
+#include <pthread.h>
+
+class TaskPool {
+public:
+	// task -- index in [0, num_tasks), worker -- in [0, size()), use it to pick
+	// per worker scratch buffers
+	typedef void (*TaskFunc)(void *arg, int task, int worker);
+	// run once on each helper thread as it starts, eg to set its affinity
+	typedef void (*ThreadInit)(void *arg, int worker);
+
+	// num_workers -- including the calling thread, 0 for one per core
+	// init -- [NULL] if set, init(init_arg, worker) runs first thing on each helper thread
+	TaskPool(int num_workers = 0, ThreadInit init = NULL, void *init_arg = NULL);
+	~TaskPool();
+
+	// runs func(arg, task, worker) for every task, returns when they are all done
+	// not reentrant -- tasks must not call run() on the same pool
+	void run(TaskFunc func, void *arg, int num_tasks);
+
+	int size() const { return num_workers; }
+	// tasks taken from another worker's deque, since construction
+	long steals() const { return num_steals; }
+
+private:
+	struct WorkerQueue {
+		pthread_mutex_t lock;
+		std::deque<int> tasks;
+	};
+
+	static void* thread_main(void *arg);
+	void work(int worker);
+	bool next_task(int worker, int& task);
+
+	int num_workers;
+	ThreadInit init;
+	void *init_arg;
+	std::vector<pthread_t> threads;
+	std::vector<WorkerQueue*> queues;
+
+	// guards everything below
+	pthread_mutex_t lock;
+	pthread_cond_t start_cond;
+	pthread_cond_t done_cond;
+	// bumped by every run(), workers wait for it to change
+	int generation;
+	// helper threads still working on the current generation
+	int busy;
+	bool quit;
+	TaskFunc func;
+	void *arg;
+	long num_steals;
+};
+
+#endif /* TASK_POOL_H_ */
@@ -0,0 +1,226 @@
+/*
+ * tile_pipeline.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "tile_pipeline.h"
+#include "hue_kernel.h"
+#include "pixel_kernels.h"
+#include "cv_handles.h"
+#include "trace.h"
+
+#include <cstdio>
+#include <algorithm>
+
+using namespace std;
+
+static const char *stage_names[] = {
+	"convert", "split", "backproject", "threshold", "morphology"
+};
+
+// per worker buffers, big enough for a tile plus its halo
+struct TilePipeline::Scratch {
+	Image hsv, hue, bp;
+	// open_close_3x3's scratch
+	Image morph_tmp;
+};
+
+// what run() hands to the tasks
+struct TilePipeline::TileJob {
+	TilePipeline *self;
+	const IplImage *bgr;
+	IplImage *mask;
+	IplImage *raw;
+	int cols;
+};
+
+void TilePipeline::init(int _threshold, int _close_itr, int _kernel_size) {
+	threshold = _threshold;
+	close_itr = _close_itr;
+	kernel_size = _kernel_size;
+	// same rect HandDetector makes for other sizes
+	if(kernel_size != 3) {
+		kernel = cvCreateStructuringElementEx(kernel_size, kernel_size,
+				kernel_size/2, kernel_size/2, CV_SHAPE_RECT);
+	}
+	// open = erode + dilate, close = dilate + erode, each itr times the kernel
+	halo_px = 4 * close_itr * (kernel_size / 2);
+	scratch.resize(pool->size(), (Scratch *)NULL);
+}
+
+TilePipeline::~TilePipeline() {
+	for(size_t i=0; i<scratch.size(); i++) {
+		delete scratch[i];
+	}
+	if(kernel) {
+		cvReleaseStructuringElement(&kernel);
+	}
+}
+
+void TilePipeline::set_hist(const CvHistogram *hist) {
+	hue_lut.build(hist);
+}
+
+void TilePipeline::set_lut(const HueSatLut *_lut) {
+	lut = _lut;
+}
+
+TilePipeline::Scratch* TilePipeline::scratch_for(int worker) {
+	Scratch *s = scratch[worker];
+	if(!s) {
+		CvSize size = cvSize(tile_w + 2*halo_px, tile_h + 2*halo_px);
+		s = new Scratch();
+		s->hsv.ensure(size, 8, 3);
+		s->hue.ensure(size, 8, 1);
+		s->bp.ensure(size, 8, 1);
+		s->morph_tmp.ensure(size, 8, 1);
+		scratch[worker] = s;
+	}
+	return s;
+}
+
+// header onto part of img's pixels, no copying and no touching img's ROI
+// (other workers are reading img at the same time)
+static IplImage* sub_image(IplImage *hdr, const IplImage *img, CvRect r) {
+	cvInitImageHeader(hdr, cvSize(r.width, r.height), img->depth, img->nChannels);
+	cvSetData(hdr, img->imageData + r.y * img->widthStep + r.x * img->nChannels,
+			img->widthStep);
+	return hdr;
+}
+
+void TilePipeline::run(const IplImage *bgr, IplImage *mask, IplImage *raw) {
+	int cols = (bgr->width + tile_w - 1) / tile_w;
+	int rows = (bgr->height + tile_h - 1) / tile_h;
+	int num_tiles = cols * rows;
+	if((int)tile_ticks.size() < num_tiles) {
+		tile_ticks.resize(num_tiles, 0);
+		for(int s=0; s<NUM_STAGES; s++) {
+			stage_ticks[s].resize(num_tiles, 0);
+		}
+	}
+	TileJob job;
+	job.self = this;
+	job.bgr = bgr;
+	job.mask = mask;
+	job.raw = raw;
+	job.cols = cols;
+
+	int64 t = cvGetTickCount();
+	pool->run(run_tile, &job, num_tiles);
+	wall_ticks += cvGetTickCount() - t;
+	frames++;
+}
+
+void TilePipeline::run_tile(void *arg, int task, int worker) {
+	TileJob *job = (TileJob *)arg;
+	job->self->process_tile(*job, task, worker);
+}
+
+void TilePipeline::process_tile(const TileJob& job, int task, int worker) {
+	int64 t_start = cvGetTickCount();
+	int64 t = t_start, now;
+	Scratch *s = scratch_for(worker);
+	const IplImage *bgr = job.bgr;
+
+	// interior of the tile, then grown by the halo and clipped to the frame
+	int tx = (task % job.cols) * tile_w;
+	int ty = (task / job.cols) * tile_h;
+	CvRect inner = cvRect(tx, ty, min(tile_w, bgr->width - tx), min(tile_h, bgr->height - ty));
+	int x1 = max(0, inner.x - halo_px);
+	int y1 = max(0, inner.y - halo_px);
+	int x2 = min(bgr->width, inner.x + inner.width + halo_px);
+	int y2 = min(bgr->height, inner.y + inner.height + halo_px);
+	CvRect outer = cvRect(x1, y1, x2 - x1, y2 - y1);
+	// where the interior sits inside the scratch buffers
+	CvRect inner_local = cvRect(inner.x - x1, inner.y - y1, inner.width, inner.height);
+
+	IplImage src_hdr, hsv_hdr, hue_hdr, bp_hdr, tmp_hdr, out_hdr;
+	IplImage *src = sub_image(&src_hdr, bgr, outer);
+	CvRect local = cvRect(0, 0, outer.width, outer.height);
+	IplImage *hsv = sub_image(&hsv_hdr, s->hsv, local);
+	IplImage *hue = sub_image(&hue_hdr, s->hue, local);
+	IplImage *bp = sub_image(&bp_hdr, s->bp, local);
+
+	if(lut) {
+		cvCvtColor(src, hsv, CV_BGR2HSV);
+		now = cvGetTickCount();
+		stage_ticks[CONVERT][task] += now - t;
+		trace_span("colour conversion", t, now, task);
+		t = now;
+
+		// the table reads straight from hsv
+		lut->backproject(hsv, bp);
+		now = cvGetTickCount();
+		stage_ticks[BACKPROJECT][task] += now - t;
+		trace_span("backprojection", t, now, task);
+		t = now;
+	} else {
+		// hue only, straight from bgr -- convert and split in one, no split stage
+		bgr_to_hue(src, hue);
+		now = cvGetTickCount();
+		stage_ticks[CONVERT][task] += now - t;
+		trace_span("colour conversion", t, now, task);
+		t = now;
+
+		hue_lut.backproject(hue, bp);
+		now = cvGetTickCount();
+		stage_ticks[BACKPROJECT][task] += now - t;
+		trace_span("backprojection", t, now, task);
+		t = now;
+	}
+
+	if(job.raw) {
+		IplImage bp_inner_hdr;
+		cvCopy(sub_image(&bp_inner_hdr, bp, inner_local), sub_image(&out_hdr, job.raw, inner));
+	}
+
+	threshold_binary(bp, bp, threshold);
+	now = cvGetTickCount();
+	stage_ticks[THRESHOLD][task] += now - t;
+	t = now;
+
+	if(kernel) {
+		cvMorphologyEx(bp, bp, 0, kernel, CV_MOP_OPEN, close_itr);
+		cvMorphologyEx(bp, bp, 0, kernel, CV_MOP_CLOSE, close_itr);
+	} else {
+		open_close_3x3(bp, close_itr, sub_image(&tmp_hdr, s->morph_tmp, local));
+	}
+	// only the interior is right, the halo saw the tile edge as the border
+	IplImage bp_inner_hdr;
+	cvCopy(sub_image(&bp_inner_hdr, bp, inner_local), sub_image(&out_hdr, job.mask, inner));
+	now = cvGetTickCount();
+	stage_ticks[MORPHOLOGY][task] += now - t;
+	trace_span("morphology", t, now, task);
+
+	tile_ticks[task] += now - t_start;
+}
+
+void TilePipeline::print_timing() const {
+	if(frames == 0) {
+		return;
+	}
+	int num_tiles = (int)tile_ticks.size();
+	printf("TilePipeline: %d tiles of %dx%d (+%d halo), %d workers, %ld frames\n",
+			num_tiles, tile_w, tile_h, halo_px, pool->size(), frames);
+	for(int s=0; s<NUM_STAGES; s++) {
+		int64 total = 0;
+		for(int i=0; i<num_tiles; i++) {
+			total += stage_ticks[s][i];
+		}
+		printf("  %-12s %.4f ms/tile\n", stage_names[s],
+				ticks_to_ms(total) / frames / num_tiles);
+	}
+	int64 sum = 0, worst = 0;
+	int worst_tile = 0;
+	for(int i=0; i<num_tiles; i++) {
+		sum += tile_ticks[i];
+		if(tile_ticks[i] > worst) {
+			worst = tile_ticks[i];
+			worst_tile = i;
+		}
+	}
+	printf("  slowest tile %d: %.4f ms/frame\n", worst_tile, ticks_to_ms(worst) / frames);
+	printf("  tile time %.3f ms/frame, wall %.3f ms/frame, %ld steals\n",
+			ticks_to_ms(sum) / frames, ticks_to_ms(wall_ticks) / frames, pool->steals());
+}
@@ -0,0 +1,95 @@
+/*
+ * tile_pipeline.h
+ *
+ * Runs the per-pixel stages of the main loop -- BGR to HSV, split, backprojection,
+ * threshold, open and close -- tile by tile instead of streaming the whole frame
+ * through memory once per stage.  Each tile goes through all the stages back to back
+ * while it is still in cache, and the tiles are spread over a TaskPool.
+ *
+ * Morphology needs neighbours, so each tile is processed with a halo of extra pixels
+ * around it (4 * close_itr * kernel radius: erode + dilate for the open, dilate +
+ * erode for the close) and only the interior is written out.  Threshold, close_itr and
+ * kernel size come from the detector's config, so the output is exactly what
+ * HandDetector::clean would give on the whole frame.
+ *
+ * With a hue histogram, convert and split are one pass of bgr_to_hue (hue_kernel.h)
+ * and the split stage stays empty.  Backprojection, threshold and morphology go
+ * through the SIMD kernels (pixel_kernels.h).
+ *
+ * Per tile per stage timings are kept so cache effects show up, see print_timing().
+ * Implementation in tile_pipeline.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef TILE_PIPELINE_H_
+#define TILE_PIPELINE_H_
+
+#include "cv.h"
+#include <vector>
+
+#include "task_pool.h"
+#include "skin_lut.h"
+
+class TilePipeline {
+public:
+	enum Stage { CONVERT, SPLIT, BACKPROJECT, THRESHOLD, MORPHOLOGY, NUM_STAGES };
+
+	// pool -- not owned, tile_w x tile_h -- interior size of each tile
+	// cfg -- the HandDetector config (DefaultHandConfig, RuntimeHandConfig) whose
+	// threshold, close_itr and kernel_size the tiles are cleaned with
+	template <class Config>
+	TilePipeline(TaskPool *_pool, const Config& cfg, int _tile_w = 160, int _tile_h = 120)
+	: pool(_pool), tile_w(_tile_w), tile_h(_tile_h), kernel(NULL), lut(NULL),
+	  wall_ticks(0), frames(0)
+	{
+		init(cfg.threshold, cfg.close_itr, cfg.kernel_size);
+	}
+	// owns its scratch and structuring element
+	TilePipeline(const TilePipeline&) = delete;
+	TilePipeline& operator=(const TilePipeline&) = delete;
+	~TilePipeline();
+
+	// backproject with a 1D hue histogram (expanded into a HueLut, not kept)
+	void set_hist(const CvHistogram *hist);
+	// or with a hue/sat table (not owned), takes precedence over the histogram
+	void set_lut(const HueSatLut *lut);
+
+	// bgr -- 3 channel frame, mask -- 1 channel output, ready for HandDetector::find
+	// raw -- [NULL] if not null, gets the backprojection before threshold/morphology
+	void run(const IplImage *bgr, IplImage *mask, IplImage *raw = NULL);
+
+	// per stage average ms per tile, slowest tile, and summed tile time vs wall time
+	// since construction
+	void print_timing() const;
+
+	int halo() const { return halo_px; }
+
+private:
+	struct Scratch;
+	struct TileJob;
+	static void run_tile(void *arg, int task, int worker);
+	void process_tile(const TileJob& job, int task, int worker);
+	Scratch* scratch_for(int worker);
+	void init(int threshold, int close_itr, int kernel_size);
+
+	TaskPool *pool;
+	int tile_w, tile_h;
+	int threshold;
+	int close_itr;
+	int kernel_size;
+	// NULL for the 3x3 kernel, which goes through open_close_3x3
+	IplConvKernel *kernel;
+	int halo_px;
+	HueLut hue_lut;
+	const HueSatLut *lut;
+	std::vector<Scratch*> scratch;
+
+	// timings, one slot per tile, each only touched by whoever runs that tile
+	std::vector<int64> stage_ticks[NUM_STAGES];
+	std::vector<int64> tile_ticks;
+	int64 wall_ticks;
+	long frames;
+};
+
+#endif /* TILE_PIPELINE_H_ */
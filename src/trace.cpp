@@ -0,0 +1,196 @@
+/*
+ * trace.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "trace.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+//******* unix/linux only for thread ids
+#include <unistd.h>
+#include <sys/syscall.h>
+
+using namespace std;
+
+double ticks_to_ms(int64 ticks) {
+	// cvGetTickFrequency is ticks per microsecond
+	return ticks / (cvGetTickFrequency() * 1000.);
+}
+
+// threads that can record, more than this and the rest go unrecorded
+#define MAX_TRACE_THREADS 256
+
+struct TraceEvent {
+	int64 start, end;
+	const char *name;
+	long frame;
+	int arg;
+};
+
+// one per thread, only that thread writes
+struct TraceBuffer {
+	int tid;
+	char name[32];
+	vector<TraceEvent> ring;
+	// events ever written, ring[written % size] is next
+	volatile unsigned long written;
+};
+
+volatile bool g_trace_on = false;
+
+static int trace_window = 0;
+static int trace_capacity = 0;
+static volatile long trace_current_frame = 0;
+static TraceBuffer *trace_buffers[MAX_TRACE_THREADS];
+static int trace_num_buffers = 0;
+static __thread TraceBuffer *trace_own = NULL;
+// set for threads past MAX_TRACE_THREADS so they stop trying
+static __thread bool trace_untracked = false;
+
+void enable_trace(int window, int events_per_thread) {
+	trace_window = max(window, 1);
+	trace_capacity = max(events_per_thread, 16);
+	g_trace_on = true;
+}
+
+void trace_frame(long frame) {
+	trace_current_frame = frame;
+}
+
+// the calling thread's buffer, registered the first time
+static TraceBuffer* own_buffer() {
+	if(trace_own || trace_untracked) {
+		return trace_own;
+	}
+	int slot = __sync_fetch_and_add(&trace_num_buffers, 1);
+	if(slot >= MAX_TRACE_THREADS) {
+		trace_untracked = true;
+		return NULL;
+	}
+	TraceBuffer *b = new TraceBuffer();
+	b->tid = (int)syscall(SYS_gettid);
+	snprintf(b->name, sizeof(b->name), "thread %d", b->tid);
+	b->ring.resize(trace_capacity);
+	b->written = 0;
+	trace_own = b;
+	// published only once it's whole
+	__sync_synchronize();
+	trace_buffers[slot] = b;
+	return b;
+}
+
+void trace_thread_name(const char *name, int n) {
+	if(!g_trace_on) {
+		return;
+	}
+	TraceBuffer *b = own_buffer();
+	if(!b) {
+		return;
+	}
+	if(n >= 0) {
+		snprintf(b->name, sizeof(b->name), "%s %d", name, n);
+	} else {
+		snprintf(b->name, sizeof(b->name), "%s", name);
+	}
+}
+
+void trace_span(const char *name, int64 start, int64 end, int arg) {
+	if(!g_trace_on) {
+		return;
+	}
+	TraceBuffer *b = own_buffer();
+	if(!b) {
+		return;
+	}
+	TraceEvent& e = b->ring[b->written % b->ring.size()];
+	e.start = start;
+	e.end = end;
+	e.name = name;
+	e.frame = trace_current_frame;
+	e.arg = arg;
+	// the event is in place before the count says so
+	__sync_synchronize();
+	b->written = b->written + 1;
+}
+
+// escapes the few characters a thread or event name could hold
+static void write_json_str(FILE *out, const char *s) {
+	fputc('"', out);
+	for(; *s; s++) {
+		if(*s == '"' || *s == '\\') {
+			fputc('\\', out);
+		}
+		fputc(*s, out);
+	}
+	fputc('"', out);
+}
+
+bool write_trace(const char *path) {
+	if(!g_trace_on) {
+		return false;
+	}
+	FILE *out = fopen(path, "w");
+	if(!out) {
+		fprintf(stderr, "trace: can't open %s\n", path);
+		return false;
+	}
+	long last = trace_current_frame;
+	long first = last - trace_window + 1;
+	int n = min(trace_num_buffers, MAX_TRACE_THREADS);
+
+	// times from the window's first event
+	int64 base = 0;
+	for(int pass=0; pass<2; pass++) {
+		long events = 0;
+		if(pass == 1) {
+			fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+		}
+		for(int i=0; i<n; i++) {
+			TraceBuffer *b = trace_buffers[i];
+			if(!b) {
+				continue;
+			}
+			if(pass == 1) {
+				fprintf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+						"\"args\":{\"name\":", events++ ? ",\n" : "", b->tid);
+				write_json_str(out, b->name);
+				fprintf(out, "}}");
+			}
+			unsigned long written = b->written;
+			__sync_synchronize();
+			unsigned long size = b->ring.size();
+			unsigned long from = written > size ? written - size : 0;
+			for(unsigned long k=from; k<written; k++) {
+				const TraceEvent& e = b->ring[k % size];
+				if(e.frame < first || e.frame > last) {
+					continue;
+				}
+				if(pass == 0) {
+					if(!base || e.start < base) {
+						base = e.start;
+					}
+					continue;
+				}
+				fprintf(out, ",\n{\"name\":");
+				write_json_str(out, e.name);
+				fprintf(out, ",\"cat\":\"fingershooter\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+						"\"pid\":1,\"tid\":%d,\"args\":{\"frame\":%ld",
+						ticks_to_ms(e.start - base) * 1000., ticks_to_ms(e.end - e.start) * 1000.,
+						b->tid, e.frame);
+				if(e.arg >= 0) {
+					fprintf(out, ",\"index\":%d", e.arg);
+				}
+				fprintf(out, "}}");
+			}
+		}
+	}
+	fprintf(out, "\n]}\n");
+	fclose(out);
+	printf("trace: frames %ld to %ld written to %s\n", max(first, 0L), last, path);
+	return true;
+}
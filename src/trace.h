@@ -0,0 +1,81 @@
+/*
+ * trace.h
+ *
+ * Timeline of what every thread was doing, frame by frame, for the stalls the
+ * aggregate timings average away -- a pool worker idle while another finishes a big
+ * contour, the main thread waiting on the writer.  With --trace N, the pipeline's
+ * steps record begin / end times:
+ *
+ * 	capture, colour conversion, backprojection, morphology, contour scan, each
+ * 	contour's hull and defects, fire, bullet update and draw, display, video write,
+ * 	and the main thread waiting on the TaskPool
+ *
+ * into a ring per thread.  Each ring has one writer, so recording takes no lock and
+ * no atomic read-modify-write, only a barrier before the count is bumped.  The last N
+ * frames are written out as Chrome trace JSON on the 't' key and at exit, to open in
+ * chrome://tracing or ui.perfetto.dev.  Rings are read while the pool is idle between
+ * frames, so their writers are quiet.
+ *
+ * Off, a TraceScope is one test of a flag.
+ * Implementation in trace.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include "cv.h"
+
+// set by enable_trace
+extern volatile bool g_trace_on;
+
+// starts recording, window -- frames write_trace writes out
+// events_per_thread -- ring size, the oldest events go first when it's full
+void enable_trace(int window, int events_per_thread = 1 << 16);
+
+// main loop, the frame events from now on belong to
+void trace_frame(long frame);
+
+// names the calling thread in the trace, with n appended if n >= 0
+void trace_thread_name(const char *name, int n = -1);
+
+// records name from start to end (cvGetTickCount times) on the calling thread
+// arg -- [-1] if not -1, shown with the event, eg the contour or tile index
+// name must outlive the trace, ie a string literal
+void trace_span(const char *name, int64 start, int64 end, int arg = -1);
+
+// the last window frames' events as Chrome trace JSON, false if path can't be written
+bool write_trace(const char *path);
+
+// converts a cvGetTickCount difference to ms
+double ticks_to_ms(int64 ticks);
+
+// records its own lifetime
+class TraceScope {
+public:
+	TraceScope(const char *name, int arg = -1)
+	: name(name), arg(arg), start(g_trace_on ? cvGetTickCount() : 0)
+	{}
+	~TraceScope() {
+		if(start) {
+			trace_span(name, start, cvGetTickCount(), arg);
+		}
+	}
+
+private:
+	TraceScope(const TraceScope&);
+	TraceScope& operator=(const TraceScope&);
+
+	const char *name;
+	int arg;
+	int64 start;
+};
+
+#define TRACE_CAT2(a, b) a##b
+#define TRACE_CAT(a, b) TRACE_CAT2(a, b)
+// traces the rest of the enclosing block
+#define TRACE_SCOPE(name) TraceScope TRACE_CAT(trace_scope_, __LINE__)(name)
+#define TRACE_SCOPE_ARG(name, arg) TraceScope TRACE_CAT(trace_scope_, __LINE__)(name, arg)
+
+#endif /* TRACE_H_ */
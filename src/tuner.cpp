@@ -0,0 +1,755 @@
+/*
+ * tuner.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "tuner.h"
+#include "benchmarks.h"
+#include "hue_kernel.h"
+#include "skin_lut.h"
+#include "task_pool.h"
+
+#include "highgui.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <map>
+
+//******* unix/linux only for the cache mapping
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+const char *DEFAULT_TUNE_GRID =
+		"threshold=10,15,25:close_itr=1,2:perim_scale=4,6,8:depth_pct=20,25,30:"
+		"proximity_pct=20,30:shape_tolerance_pct=0,25";
+
+// written last, so a cache that was never finished doesn't match
+#define CACHE_MAGIC "FSTUNE1"
+// masks start on a cache line
+#define CACHE_ALIGN 64
+// a hand reported where there is none would fire from about this many tips
+#define FALSE_HAND_TIPS 5
+
+struct TuneCacheHeader {
+	char magic[8];
+	unsigned long long key;
+	int width, height, frames, masked;
+	double backproject_ms;
+};
+
+enum Knob {
+	KNOB_THRESHOLD, KNOB_CLOSE_ITR, KNOB_KERNEL_SIZE, KNOB_PERIM_SCALE, KNOB_TOO_SMALL_DIV,
+	KNOB_DEPTH_PCT, KNOB_MIN_FINGERS, KNOB_MAX_FINGERS, KNOB_PROXIMITY_PCT,
+	KNOB_APPROX_PERMILLE, KNOB_REFINE_DEPTH, KNOB_SHAPE_TOLERANCE_PCT, NUM_KNOBS
+};
+
+static const char *knob_names[] = {
+	"threshold", "close_itr", "kernel_size", "perim_scale", "too_small_div", "depth_pct",
+	"min_fingers", "max_fingers", "proximity_pct", "approx_permille", "refine_depth",
+	"shape_tolerance_pct"
+};
+// short forms for the table
+static const char *knob_columns[] = {
+	"thr", "close", "kern", "perim", "small", "depth", "minf", "maxf", "prox", "approx",
+	"refine", "shape"
+};
+
+static double get_knob(const TuneParams& p, int k) {
+	const RuntimeHandConfig& c = p.cfg;
+	switch(k) {
+	case KNOB_THRESHOLD: return c.threshold;
+	case KNOB_CLOSE_ITR: return c.close_itr;
+	case KNOB_KERNEL_SIZE: return c.kernel_size;
+	case KNOB_PERIM_SCALE: return p.perim_scale;
+	case KNOB_TOO_SMALL_DIV: return c.too_small_div;
+	case KNOB_DEPTH_PCT: return c.depth_pct;
+	case KNOB_MIN_FINGERS: return c.min_fingers;
+	case KNOB_MAX_FINGERS: return c.max_fingers;
+	case KNOB_PROXIMITY_PCT: return c.proximity_pct;
+	case KNOB_APPROX_PERMILLE: return c.approx_permille;
+	case KNOB_REFINE_DEPTH: return c.refine_depth;
+	case KNOB_SHAPE_TOLERANCE_PCT: return c.shape_tolerance_pct;
+	}
+	return 0;
+}
+
+// false if v is out of the knob's range
+static bool set_knob(TuneParams& p, int k, double v) {
+	RuntimeHandConfig& c = p.cfg;
+	int i = (int)v;
+	switch(k) {
+	case KNOB_THRESHOLD: c.threshold = i; return i >= 0 && i < 255;
+	case KNOB_CLOSE_ITR: c.close_itr = i; return i >= 0;
+	case KNOB_KERNEL_SIZE: c.kernel_size = i; return i >= 1;
+	case KNOB_PERIM_SCALE: p.perim_scale = (float)v; return v > 0;
+	case KNOB_TOO_SMALL_DIV: c.too_small_div = i; return i >= 1;
+	case KNOB_DEPTH_PCT: c.depth_pct = i; return i >= 0;
+	case KNOB_MIN_FINGERS: c.min_fingers = i; return i >= 0 && i <= HAND_MAX_DEFECTS;
+	case KNOB_MAX_FINGERS: c.max_fingers = i; return i >= 0 && i <= HAND_MAX_DEFECTS;
+	case KNOB_PROXIMITY_PCT: c.proximity_pct = i; return i >= 0;
+	case KNOB_APPROX_PERMILLE: c.approx_permille = i; return i >= 0;
+	case KNOB_REFINE_DEPTH: c.refine_depth = i != 0; return true;
+	case KNOB_SHAPE_TOLERANCE_PCT: c.shape_tolerance_pct = i; return i >= 0;
+	}
+	return false;
+}
+
+// sets with the same mask cleaning knobs share the cleaned mask
+static bool same_cleaning(const TuneParams& a, const TuneParams& b) {
+	return a.cfg.threshold == b.cfg.threshold && a.cfg.close_itr == b.cfg.close_itr &&
+			a.cfg.kernel_size == b.cfg.kernel_size;
+}
+
+// set indices by their cleaning knobs
+struct CleaningOrder {
+	CleaningOrder(const vector<TuneParams>& sets) : sets(sets) {}
+	bool operator()(int i, int j) const {
+		const RuntimeHandConfig& a = sets[i].cfg;
+		const RuntimeHandConfig& b = sets[j].cfg;
+		if(a.threshold != b.threshold) {
+			return a.threshold < b.threshold;
+		}
+		if(a.close_itr != b.close_itr) {
+			return a.close_itr < b.close_itr;
+		}
+		return a.kernel_size < b.kernel_size;
+	}
+	const vector<TuneParams>& sets;
+};
+
+static bool is_default(const TuneParams& p) {
+	TuneParams d;
+	for(int k=0; k<NUM_KNOBS; k++) {
+		if(get_knob(p, k) != get_knob(d, k)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+double TuneResult::accuracy() const {
+	long truth_tips = 0;
+	for(int f=0; f<6; f++) {
+		truth_tips += (long)score.hands[f] * f;
+	}
+	long matched = score.tips_matched;
+	long wrong = score.tips_false + (long)score.false_hands * FALSE_HAND_TIPS;
+	long missed = truth_tips - matched;
+	long denom = 2 * matched + wrong + missed;
+	return denom ? 2. * matched / denom : 1.;
+}
+
+double TuneResult::frame_ms(double backproject_ms) const {
+	return frames ? backproject_ms + (clean_ms + find_ms) / frames : 0;
+}
+
+bool parse_tune_grid(const char *spec, vector<TuneParams>& sets) {
+	sets.assign(1, TuneParams());
+	vector<char> buf(spec, spec + strlen(spec) + 1);
+	char *save = NULL;
+	for(char *part=strtok_r(&buf[0], ":", &save); part; part=strtok_r(NULL, ":", &save)) {
+		char *values = strchr(part, '=');
+		if(!values) {
+			return false;
+		}
+		*values++ = 0;
+		int k = 0;
+		while(k < NUM_KNOBS && strcmp(part, knob_names[k]) != 0) {
+			k++;
+		}
+		if(k == NUM_KNOBS) {
+			return false;
+		}
+		// every set so far times every value
+		vector<TuneParams> grown;
+		const char *s = values;
+		while(*s) {
+			char *end;
+			double v = strtod(s, &end);
+			if(end == s || (*end != ',' && *end != 0)) {
+				return false;
+			}
+			for(size_t i=0; i<sets.size(); i++) {
+				TuneParams p = sets[i];
+				if(!set_knob(p, k, v)) {
+					return false;
+				}
+				grown.push_back(p);
+			}
+			s = *end ? end + 1 : end;
+		}
+		if(grown.empty()) {
+			return false;
+		}
+		sets.swap(grown);
+	}
+	// finger windows that can't match anything
+	size_t kept = 0;
+	for(size_t i=0; i<sets.size(); i++) {
+		if(sets[i].cfg.min_fingers <= sets[i].cfg.max_fingers) {
+			sets[kept++] = sets[i];
+		}
+	}
+	sets.resize(kept);
+	return !sets.empty();
+}
+
+TuneCorpus::TuneCorpus()
+: synth(false), map(NULL), map_bytes(0), size_(cvSize(0, 0)), valid(NULL), masks(NULL),
+  header(NULL)
+{}
+
+TuneCorpus::~TuneCorpus() {
+	if(map) {
+		munmap(map, map_bytes);
+	}
+}
+
+bool TuneCorpus::load_labels(const char *path) {
+	FILE *f = fopen(path, "r");
+	if(!f) {
+		fprintf(stderr, "tune: can't open labels %s\n", path);
+		return false;
+	}
+	// sorted by file then frame, so the cache reads each file front to back once
+	std::map<pair<string, int>, vector<SynthHand> > labelled;
+	char line[4096];
+	int line_no = 0;
+	bool ok = true;
+	while(ok && fgets(line, sizeof(line), f)) {
+		line_no++;
+		char *hash = strchr(line, '#');
+		if(hash) {
+			*hash = 0;
+		}
+		char *save = NULL;
+		char *file = strtok_r(line, " \t\r\n", &save);
+		if(!file) {
+			continue;
+		}
+		char *frame = strtok_r(NULL, " \t\r\n", &save);
+		vector<int> nums;
+		for(char *tok=strtok_r(NULL, " \t\r\n", &save); tok; tok=strtok_r(NULL, " \t\r\n", &save)) {
+			char *end;
+			nums.push_back((int)strtol(tok, &end, 10));
+			if(*end) {
+				ok = false;
+			}
+		}
+		char *end = NULL;
+		int index = frame ? (int)strtol(frame, &end, 10) : -1;
+		// center, scale and 1 to 5 tips
+		int num_tips = ((int)nums.size() - 3) / 2;
+		if(!frame || *end || index < 0 || (!nums.empty() &&
+				(nums.size() % 2 == 0 || num_tips < 1 || num_tips > 5))) {
+			ok = false;
+		}
+		if(!ok) {
+			fprintf(stderr, "tune: %s:%d doesn't parse\n", path, line_no);
+			break;
+		}
+		vector<SynthHand>& hands = labelled[make_pair(string(file), index)];
+		if(nums.empty()) {
+			continue;
+		}
+		SynthHand h;
+		h.center = cvPoint(nums[0], nums[1]);
+		h.scale = nums[2];
+		h.angle = 0;
+		h.num_fingers = num_tips;
+		for(int t=0; t<num_tips; t++) {
+			h.tips[t] = cvPoint(nums[3 + 2 * t], nums[4 + 2 * t]);
+		}
+		// as SynthScene's palm plus a finger
+		h.radius = h.scale * 7 / 10;
+		hands.push_back(h);
+	}
+	fclose(f);
+	if(!ok) {
+		return false;
+	}
+	for(std::map<pair<string, int>, vector<SynthHand> >::iterator it=labelled.begin();
+			it != labelled.end(); ++it) {
+		Frame fr;
+		fr.file = it->first.first;
+		fr.index = it->first.second;
+		fr.truth = it->second;
+		frames.push_back(fr);
+	}
+	if(frames.empty()) {
+		fprintf(stderr, "tune: no labelled frames in %s\n", path);
+		return false;
+	}
+	return true;
+}
+
+void TuneCorpus::add_synth(int n) {
+	synth = true;
+	synth_base = SynthParams();
+	synth_base.min_fingers = 3;
+	synth_base.max_fingers = 5;
+	synth_base.num_clutter = 3;
+	synth_base.num_decoys = 1;
+	synth_base.bgr_noise = 6;
+	for(int i=0; i<n; i++) {
+		SynthParams p = synth_base;
+		p.seed = synth_base.seed + i;
+		Frame fr;
+		fr.index = (int)p.seed;
+		fr.truth = SynthScene(p).hands();
+		frames.push_back(fr);
+	}
+}
+
+// FNV-1a
+static void hash_bytes(unsigned long long& h, const void *data, size_t n) {
+	const uchar *p = (const uchar *)data;
+	for(size_t i=0; i<n; i++) {
+		h = (h ^ p[i]) * 1099511628211ULL;
+	}
+}
+
+unsigned long long TuneCorpus::cache_key(const Histogram& hist) const {
+	unsigned long long h = 14695981039346656037ULL;
+	int bins = 0;
+	cvGetDims(hist->bins, &bins);
+	for(int b=0; b<bins; b++) {
+		float v = cvQueryHistValue_1D(hist, b);
+		hash_bytes(h, &v, sizeof(v));
+	}
+	if(synth) {
+		const SynthParams& p = synth_base;
+		int ints[] = { p.size.width, p.size.height, p.num_hands, p.min_fingers,
+				p.max_fingers, p.min_scale, p.max_scale, p.num_clutter, p.num_decoys };
+		double reals[] = { p.max_angle, p.mask_noise, p.bgr_noise };
+		hash_bytes(h, ints, sizeof(ints));
+		hash_bytes(h, reals, sizeof(reals));
+	}
+	for(size_t i=0; i<frames.size(); i++) {
+		hash_bytes(h, frames[i].file.c_str(), frames[i].file.size() + 1);
+		hash_bytes(h, &frames[i].index, sizeof(frames[i].index));
+	}
+	return h;
+}
+
+// header, a valid byte per frame, then the masks
+static size_t mask_offset(int frames) {
+	size_t off = sizeof(TuneCacheHeader) + frames;
+	return (off + CACHE_ALIGN - 1) / CACHE_ALIGN * CACHE_ALIGN;
+}
+
+bool TuneCorpus::probe_size() {
+	if(synth) {
+		size_ = synth_base.size;
+		return true;
+	}
+	for(size_t i=0; i<frames.size(); i++) {
+		if(i > 0 && frames[i].file == frames[i-1].file) {
+			continue;
+		}
+		CvCapture *capture = cvCreateFileCapture(frames[i].file.c_str());
+		IplImage *image = capture ? cvQueryFrame(capture) : NULL;
+		if(image) {
+			size_ = cvGetSize(image);
+		}
+		cvReleaseCapture(&capture);
+		if(image) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// one frame's raw backprojection into out, rows packed
+static int64 backproject_into(const IplImage *bgr, IplImage *hue, IplImage *backproject,
+		const Histogram& hist, uchar *out) {
+	int64 start = cvGetTickCount();
+	bgr_to_hue(bgr, hue);
+	cvCalcBackProject(&hue, backproject, hist);
+	int64 ticks = cvGetTickCount() - start;
+	for(int y=0; y<backproject->height; y++) {
+		memcpy(out + y * backproject->width,
+				backproject->imageData + y * backproject->widthStep, backproject->width);
+	}
+	return ticks;
+}
+
+int TuneCorpus::fill_cache(uchar *valid_out, uchar *masks_out, const Histogram& hist,
+		double *ms) {
+	Image hue(size_, 8, 1), backproject(size_, 8, 1);
+	size_t frame_bytes = (size_t)size_.width * size_.height;
+	int64 ticks = 0;
+	int done = 0;
+	if(synth) {
+		Image bgr(size_, 8, 3);
+		for(size_t i=0; i<frames.size(); i++) {
+			SynthParams p = synth_base;
+			p.seed = (unsigned)frames[i].index;
+			SynthScene(p).render(NULL, bgr);
+			ticks += backproject_into(bgr, hue, backproject, hist, masks_out + i * frame_bytes);
+			valid_out[i] = 1;
+			done++;
+		}
+	} else {
+		CvCapture *capture = NULL;
+		// frames read from capture so far
+		int pos = 0;
+		IplImage *image = NULL;
+		for(size_t i=0; i<frames.size(); i++) {
+			const Frame& fr = frames[i];
+			if(i == 0 || fr.file != frames[i-1].file) {
+				cvReleaseCapture(&capture);
+				capture = cvCreateFileCapture(fr.file.c_str());
+				pos = 0;
+				image = NULL;
+				if(!capture) {
+					fprintf(stderr, "tune: can't open %s\n", fr.file.c_str());
+				}
+			}
+			// labels are sorted, so it only ever reads forward
+			while(capture && pos <= fr.index) {
+				image = cvQueryFrame(capture);
+				pos++;
+				if(!image) {
+					cvReleaseCapture(&capture);
+				}
+			}
+			if(!capture || !image) {
+				fprintf(stderr, "tune: %s frame %d not read\n", fr.file.c_str(), fr.index);
+				continue;
+			}
+			if(image->width != size_.width || image->height != size_.height) {
+				fprintf(stderr, "tune: %s frame %d isn't %dx%d, left out\n", fr.file.c_str(),
+						fr.index, size_.width, size_.height);
+				continue;
+			}
+			ticks += backproject_into(image, hue, backproject, hist,
+					masks_out + i * frame_bytes);
+			valid_out[i] = 1;
+			done++;
+		}
+		cvReleaseCapture(&capture);
+	}
+	*ms = done ? ticks_to_ms(ticks) / done : 0;
+	return done;
+}
+
+void TuneCorpus::attach(void *m, size_t bytes) {
+	map = m;
+	map_bytes = bytes;
+	header = (const TuneCacheHeader *)m;
+	size_ = cvSize(header->width, header->height);
+	valid = (const uchar *)m + sizeof(TuneCacheHeader);
+	masks = (const uchar *)m + mask_offset(header->frames);
+}
+
+bool TuneCorpus::map_cache(const char *cache_path, const Histogram& hist) {
+	unsigned long long key = cache_key(hist);
+	if(map) {
+		munmap(map, map_bytes);
+		map = NULL;
+	}
+	int n = size();
+
+	// already there from an earlier sweep
+	int fd = open(cache_path, O_RDONLY);
+	if(fd >= 0) {
+		TuneCacheHeader h;
+		struct stat st;
+		if(read(fd, &h, sizeof(h)) == (ssize_t)sizeof(h) &&
+				memcmp(h.magic, CACHE_MAGIC, sizeof(h.magic)) == 0 &&
+				h.key == key && h.frames == n && fstat(fd, &st) == 0) {
+			size_t bytes = mask_offset(n) + (size_t)h.width * h.height * n;
+			void *m = (size_t)st.st_size >= bytes ?
+					mmap(NULL, bytes, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+			if(m != MAP_FAILED) {
+				close(fd);
+				attach(m, bytes);
+				printf("tune: %d of %d frames' backprojections from %s\n", header->masked, n,
+						cache_path);
+				return true;
+			}
+		}
+		close(fd);
+	}
+
+	if(!probe_size()) {
+		fprintf(stderr, "tune: no frame could be read\n");
+		return false;
+	}
+	size_t bytes = mask_offset(n) + (size_t)size_.width * size_.height * n;
+	fd = open(cache_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if(fd < 0) {
+		fprintf(stderr, "tune: can't create cache %s\n", cache_path);
+		return false;
+	}
+	void *m = ftruncate(fd, bytes) == 0 ?
+			mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+	close(fd);
+	if(m == MAP_FAILED) {
+		fprintf(stderr, "tune: can't map cache %s\n", cache_path);
+		unlink(cache_path);
+		return false;
+	}
+	TuneCacheHeader *h = (TuneCacheHeader *)m;
+	memset(h, 0, sizeof(*h));
+	h->width = size_.width;
+	h->height = size_.height;
+	h->frames = n;
+	h->masked = fill_cache((uchar *)m + sizeof(TuneCacheHeader), (uchar *)m + mask_offset(n),
+			hist, &h->backproject_ms);
+	if(h->masked == 0) {
+		fprintf(stderr, "tune: no frame could be read\n");
+		munmap(m, bytes);
+		unlink(cache_path);
+		return false;
+	}
+	h->key = key;
+	msync(m, bytes, MS_SYNC);
+	memcpy(h->magic, CACHE_MAGIC, sizeof(h->magic));
+	// only read from here on
+	mprotect(m, bytes, PROT_READ);
+	attach(m, bytes);
+	printf("tune: backprojected %d of %d frames into %s, %.2f ms each\n", header->masked, n,
+			cache_path, header->backproject_ms);
+	return true;
+}
+
+bool TuneCorpus::has_mask(int i) const {
+	return valid && valid[i];
+}
+
+const uchar* TuneCorpus::mask(int i) const {
+	return masks + (size_t)i * size_.width * size_.height;
+}
+
+double TuneCorpus::backproject_ms() const {
+	return header ? header->backproject_ms : 0;
+}
+
+Histogram make_synth_hist(const SynthParams& p) {
+	SynthScene scene(p);
+	Image bgr(p.size, 8, 3);
+	scene.render(NULL, bgr);
+	// a square inside the first palm, or the middle if no hand fit
+	CvPoint center = cvPoint(p.size.width / 2, p.size.height / 2);
+	int side = p.min_scale / 5;
+	if(!scene.hands().empty()) {
+		center = scene.hands()[0].center;
+		side = scene.hands()[0].scale / 5;
+	}
+	CvRect selection = cvRect(center.x - side / 2, center.y - side / 2, side, side);
+
+	return calc_hue_hist(bgr, selection);
+}
+
+// per worker, every set's totals over the frames it took
+struct SweepWorker {
+	HandDetector<RuntimeHandConfig> detector;
+	Image cleaned, work;
+	vector<Hand> hands;
+	vector<TuneResult> results;
+};
+
+struct Sweep {
+	const TuneCorpus *corpus;
+	const vector<TuneParams> *sets;
+	// set indices grouped by cleaning, and the group being run
+	vector<int> order;
+	size_t first, last;
+	vector<SweepWorker*> workers;
+};
+
+// one frame: cleaned once for the group, searched once per set
+static void sweep_task(void *arg, int frame, int worker) {
+	Sweep *sw = (Sweep *)arg;
+	const TuneCorpus& corpus = *sw->corpus;
+	const vector<TuneParams>& sets = *sw->sets;
+	if(!corpus.has_mask(frame)) {
+		return;
+	}
+	if(!sw->workers[worker]) {
+		sw->workers[worker] = new SweepWorker();
+		sw->workers[worker]->results.resize(sets.size());
+	}
+	SweepWorker *w = sw->workers[worker];
+	CvSize size = corpus.frame_size();
+	w->cleaned.ensure(size, 8, 1);
+	w->work.ensure(size, 8, 1);
+	const uchar *mask = corpus.mask(frame);
+	for(int y=0; y<size.height; y++) {
+		memcpy(w->cleaned->imageData + y * w->cleaned->widthStep, mask + y * size.width,
+				size.width);
+	}
+
+	w->detector.cfg = sets[sw->order[sw->first]].cfg;
+	int64 start = cvGetTickCount();
+	w->detector.clean(w->cleaned);
+	// every set in the group would pay for the cleaning running on its own
+	double clean_ms = ticks_to_ms(cvGetTickCount() - start);
+
+	for(size_t k=sw->first; k<sw->last; k++) {
+		const TuneParams& p = sets[sw->order[k]];
+		TuneResult& r = w->results[sw->order[k]];
+		// the contour scanner scribbles on its mask
+		cvCopy(w->cleaned, w->work);
+		w->detector.cfg = p.cfg;
+		w->hands.clear();
+		start = cvGetTickCount();
+		w->detector.find(w->work, w->hands, p.perim_scale);
+		r.find_ms += ticks_to_ms(cvGetTickCount() - start);
+		r.clean_ms += clean_ms;
+		r.score.add(score_hands(corpus.truth(frame), w->hands));
+		r.frames++;
+	}
+}
+
+void run_sweep(const TuneCorpus& corpus, const vector<TuneParams>& sets,
+		int num_workers, vector<TuneResult>& results) {
+	TaskPool pool(num_workers);
+	Sweep sw;
+	sw.corpus = &corpus;
+	sw.sets = &sets;
+	for(size_t i=0; i<sets.size(); i++) {
+		sw.order.push_back((int)i);
+	}
+	// stable, so sets stay in grid order within a group
+	stable_sort(sw.order.begin(), sw.order.end(), CleaningOrder(sets));
+	sw.workers.assign(pool.size(), NULL);
+
+	int groups = 0;
+	int64 start = cvGetTickCount();
+	for(sw.first=0; sw.first<sw.order.size(); sw.first=sw.last) {
+		sw.last = sw.first + 1;
+		while(sw.last < sw.order.size() &&
+				same_cleaning(sets[sw.order[sw.first]], sets[sw.order[sw.last]])) {
+			sw.last++;
+		}
+		pool.run(sweep_task, &sw, corpus.size());
+		groups++;
+	}
+	double secs = ticks_to_ms(cvGetTickCount() - start) / 1000.;
+
+	results.assign(sets.size(), TuneResult());
+	for(size_t w=0; w<sw.workers.size(); w++) {
+		if(!sw.workers[w]) {
+			continue;
+		}
+		for(size_t s=0; s<sets.size(); s++) {
+			const TuneResult& r = sw.workers[w]->results[s];
+			results[s].score.add(r.score);
+			results[s].clean_ms += r.clean_ms;
+			results[s].find_ms += r.find_ms;
+			results[s].frames += r.frames;
+		}
+		delete sw.workers[w];
+	}
+	printf("tune: %d sets in %d cleaning groups over %d frames, %d workers, %.2f s\n",
+			(int)sets.size(), groups, corpus.size(), pool.size(), secs);
+}
+
+static void print_row(FILE *out, const TuneParams& p, const TuneResult& r, double bp_ms,
+		bool csv) {
+	long hands = 0, found = 0;
+	for(int f=0; f<6; f++) {
+		hands += r.score.hands[f];
+		found += r.score.hands_found[f];
+	}
+	double recall = hands ? (double)found / hands : 1.;
+	double false_rate = r.frames ? (double)r.score.false_hands / r.frames : 0;
+	if(csv) {
+		fprintf(out, "%.3f,%.4f,%.4f,%.4f", r.frame_ms(bp_ms), r.accuracy(), recall,
+				false_rate);
+		for(int k=0; k<NUM_KNOBS; k++) {
+			fprintf(out, ",%g", get_knob(p, k));
+		}
+		fprintf(out, "\n");
+		return;
+	}
+	fprintf(out, "  %8.3f %8.4f %6.3f %7.3f ", r.frame_ms(bp_ms), r.accuracy(), recall,
+			false_rate);
+	for(int k=0; k<NUM_KNOBS; k++) {
+		fprintf(out, " %6g", get_knob(p, k));
+	}
+	fprintf(out, "%s\n", is_default(p) ? "  (defaults)" : "");
+}
+
+// result indices faster first, the more accurate of equally fast sets first
+struct FasterOrder {
+	FasterOrder(const vector<TuneResult>& results, double bp_ms)
+	: results(results), bp_ms(bp_ms) {}
+	bool operator()(int a, int b) const {
+		double ta = results[a].frame_ms(bp_ms), tb = results[b].frame_ms(bp_ms);
+		if(ta != tb) {
+			return ta < tb;
+		}
+		return results[a].accuracy() > results[b].accuracy();
+	}
+	const vector<TuneResult>& results;
+	double bp_ms;
+};
+
+void print_pareto(const TuneCorpus& corpus, const vector<TuneParams>& sets,
+		const vector<TuneResult>& results, const char *csv_path) {
+	double bp_ms = corpus.backproject_ms();
+	vector<int> order;
+	for(size_t i=0; i<sets.size(); i++) {
+		order.push_back((int)i);
+	}
+	sort(order.begin(), order.end(), FasterOrder(results, bp_ms));
+
+	// walking from fastest, a set is on the front if it beats every faster one
+	vector<int> front;
+	double best = -1;
+	for(size_t i=0; i<order.size(); i++) {
+		double acc = results[order[i]].accuracy();
+		if(acc > best) {
+			front.push_back(order[i]);
+			best = acc;
+		}
+	}
+
+	printf("tune: Pareto front, %d of %d sets -- ms per frame (%.2f of it backprojection), "
+			"tip F1, hands found, false hands per frame\n", (int)front.size(),
+			(int)sets.size(), bp_ms);
+	printf("  %8s %8s %6s %7s ", "ms", "F1", "hands", "false");
+	for(int k=0; k<NUM_KNOBS; k++) {
+		printf(" %6s", knob_columns[k]);
+	}
+	printf("\n");
+	for(size_t i=0; i<front.size(); i++) {
+		print_row(stdout, sets[front[i]], results[front[i]], bp_ms, false);
+	}
+	// where the current defaults stand, if they were in the grid
+	for(size_t i=0; i<sets.size(); i++) {
+		if(is_default(sets[i]) && find(front.begin(), front.end(), (int)i) == front.end()) {
+			printf("  not on the front:\n");
+			print_row(stdout, sets[i], results[i], bp_ms, false);
+		}
+	}
+
+	if(csv_path) {
+		FILE *out = fopen(csv_path, "w");
+		if(!out) {
+			fprintf(stderr, "tune: can't open %s\n", csv_path);
+			return;
+		}
+		fprintf(out, "ms_per_frame,tip_f1,hand_recall,false_per_frame");
+		for(int k=0; k<NUM_KNOBS; k++) {
+			fprintf(out, ",%s", knob_names[k]);
+		}
+		fprintf(out, "\n");
+		for(size_t i=0; i<sets.size(); i++) {
+			print_row(out, sets[i], results[i], bp_ms, true);
+		}
+		fclose(out);
+		printf("tune: every set written to %s\n", csv_path);
+	}
+}
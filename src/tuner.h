@@ -0,0 +1,158 @@
+/*
+ * tuner.h
+ *
+ * Parameter sweep for the detector's knobs -- the threshold, open/close iterations,
+ * perimScale, the too small divisor, the depth and proximity ratios, the finger window,
+ * the hand shape check -- against frames with labelled fingertips (the way to see what
+ * the shape check does to recorded hands before turning it on), run with
+ *
+ * 	fingershooter --tune labels.txt calib_image x y w h [-j workers] [-g grid] [-c cache] [-o out.csv]
+ * 	fingershooter --tune synth:N [...]
+ *
+ * Labels are text, one hand per line, '#' starts a comment:
+ *
+ * 	file frame                              a labelled frame with no hands
+ * 	file frame cx cy scale x y [x y ...]    a hand -- palm center, height in pixels,
+ * 	                                        then its fingertips
+ *
+ * synth:N uses N synthetic scenes (synth_scene.h) instead, their truth as labels.
+ *
+ * The backprojection doesn't depend on any knob, so it's done once per corpus and kept
+ * in a cache file that is memory mapped -- a second sweep over the same frames and
+ * histogram doesn't decode a frame.  Parameter sets are grouped by the knobs the mask
+ * cleaning uses (threshold, close_itr, kernel_size); each frame is cleaned once per
+ * group and every set in the group runs the contour search on a copy.  Frames are
+ * spread over a TaskPool.
+ *
+ * The grid is "knob=v1,v2,...:knob=...", knobs as RuntimeHandConfig plus perim_scale,
+ * eg "threshold=10,15,20:depth_pct=20,25,30".  Out comes a table of the sets on the
+ * accuracy vs time Pareto front (nothing both faster and more accurate), and with -o
+ * every set as csv.
+ * Implementation in tuner.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef TUNER_H_
+#define TUNER_H_
+
+#include "cv.h"
+#include <vector>
+#include <string>
+
+#include "cv_handles.h"
+#include "hand_detector.h"
+#include "synth_scene.h"
+
+// what the start of a cache file holds, see tuner.cpp
+struct TuneCacheHeader;
+
+// one point of the grid
+struct TuneParams {
+	TuneParams() : perim_scale(6) {}
+
+	RuntimeHandConfig cfg;
+	// find_hands_and_shoot's perimScale
+	float perim_scale;
+};
+
+// what a set scored over the corpus
+struct TuneResult {
+	TuneResult() : clean_ms(0), find_ms(0), frames(0) {}
+
+	// tips matched / (matched + false + missed), ie tip F1 -- the accuracy axis
+	double accuracy() const;
+	// per frame, backprojection included -- the time axis
+	double frame_ms(double backproject_ms) const;
+
+	SynthScore score;
+	// totals over the frames
+	double clean_ms;
+	double find_ms;
+	long frames;
+};
+
+// "knob=v1,v2:knob=v3", false if a knob isn't known or a value doesn't parse
+// sets -- gets every combination, starting from the defaults
+bool parse_tune_grid(const char *spec, std::vector<TuneParams>& sets);
+
+// the grid --tune sweeps without -g
+extern const char *DEFAULT_TUNE_GRID;
+
+// frames with their labelled hands, and their backprojections once cached
+class TuneCorpus {
+public:
+	TuneCorpus();
+	~TuneCorpus();
+
+	// labelled frames from a labels file, false if it can't be read or a line
+	// doesn't parse (the line is printed)
+	bool load_labels(const char *path);
+	// n synthetic 640x480 scenes -- two hands of 3 to 5 fingers, clutter, a decoy and
+	// some noise -- their truth as labels
+	void add_synth(int n);
+
+	// backprojects every frame with hist (1D hue) into cache_path and maps it, or
+	// just maps it if it already holds these frames with this histogram
+	// false if the file can't be made or no frame could be read
+	bool map_cache(const char *cache_path, const Histogram& hist);
+
+	int size() const { return (int)frames.size(); }
+	CvSize frame_size() const { return size_; }
+	// frames that couldn't be read, or weren't the size of the first, have no mask
+	bool has_mask(int i) const;
+	// size_.width * size_.height bytes, read only
+	const uchar* mask(int i) const;
+	const std::vector<SynthHand>& truth(int i) const { return frames[i].truth; }
+	// mean per frame, from when the cache was built
+	double backproject_ms() const;
+
+	// for make_synth_hist
+	const SynthParams* synth_params() const { return synth ? &synth_base : NULL; }
+
+private:
+	struct Frame {
+		// empty for a synthetic scene
+		std::string file;
+		// frame number, or the synthetic scene's seed
+		int index;
+		std::vector<SynthHand> truth;
+	};
+
+	// hash of what the cache depends on
+	unsigned long long cache_key(const Histogram& hist) const;
+	// takes the mapping m of bytes, header and all
+	void attach(void *m, size_t bytes);
+	// size_ from the first frame, false if it can't be read
+	bool probe_size();
+	// backprojects every frame into the mapped file, ms gets the mean per frame
+	// returns the frames that got a mask
+	int fill_cache(uchar *valid_out, uchar *masks_out, const Histogram& hist, double *ms);
+
+	std::vector<Frame> frames;
+	bool synth;
+	SynthParams synth_base;
+
+	// the mapping
+	void *map;
+	size_t map_bytes;
+	CvSize size_;
+	const uchar *valid;
+	const uchar *masks;
+	const TuneCacheHeader *header;
+};
+
+// a hue histogram of the skin in the first synthetic scene, as createHueHist would
+// take from a selection in the palm
+Histogram make_synth_hist(const SynthParams& p);
+
+// runs every set over the corpus on a pool of num_workers (0 for one per core)
+// results -- one per set, same order
+void run_sweep(const TuneCorpus& corpus, const std::vector<TuneParams>& sets,
+		int num_workers, std::vector<TuneResult>& results);
+
+// prints the Pareto front and, if csv_path, writes every set to it
+void print_pareto(const TuneCorpus& corpus, const std::vector<TuneParams>& sets,
+		const std::vector<TuneResult>& results, const char *csv_path = NULL);
+
+#endif /* TUNER_H_ */
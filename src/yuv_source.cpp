@@ -0,0 +1,152 @@
+/*
+ * yuv_source.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#include "yuv_source.h"
+
+#include <cstring>
+
+bool parse_yuv_format(const char *name, YuvFormat *fmt) {
+	if(strcmp(name, "yuyv") == 0) {
+		*fmt = YUV_YUYV;
+	} else if(strcmp(name, "nv12") == 0) {
+		*fmt = YUV_NV12;
+	} else {
+		return false;
+	}
+	return true;
+}
+
+int yuv_frame_bytes(YuvFormat fmt, int width, int height) {
+	if(fmt == YUV_YUYV) {
+		return width * height * 2;
+	}
+	return width * height + (width / 2) * (height / 2) * 2;
+}
+
+static inline uchar clip(int v) {
+	return (uchar)(v < 0 ? 0 : v > 255 ? 255 : v);
+}
+
+void yuv_to_bgr(const YuvFrame &frame, IplImage *bgr) {
+	int w = frame.width;
+	for(int y=0; y<frame.height; y++) {
+		uchar *dst = (uchar *)(bgr->imageData + y * bgr->widthStep);
+		const uchar *luma, *chroma;
+		if(frame.fmt == YUV_YUYV) {
+			luma = frame.data + y * w * 2;
+			for(int x=0; x<w-1; x+=2, luma+=4, dst+=6) {
+				int d = luma[1] - 128, e = luma[3] - 128;
+				yuv_put_bgr(dst, 298 * (luma[0] - 16), d, e);
+				yuv_put_bgr(dst + 3, 298 * (luma[2] - 16), d, e);
+			}
+		} else {
+			luma = frame.data + y * w;
+			chroma = frame.data + w * frame.height + (y / 2) * (w / 2) * 2;
+			for(int x=0; x<w-1; x+=2, luma+=2, chroma+=2, dst+=6) {
+				int d = chroma[0] - 128, e = chroma[1] - 128;
+				yuv_put_bgr(dst, 298 * (luma[0] - 16), d, e);
+				yuv_put_bgr(dst + 3, 298 * (luma[1] - 16), d, e);
+			}
+		}
+	}
+}
+
+static inline int luma_of(const uchar *p) {
+	return ((66 * p[2] + 129 * p[1] + 25 * p[0] + 128) >> 8) + 16;
+}
+// from the sums of b, g, r over n pixels
+static inline int u_of(int b, int g, int r, int n) {
+	return (((-38 * r - 74 * g + 112 * b) / n + 128) >> 8) + 128;
+}
+static inline int v_of(int b, int g, int r, int n) {
+	return (((112 * r - 94 * g - 18 * b) / n + 128) >> 8) + 128;
+}
+
+void bgr_to_yuv(const IplImage *bgr, YuvFrame &frame) {
+	int w = frame.width;
+	if(frame.fmt == YUV_YUYV) {
+		for(int y=0; y<frame.height; y++) {
+			const uchar *src = (const uchar *)(bgr->imageData + y * bgr->widthStep);
+			uchar *dst = frame.data + y * w * 2;
+			for(int x=0; x<w-1; x+=2, src+=6, dst+=4) {
+				int b = src[0] + src[3], g = src[1] + src[4], r = src[2] + src[5];
+				dst[0] = luma_of(src);
+				dst[1] = clip(u_of(b, g, r, 2));
+				dst[2] = luma_of(src + 3);
+				dst[3] = clip(v_of(b, g, r, 2));
+			}
+		}
+		return;
+	}
+	uchar *chroma = frame.data + w * frame.height;
+	for(int y=0; y<frame.height-1; y+=2) {
+		const uchar *src0 = (const uchar *)(bgr->imageData + y * bgr->widthStep);
+		const uchar *src1 = src0 + bgr->widthStep;
+		uchar *luma0 = frame.data + y * w;
+		uchar *luma1 = luma0 + w;
+		for(int x=0; x<w-1; x+=2, src0+=6, src1+=6, chroma+=2) {
+			luma0[x] = luma_of(src0);
+			luma0[x+1] = luma_of(src0 + 3);
+			luma1[x] = luma_of(src1);
+			luma1[x+1] = luma_of(src1 + 3);
+			int b = src0[0] + src0[3] + src1[0] + src1[3];
+			int g = src0[1] + src0[4] + src1[1] + src1[4];
+			int r = src0[2] + src0[5] + src1[2] + src1[5];
+			chroma[0] = clip(u_of(b, g, r, 4));
+			chroma[1] = clip(v_of(b, g, r, 4));
+		}
+	}
+}
+
+YuvFileSource::YuvFileSource()
+: file(NULL), frame_bytes(0), frames(0)
+{
+	current.fmt = YUV_YUYV;
+	current.width = current.height = 0;
+	current.data = NULL;
+}
+
+YuvFileSource::~YuvFileSource() {
+	close();
+}
+
+bool YuvFileSource::open(const char *path, YuvFormat fmt, int width, int height) {
+	close();
+	// both formats share chroma between pixel pairs, nv12 between row pairs too
+	if(width <= 0 || height <= 0 || width % 2 || (fmt == YUV_NV12 && height % 2)) {
+		printf("YuvFileSource: bad frame size %dx%d\n", width, height);
+		return false;
+	}
+	file = strcmp(path, "-") == 0 ? stdin : fopen(path, "rb");
+	if(!file) {
+		printf("YuvFileSource: can't open %s\n", path);
+		return false;
+	}
+	current.fmt = fmt;
+	current.width = width;
+	current.height = height;
+	frame_bytes = yuv_frame_bytes(fmt, width, height);
+	current.data = new uchar[frame_bytes];
+	frames = 0;
+	return true;
+}
+
+void YuvFileSource::close() {
+	if(file && file != stdin) {
+		fclose(file);
+	}
+	file = NULL;
+	delete [] current.data;
+	current.data = NULL;
+}
+
+bool YuvFileSource::read() {
+	if(!file || fread(current.data, 1, frame_bytes, file) != (size_t)frame_bytes) {
+		return false;
+	}
+	frames++;
+	return true;
+}
@@ -0,0 +1,82 @@
+/*
+ * yuv_source.h
+ *
+ * Raw YUV frames the way cameras deliver them, so segmentation can work straight
+ * from chroma (see UvSkinLut in skin_lut.h) and BGR only gets made for display and
+ * recording.
+ *
+ * 	YUYV  -- packed 4:2:2, Y0 U Y1 V per pair of pixels
+ * 	NV12  -- Y plane, then a half width half height plane of interleaved U V
+ *
+ * YuvFileSource reads headerless raw files of back to back frames, eg as written by
+ * "ffmpeg -i in.avi -f rawvideo -pix_fmt yuyv422 out.yuv" or
+ * "v4l2-ctl --stream-mmap --stream-to=out.yuv".  A path of "-" reads stdin, so a
+ * camera can be piped in live.
+ * Conversions are BT.601 limited range, the usual camera YUV.
+ * Implementation in yuv_source.cpp
+ *
+ *  Created on: Oct 19, 2026
+ */
+
+#ifndef YUV_SOURCE_H_
+#define YUV_SOURCE_H_
+
+#include "cv.h"
+#include <cstdio>
+
+enum YuvFormat { YUV_YUYV, YUV_NV12 };
+
+// "yuyv" or "nv12", returns false if it's neither
+bool parse_yuv_format(const char *name, YuvFormat *fmt);
+
+// bytes in one width x height frame of fmt
+int yuv_frame_bytes(YuvFormat fmt, int width, int height);
+
+// one frame, data not owned
+struct YuvFrame {
+	YuvFormat fmt;
+	int width, height;
+	uchar *data;
+};
+
+// one pixel into p[0..2] as b, g, r
+// c = 298 * (y - 16), d = u - 128, e = v - 128, so pixel pairs can share d and e
+inline void yuv_put_bgr(uchar *p, int c, int d, int e) {
+	int b = (c + 516 * d + 128) >> 8;
+	int g = (c - 100 * d - 208 * e + 128) >> 8;
+	int r = (c + 409 * e + 128) >> 8;
+	p[0] = (uchar)(b < 0 ? 0 : b > 255 ? 255 : b);
+	p[1] = (uchar)(g < 0 ? 0 : g > 255 ? 255 : g);
+	p[2] = (uchar)(r < 0 ? 0 : r > 255 ? 255 : r);
+}
+
+// bgr -- 8 bit 3 channel, frame size
+void yuv_to_bgr(const YuvFrame &frame, IplImage *bgr);
+// the other way, for making test files -- width must be even, and height too for NV12
+void bgr_to_yuv(const IplImage *bgr, YuvFrame &frame);
+
+class YuvFileSource {
+public:
+	YuvFileSource();
+	~YuvFileSource();
+
+	// path -- raw file, "-" for stdin
+	// returns false if the file can't be opened or the size doesn't suit fmt
+	bool open(const char *path, YuvFormat fmt, int width, int height);
+	void close();
+
+	// reads the next frame into frame(), false at the end of the file
+	bool read();
+
+	const YuvFrame& frame() const { return current; }
+	CvSize size() const { return cvSize(current.width, current.height); }
+	long frames_read() const { return frames; }
+
+private:
+	FILE *file;
+	YuvFrame current;
+	int frame_bytes;
+	long frames;
+};
+
+#endif /* YUV_SOURCE_H_ */